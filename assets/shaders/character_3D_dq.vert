@@ -0,0 +1,64 @@
+#version 400 core
+
+const int joint_count = 150;
+const int weight_count = 4;
+
+in vec3 pos;
+in vec3 normal;
+in vec3 vertex_color;
+in vec4 weights;
+in uvec4 joint_ids;
+in vec2 uv;
+
+out vec3 pos_f;
+out vec3 normal_f;
+out vec2 uv_f;
+out vec3 vertex_color_f;
+out vec3 to_camera;
+
+uniform mat4 camera;
+uniform vec4 joint_dqs[2 * joint_count];
+uniform vec3 cam_pos;
+
+uniform mat4 transform;
+
+void main(void){
+
+    // Blend the dual quaternions, each is flipped to the side of the first so the blend takes the short path
+    vec4 real = vec4(0.0);
+    vec4 dual = vec4(0.0);
+    vec4 first = joint_dqs[joint_ids[0] * 2];
+
+    for(int i = 0; i < weight_count; i++){
+        if(joint_ids[i] != 0){
+            vec4 r = joint_dqs[joint_ids[i] * 2];
+            float w = dot(r, first) < 0.0 ? -weights[i] : weights[i];
+            real += w * r;
+            dual += w * joint_dqs[joint_ids[i] * 2 + 1];
+        }
+    }
+
+    float len = length(real);
+    if(len > 0.0){
+        real /= len;
+        dual /= len;
+    }
+    else{
+        real = vec4(0, 0, 0, 1);
+    }
+
+    // Rotate by the real part, then translate by twice the dual part times the conjugate of the real part
+    vec3 skinned_pos = pos + 2.0 * cross(real.xyz, cross(real.xyz, pos) + real.w * pos);
+    skinned_pos += 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+    vec3 skinned_normal = normal + 2.0 * cross(real.xyz, cross(real.xyz, normal) + real.w * normal);
+
+    // 3D Transformations, the joints are relative to the root so the root transform is applied last
+    pos_f = (transform * vec4(skinned_pos, 1)).xyz;
+    gl_Position = camera * vec4(pos_f,1);
+    normal_f = mat3(transform) * skinned_normal;
+    vertex_color_f = vertex_color;
+    to_camera = pos_f - cam_pos;
+
+    uv_f = vec2(uv.x,1-uv.y);
+
+}
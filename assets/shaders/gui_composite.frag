@@ -0,0 +1,11 @@
+#version 430 core
+
+in vec2 uv_f;
+out vec4 color_out;
+
+// The cached GUI, colors are already premultiplied by alpha
+layout(binding = 0) uniform sampler2D cache;
+
+void main(void){
+    color_out = texture(cache, uv_f);
+}
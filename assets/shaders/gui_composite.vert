@@ -0,0 +1,11 @@
+#version 430 core
+
+// Corners of the screen in clip space, the cache texture covers all of it
+layout(location = 0) in vec2 pos;
+
+out vec2 uv_f;
+
+void main(void){
+    gl_Position = vec4(pos, 0.0, 1.0);
+    uv_f = ( pos + 1 ) / 2;
+}
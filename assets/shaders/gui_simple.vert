@@ -1,19 +1,25 @@
 #version 430 core
 
-in vec2 pos;
-in vec2 uv;
+// Attribute locations match the Attribute enum, params and color2 use the normal and weights slots
+layout(location = 0) in vec2 pos;
+layout(location = 1) in vec4 params;  // width, height and bevel of the element
+layout(location = 2) in vec2 uv;
+layout(location = 3) in vec4 vertex_color;
+layout(location = 4) in vec4 vertex_color2;
 
 out vec2 uv_f;
 out vec2 pos_f;
+out vec4 col_f;
+out vec4 col2_f;
+out vec3 params_f;
 
 uniform mat4 camera;    // Orthographic projection of screen
-uniform vec4 transform; // position and scale
-layout(binding = 0) uniform sampler2D texture0;
 
 void main(void){
-    gl_Position = camera * vec4(transform.zw*pos.xy+transform.xy, -0.1, 1.0);
+    gl_Position = camera * vec4(pos.xy, -0.1, 1.0);
     uv_f = uv;
     pos_f = ( gl_Position.xy + 1 ) / 2; // Convert so position can be used as UV for framebuffer
+    col_f = vertex_color;
+    col2_f = vertex_color2;
+    params_f = params.xyz;
 }
-
-
@@ -4,6 +4,7 @@ in vec2 uv_f;
 in vec3 pos_f;
 
 uniform vec3 tex_id;
+uniform vec4 tex_rect[2];
 
 layout(binding = 0) uniform sampler2DArray texarray;
 // layout(binding = 0) uniform sampler2D tex;
@@ -13,8 +14,9 @@ out vec4 color_out;
 void main(void){
 
 //        color_out = mix( texture(tex, vec2(uv_f.x, uv_f.y)), texture(tex, vec2(uv_f.x, uv_f.y)), tex_id.z);
-    vec4 from = texture(texarray, vec3(uv_f.x, uv_f.y, tex_id.x));
-    vec4 to = texture(texarray, vec3(uv_f.x, uv_f.y, tex_id.y));
+    // Map the uvs into each image's rect within the atlas layer
+    vec4 from = texture(texarray, vec3(mix(tex_rect[0].xy, tex_rect[0].zw, uv_f), tex_id.x));
+    vec4 to = texture(texarray, vec3(mix(tex_rect[1].xy, tex_rect[1].zw, uv_f), tex_id.y));
     to.a *= tex_id.z;
     from.a *= 1-tex_id.z;
     float alpha = from.a + to.a;
@@ -1,28 +1,61 @@
 #version 420 core
 
-in vec3 uv_f;
+in vec2 uv_f;
 in vec2 pos_f;
 in vec4 col_f;
 in float char_num;
+in float revealed;
 
 out vec4 color_out;
-uniform vec3 object_color;
-uniform vec3 object_color2;
-uniform uint factor;
 
 layout(binding = 0) uniform sampler2D texture0;
 
+uniform float factor;           // distance field spread in texels, 0 for bitmap fonts
+uniform vec4 object_color;      // outline color
+uniform vec4 object_color2;     // shadow color, alpha is its opacity
+uniform vec4 text_effects;      // outline width, shadow offset x and y, shadow softness, in texels
+
+// Signed distance in texels from the glyph edge, negative inside
+float edge_distance(vec2 uv){
+    return (0.5 - texture(texture0, uv).x) * 2.0 * factor;
+}
+
 void main(void){
 
-    float v = texture(texture0, uv_f.xy).x;
-    if(v < 0.5 || char_num > factor){
+    if(char_num > revealed){
         discard;
     }
 
-    // mix color using alpha
-    color_out.rgb = mix(object_color, col_f.rgb, col_f.a);
+    // Bitmap glyphs are alpha tested
+    if(factor <= 0){
+        if(texture(texture0, uv_f).x < 0.5){
+            discard;
+        }
+
+        // The color is mixed and selection applied when batched
+        color_out.rgb = col_f.rgb;
+        color_out.a = 1;
+        return;
+    }
+
+    // Texels per pixel keeps the edge one pixel wide at any size
+    float d = edge_distance(uv_f);
+    float w = max(fwidth(d), 1e-4);
+    float fill = clamp(0.5 - d / w, 0.0, 1.0);
+    float outline = clamp(0.5 - (d - text_effects.x) / w, 0.0, 1.0);
+
+    vec2 texel = 1.0 / vec2(textureSize(texture0, 0));
+    float shadow_d = edge_distance(uv_f - text_effects.yz * texel);
+    float shadow = clamp(0.5 - shadow_d / max(text_effects.w, w), 0.0, 1.0) * object_color2.a;
+
+    // Fill over outline over shadow, premultiplied then divided for the blend function
+    vec4 c = vec4(object_color2.rgb, 1) * shadow;
+    c = vec4(object_color.rgb, 1) * outline + c * (1.0 - outline);
+    c = vec4(col_f.rgb, 1) * fill + c * (1.0 - fill);
+
+    if(c.a <= 0.0){
+        discard;
+    }
 
-    // If selected (z!=0) then override color
-    color_out.rgb = uv_f.z==0?color_out.rgb:object_color2 ;
-    color_out.a = 1;
+    color_out = vec4(c.rgb / c.a, c.a);
 }
@@ -1,21 +1,24 @@
 #version 420 core
 
-in vec2 pos;
-in vec3 uv;
-in vec4 vertex_color;
+// Attribute locations match the Attribute enum, params uses the normal slot
+layout(location = 0) in vec2 pos;
+layout(location = 1) in vec4 params;  // reveal index of the glyph and the number of glyphs revealed
+layout(location = 2) in vec2 uv;
+layout(location = 3) in vec4 vertex_color;
 
-out vec3 uv_f;
+out vec2 uv_f;
 out vec2 pos_f;
 out vec4 col_f;
 out float char_num;
+out float revealed;
 
 uniform mat4 camera;
-uniform vec3 transform;
 
 void main(void){
-    gl_Position = camera * vec4( transform.z*pos.xy+transform.xy, -0.1, 1.0);
+    gl_Position = camera * vec4( pos.xy, -0.1, 1.0);
     uv_f = uv;
     pos_f = pos;
     col_f = vertex_color;
-    char_num = gl_VertexID/4;
+    char_num = params.x;
+    revealed = params.y;
 }
@@ -1,6 +1,7 @@
 #include "VNAssetManager.h"
 #include <Audio.h>
 #include <queue>
+#include <cfloat>
 
 vec3 x_axis = {1, 0, 0};
 vec3 y_axis = {0, 1, 0};
@@ -16,6 +17,7 @@ namespace VNAssets {
     KeyframePos key_focus;
     vec3 focus = GLM_VEC3_ZERO_INIT;
     Scene *active_scene = nullptr;
+    TextureAtlas atlas;
 
 
     std::vector<ShaderContainer> shaders;
@@ -46,6 +48,7 @@ namespace VNAssets {
         for(ModelContainer &m:models){
             m.vao->free();
         }
+        atlas.free();
     }
 
     void scene_create( const std::string &name ) {
@@ -234,7 +237,7 @@ namespace VNAssets {
             return false;
         }
 
-        ArmatureInfo *info = objects[p_id].armature.get_info();
+        const ArmatureInfo *info = objects[p_id].armature.get_info();
 
         // No armature to get joint
         if(!info)
@@ -311,12 +314,52 @@ void Scene::update(float t){
         VNAssets::objects[o].updated = false;
     }
 
+    // Softbody chains of every armature are stepped together once all the armatures are posed
+    for(uint32_t o: objects ){
+        VNAssets::objects[o].armature.batch_softbodies = true;
+    }
+
     for(uint32_t o: objects ){
 
         // Update the object
         VNAssets::objects[o].update(t);
 
     }
+
+    // Objects attached to a softbody joint follow the joint as it was before the chains were stepped
+    softbodies.clear();
+
+    for(uint32_t o: objects ){
+        ObjectInstance &obj = VNAssets::objects[o];
+        if( obj.enabled && !obj.armature.empty() && obj.armature.is_palette_updated() )
+            softbodies.add( obj.armature );
+    }
+
+    if( softbodies.get_chain_count() ){
+        softbodies.solve();
+
+        for(uint32_t o: objects ){
+            ObjectInstance &obj = VNAssets::objects[o];
+            if( obj.enabled )
+                obj.armature.update_softbodies();
+        }
+    }
+
+    // Count armatures that kept their palette, parents may have updated through their children so this is done after
+    palettes_updated = 0;
+    palettes_skipped = 0;
+
+    for(uint32_t o: objects ){
+        ObjectInstance &obj = VNAssets::objects[o];
+
+        if( !obj.enabled || obj.armature.empty() )
+            continue;
+
+        if( obj.armature.is_palette_updated() )
+            ++palettes_updated;
+        else
+            ++palettes_skipped;
+    }
 }
 
 void Scene::draw(){
@@ -328,13 +371,51 @@ void Scene::draw(){
 
     vec3 dim = {1, 1, 1};
 
-    glDisable(GL_DEPTH_TEST);
+    // Cull objects outside of the view before any state changes, the set order is kept
+    vec4 *planes = VNAssets::view.get_frustum_planes( 1 );
+    visible.clear();
+    objects_culled = 0;
+    palette_uploads_skipped = 0;
+
     for(uint32_t o : objects){
         ObjectInstance &obj = VNAssets::objects[o];
 
         if(!obj.enabled || !obj.shader || !obj.model)
             continue;
 
+        ModelContainer &mc = VNAssets::models[obj.model];
+
+        // Add changed image lists to the atlas, this must be done on the thread containing the GL Context
+        if( mc.image_changed ) {
+            mc.image_ids.clear();
+            for( const std::string &name : mc.image_names ) {
+                mc.image_ids.push_back( VNAssets::atlas.add( name ) );
+            }
+            mc.image_changed = false;
+        }
+
+        obj.update_bounds( mc.mesh );
+
+        if( !obj.in_frustum( planes ) ) {
+            ++objects_culled;
+            continue;
+        }
+
+        visible.push_back( o );
+    }
+
+    objects_drawn = visible.size();
+
+    // Rebuild the atlas once for all new images, then bind it for the whole scene
+    if( VNAssets::atlas.is_changed() )
+        VNAssets::atlas.build();
+
+    VNAssets::atlas.bind( 0 );
+
+    glDisable(GL_DEPTH_TEST);
+    for(uint32_t o : visible){
+        ObjectInstance &obj = VNAssets::objects[o];
+
         // Change the shader
         if(obj.shader != shader){
             shader = obj.shader;
@@ -342,6 +423,7 @@ void Scene::draw(){
             if( sc.needs_compiled ) {
                 sc.shader->load( sc.filename );
                 sc.needs_compiled = false;
+                sc.palette_version = 0;
             }
 
             // Skip drawing with this shader
@@ -388,48 +470,70 @@ void Scene::draw(){
                 mc.mesh.updated = false;
             }
 
-            if( mc.image_changed ) {
-                if( !mc.image_names.empty() ){
-                    mc.image_array->load_file_list( mc.image_names, GL_LINEAR );
-                }
-                mc.image_changed = false;
-            }
-
-            if( mc.image_array->is_allocated() ) {
-                mc.image_array->bind( 0 );
-
-                if( mc.image_array->get_ratio() <= 1 ) {
-                    dim[1] = mc.image_array->get_ratio();
-                }
-                else {
-                    dim[0] = 1 / mc.image_array->get_ratio();
-                }
-            }
-            else{
-                dim[0] = 1;
-                dim[1] = 1;
-            }
-
             // Bind the VAO
             mc.vao->bind();
         }
 
         // Draw the object
 
-        // Load the armature if present
-        if( !obj.armature.empty() )
-            Shader::uniformMat4fArray( UNIFORM_JOINTS, ( ( mat4 * )obj.armature.transform_buffer.get() ), obj.armature.joints.size() );
+        // Load the armature if present, uniforms stay in the shader so an unchanged palette from the last object is kept
+        if( !obj.armature.empty() ) {
+            ShaderContainer &sc = VNAssets::shaders[shader];
+
+            if( sc.palette_version == obj.armature.get_palette_version() )
+                ++palette_uploads_skipped;
+
+            // Dual quaternion shaders take half the data, the root transform is applied separately
+            else if( Shader::hasUniform( UNIFORM_JOINT_DQS ) ) {
+                Shader::uniformVec4fArray( UNIFORM_JOINT_DQS, (vec4 *)obj.armature.get_dual_quaternions(), obj.armature.joints.size() * 2 );
+                sc.palette_version = obj.armature.get_palette_version();
+            }
+            else {
+                Shader::uniformMat4fArray( UNIFORM_JOINTS, obj.armature.transform_buffer.get(), obj.armature.joints.size() );
+                sc.palette_version = obj.armature.get_palette_version();
+            }
+        }
 
         // If there is not an armature present, do not load the full uniform, only load the root
-        else
+        else {
             Shader::uniformMat4f( UNIFORM_JOINTS, obj.transform );
+            VNAssets::shaders[shader].palette_version = 0;
+        }
+
+
+        // Select the images from the atlas, the texture ids become layers and the uvs are mapped to each image's rect
+        ModelContainer &mc = VNAssets::models[model];
+        vec3 tex_id = {0, 0, obj.tex_id[2]};
+        vec4 tex_rect[2] = {{0, 0, 1, 1}, {0, 0, 1, 1}};
+        dim[0] = 1;
+        dim[1] = 1;
+
+        if( !mc.image_ids.empty() ) {
+            const AtlasEntry *entry = nullptr;
 
+            for( uint8_t i = 0; i < 2; ++i ) {
+                uint32_t image = std::min( (uint32_t)std::max( obj.tex_id[i], 0.0f ), (uint32_t)mc.image_ids.size() - 1 );
+                entry = &VNAssets::atlas.get_entry( mc.image_ids[image] );
+                tex_id[i] = entry->layer;
+                glm_vec4_copy( (float *)entry->rect, tex_rect[i] );
+            }
+
+            // Scale to the aspect ratio of the image being shown, the last entry selected
+            float ratio = entry->width ? (float)entry->height / entry->width : 1;
+
+            if( ratio <= 1 )
+                dim[1] = ratio;
+            else
+                dim[0] = 1 / ratio;
+        }
 
-        Shader:: uniformVec3f(UNIFORM_TEXID, obj.tex_id);
-        Shader::uniformMat4f( UNIFORM_TRANSFORM, obj.transform );
+        Shader::uniformVec3f( UNIFORM_TEXID, tex_id );
+        Shader::uniformVec4fArray( UNIFORM_TEXRECT, tex_rect, 2 );
+        // Armatures include the constraint scale in the root, dual quaternion shaders apply it after skinning
+        Shader::uniformMat4f( UNIFORM_TRANSFORM, obj.armature.empty() ? obj.transform : obj.armature.get_root().tr );
         dim[2] = obj.scale;
         Shader::uniformVec3f( UNIFORM_FACTOR, dim );
-        glDrawElements( GL_TRIANGLES, VNAssets::models[model].vao->get_index_count(), GL_UNSIGNED_INT, 0 );
+        glDrawElements( GL_TRIANGLES, VNAssets::models[model].vao->get_index_count(), VNAssets::models[model].vao->get_index_type(), 0 );
 
     }
 }
@@ -461,6 +565,79 @@ void Scene::remove_object(uint32_t id){
 }
 
 
+/*
+ * Update the world bounds from the transform.
+ * Rigid objects use a sphere around the transform origin that contains the mesh at any rotation, shaders may billboard.
+ * Skinned objects use the union of each joint's box transformed by the joint's palette matrix.
+ * Models without a mesh use the default quad.
+ */
+void ObjectInstance::update_bounds( Mesh &mesh ) {
+    const MeshBounds &mb = mesh.get_bounds();
+
+    // Largest scale of the transform axes
+    float scale_sqr = glm_vec3_norm2( transform[0] );
+    scale_sqr = glm_max( scale_sqr, glm_vec3_norm2( transform[1] ) );
+    scale_sqr = glm_max( scale_sqr, glm_vec3_norm2( transform[2] ) );
+
+    glm_vec3_copy( transform[3], bounds_sphere );
+
+    if( !mb.valid ) {
+        bounds_skinned = false;
+
+        // Unknown position format, never cull
+        if( mesh.get_vertex_count() > 0 )
+            bounds_sphere[3] = FLT_MAX;
+        else
+            bounds_sphere[3] = sqrtf( 0.5f * scale_sqr );
+        return;
+    }
+
+    bounds_sphere[3] = ( glm_vec3_norm( (float *)mb.sphere ) + mb.sphere[3] ) * sqrtf( scale_sqr );
+
+    bounds_skinned = !armature.empty() && !mb.joints.empty();
+
+    if( !bounds_skinned )
+        return;
+
+    mat4 *palette = ( mat4 * )armature.transform_buffer.get();
+    vec3 box[2];
+    bool first = true;
+
+    for( uint32_t j = 0; j < mb.joints.size() && j < armature.joints.size(); ++j ) {
+        if( !mb.joints[j].used )
+            continue;
+
+        glm_aabb_transform( (vec3 *)mb.joints[j].box, palette[j], box );
+
+        if( first ) {
+            glm_vec3_copy( box[0], bounds_box[0] );
+            glm_vec3_copy( box[1], bounds_box[1] );
+            first = false;
+        }
+        else {
+            glm_vec3_minv( bounds_box[0], box[0], bounds_box[0] );
+            glm_vec3_maxv( bounds_box[1], box[1], bounds_box[1] );
+        }
+    }
+
+    // No joints could be transformed, fall back to the sphere
+    if( first )
+        bounds_skinned = false;
+}
+
+// Test the world bounds against the frustum planes, planes face inward
+bool ObjectInstance::in_frustum( vec4 *planes ) {
+    if( bounds_skinned )
+        return glm_aabb_frustum( bounds_box, planes );
+
+    for( uint8_t i = 0; i < 6; ++i ) {
+        if( glm_vec3_dot( planes[i], bounds_sphere ) + planes[i][3] < -bounds_sphere[3] )
+            return false;
+    }
+
+    return true;
+}
+
 void ObjectInstance::update( float t ) {
 
     // Update parents
@@ -7,7 +7,9 @@
 #include "VAO.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "TextureAtlas.h"
 #include "Armature.h"
+#include "SoftbodySystem.h"
 #include "View.h"
 #include <memory>
 
@@ -124,20 +126,28 @@ struct ObjectInstance {
     KeyframeFloat key_scale;
     KeyframeFloat key_texture_mix;
 
+    // World bounds, the sphere is centered at the transform origin so it holds for billboards
+    vec4 bounds_sphere = GLM_VEC4_ZERO_INIT;
+    vec3 bounds_box[2] = {GLM_VEC3_ZERO_INIT, GLM_VEC3_ZERO_INIT};
+    bool bounds_skinned = false;
+
     void update(float t);
+    void update_bounds(Mesh &mesh);
+    bool in_frustum(vec4 *planes);
 };
 
 struct ModelContainer {
     Mesh mesh;
     std::shared_ptr<VAO> vao;
-    std::shared_ptr<TextureArray> image_array;
     std::vector<std::string> image_names;
 
+    // Ids of the images in the shared atlas, set when the images change
+    std::vector<uint32_t> image_ids;
+
     bool image_changed = false;
 
     ModelContainer(){
         vao = std::shared_ptr<VAO>(new VAO());
-        image_array = std::shared_ptr<TextureArray>(new TextureArray());
 
         // Load a default model (a simple square, good for images)
         float pos_vals[] = {-.5,-.5, .5,-.5, .5,.5, -.5,.5};
@@ -158,6 +168,9 @@ struct ShaderContainer {
     bool cull = true;
     bool depth_test = true;
 
+    // Palette version of the armature last loaded into the shader's joint uniforms, 0 if none
+    uint32_t palette_version = 0;
+
     ShaderContainer(){
         shader = std::shared_ptr<Shader>(new Shader());
     }
@@ -171,6 +184,19 @@ struct Scene {
 
     void add_object( uint32_t id );
     void remove_object( uint32_t id);
+    // Objects that passed culling in the last draw, kept to avoid reallocating
+    std::vector<uint32_t> visible;
+    uint32_t objects_drawn = 0;
+    uint32_t objects_culled = 0;
+
+    // Armatures that recomputed or kept their palette in the last update, and palettes not uploaded in the last draw
+    uint32_t palettes_updated = 0;
+    uint32_t palettes_skipped = 0;
+    uint32_t palette_uploads_skipped = 0;
+
+    // Steps the softbody chains of every armature in the scene together
+    SoftbodySystem softbodies;
+
     void update( float t );
     void draw();
 };
@@ -189,6 +215,9 @@ namespace VNAssets {
     extern vec3 focus;
     extern Scene *active_scene;
 
+    // Every model's images are packed into one atlas so scenes bind a single texture
+    extern TextureAtlas atlas;
+
 
     ShaderContainer *get_shader( const std::string& name );
     ShaderContainer *get_shader( uint32_t id );
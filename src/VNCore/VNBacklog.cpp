@@ -0,0 +1,148 @@
+#include "VNBacklog.h"
+#include <algorithm>
+
+namespace VNI {
+    VNBacklog backlog;
+};
+
+uint32_t VNBacklog::intern( const std::string &s ) {
+    if( s.empty() )
+        return NONE;
+
+    auto found = intern_ids.find( s );
+    if( found != intern_ids.end() )
+        return found->second;
+
+    interned.push_back( s );
+    intern_ids[s] = interned.size() - 1;
+    return interned.size() - 1;
+}
+
+VNBacklog::Entry &VNBacklog::at( uint32_t index ) {
+    return ring[( oldest + index ) % ring.size()];
+}
+
+const VNBacklog::Entry &VNBacklog::at( uint32_t index ) const {
+    return ring[( oldest + index ) % ring.size()];
+}
+
+/*
+ * The text of dropped entries stays in the buffer until it is more than half of it,
+ * then it is erased at once so dropping costs constant time on average.
+ */
+void VNBacklog::drop_oldest() {
+    if( count == 0 )
+        return;
+
+    oldest = ( oldest + 1 ) % ring.size();
+    --count;
+    ++dropped;
+
+    uint64_t live_start = count ? at( 0 ).text_position : text_base + text.size();
+    uint64_t dead = live_start - text_base;
+
+    if( dead > text.size() / 2 ) {
+        text.erase( 0, dead );
+        text_base = live_start;
+    }
+}
+
+void VNBacklog::add( const std::string &speaker, const std::string &line, const std::string &voice, const std::string &file, int32_t operation ) {
+    if( max_entries == 0 )
+        return;
+
+    // At the limit the oldest entry is replaced
+    while( count >= max_entries )
+        drop_oldest();
+
+    Entry e = {text_base + text.size(), ( uint32_t )line.size(), intern( speaker ), intern( voice ), intern( file ), operation};
+    text.append( line );
+
+    if( count < ring.size() ) {
+        at( count ) = e;
+    }
+    else {
+        // Below the limit the ring grows, its entries are put in order first
+        std::rotate( ring.begin(), ring.begin() + oldest, ring.end() );
+        oldest = 0;
+
+        // Capacity doubles but stops at the limit
+        if( ring.size() == ring.capacity() )
+            ring.reserve( std::min<size_t>( std::max<size_t>( ring.size() * 2, 64 ), max_entries ) );
+        ring.push_back( e );
+    }
+
+    ++count;
+
+    while( count > 1 && text.size() - ( at( 0 ).text_position - text_base ) > max_text_bytes )
+        drop_oldest();
+}
+
+void VNBacklog::append( const std::string &line ) {
+    if( count == 0 )
+        return;
+
+    Entry &e = at( count - 1 );
+    text.append( line );
+    e.text_length += line.size();
+    ++edits;
+
+    while( count > 1 && text.size() - ( at( 0 ).text_position - text_base ) > max_text_bytes )
+        drop_oldest();
+}
+
+void VNBacklog::truncate( uint32_t keep ) {
+    if( keep >= count )
+        return;
+
+    count = keep;
+    text.resize( count ? at( count - 1 ).text_position + at( count - 1 ).text_length - text_base : 0 );
+    if( count == 0 )
+        text_base = 0, oldest = 0;
+    ++edits;
+}
+
+void VNBacklog::clear() {
+    dropped += count;
+    ring.clear();
+    text.clear();
+    text_base = 0;
+    oldest = count = 0;
+}
+
+std::string_view VNBacklog::get_text( uint32_t index ) const {
+    if( index >= count )
+        return {};
+
+    const Entry &e = at( index );
+    return std::string_view( text ).substr( e.text_position - text_base, e.text_length );
+}
+
+const std::string &VNBacklog::get_speaker( uint32_t index ) const {
+    static const std::string empty;
+    return index < count && at( index ).speaker != NONE ? interned[at( index ).speaker] : empty;
+}
+
+const std::string &VNBacklog::get_voice( uint32_t index ) const {
+    static const std::string empty;
+    return index < count && at( index ).voice != NONE ? interned[at( index ).voice] : empty;
+}
+
+const std::string &VNBacklog::get_file( uint32_t index ) const {
+    static const std::string empty;
+    return index < count && at( index ).file != NONE ? interned[at( index ).file] : empty;
+}
+
+int32_t VNBacklog::get_line( uint32_t index ) const {
+    return index < count ? at( index ).line : -1;
+}
+
+uint64_t VNBacklog::get_memory_size() const {
+    uint64_t bytes = ring.capacity() * sizeof( Entry ) + text.capacity();
+
+    // Interned strings are held by the list and as keys of the map
+    for( const std::string &s : interned )
+        bytes += 2 * ( sizeof( std::string ) + s.capacity() ) + sizeof( uint32_t );
+
+    return bytes;
+}
@@ -0,0 +1,79 @@
+#ifndef VNBACKLOG_H
+#define VNBACKLOG_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <inttypes.h>
+
+/*
+ * Every line spoken through say, with its speaker, voice clip and the script position it was said at.
+ * Entries are kept in a ring, once either limit is reached the oldest entries are dropped.
+ * Line text is appended to one buffer, speakers, voices and files are interned since few distinct ones repeat.
+ * Entries are numbered from the oldest kept, 0, to the newest, size() - 1.
+ */
+class VNBacklog {
+        struct Entry {
+            uint64_t text_position;     // Position of the text in all text ever written
+            uint32_t text_length;
+            uint32_t speaker;           // Interned strings, NONE when absent
+            uint32_t voice;
+            uint32_t file;
+            int32_t line;               // Operation the line was said at
+        };
+
+        std::vector<Entry> ring;
+        uint32_t oldest = 0, count = 0;
+
+        // Text of the kept entries, text_base is the position of its first character
+        std::string text;
+        uint64_t text_base = 0;
+
+        std::vector<std::string> interned;
+        std::unordered_map<std::string, uint32_t> intern_ids;
+
+        uint64_t dropped = 0, edits = 0;
+
+        uint32_t intern( const std::string &s );
+        Entry &at( uint32_t index );
+        const Entry &at( uint32_t index ) const;
+        void drop_oldest();
+
+    public:
+        static const uint32_t NONE = UINT32_MAX;
+
+        // Limits of the kept entries and the bytes of their text
+        uint32_t max_entries = 10000;
+        uint32_t max_text_bytes = 1 << 20;
+
+        // Records a line said by a speaker, empty when narrated
+        void add( const std::string &speaker, const std::string &line, const std::string &voice, const std::string &file, int32_t operation );
+
+        // Adds text to the newest line, for text continued after a wait
+        void append( const std::string &line );
+
+        // Removes the newest entries, keeping count entries
+        void truncate( uint32_t count );
+        void clear();
+
+        inline uint32_t size() const {return count;}
+        std::string_view get_text( uint32_t index ) const;
+        const std::string &get_speaker( uint32_t index ) const;
+        const std::string &get_voice( uint32_t index ) const;
+        const std::string &get_file( uint32_t index ) const;
+        int32_t get_line( uint32_t index ) const;
+
+        // Entries dropped from the front since creation, and changes to entries already added
+        inline uint64_t get_dropped() const {return dropped;}
+        inline uint64_t get_edits() const {return edits;}
+
+        // Bytes held by the ring, the text and the interned strings
+        uint64_t get_memory_size() const;
+};
+
+namespace VNI {
+    extern VNBacklog backlog;
+};
+
+#endif // VNBACKLOG_H
@@ -5,6 +5,7 @@
 #include <thread>
 #include <pthread.h>
 #include "VNOperationDefs/OperationDefs.h"
+#include "GUI.h"
 
 namespace VNI{
     Window window;
@@ -12,11 +13,14 @@ namespace VNI{
     VNInterpreter main_interpreter;
     std::unordered_map<std::string,VNCompiledFile> compiled_files;
     std::unordered_map<std::string,VNOperation> aliases;
-    std::string elem_text = "text", elem_name = "name";
+    uint32_t elem_text = Menu::element_id("text"), elem_name = Menu::element_id("name");
+    std::string voice;
     bool stopped = false;
 
     bool is_waiting = false, wait_skippable = false;
     float wait_time = 0;
+    bool fast_forward = false;
+    float auto_advance = -1, auto_advance_time = 0;
 
     // Should be called by window thread
     void wait(){
@@ -36,6 +40,13 @@ namespace VNI{
         if(wait_skippable)
             wait_time = 0;
         is_waiting = false;
+        auto_advance_time = 0;
+    }
+
+    // Enter first shows the text being revealed, then resumes
+    void advance(){
+        if(!GUI::skip_reveal())
+            resume();
     }
 
     // Recompiles the current file for the main VNI
@@ -45,17 +56,37 @@ namespace VNI{
 
     void update(float time){
 
-        // Skip main interpreter if waiting or stopped
-        if( is_waiting || stopped){
+        if(stopped)
             return;
+
+        // Fast forward shows text at once and continues, auto advance continues once the text is revealed and the delay passed
+        if(is_waiting){
+            if(fast_forward){
+                GUI::skip_reveal();
+                resume();
+            }
+            else if(auto_advance >= 0 && !GUI::is_revealing()){
+                auto_advance_time += time;
+                if(auto_advance_time >= auto_advance)
+                    resume();
+            }
         }
 
-        // If there is a wait time, tick it down and skip
-        if(wait_time > 0){
-            wait_time -= time;
+        // Skip main interpreter if waiting
+        if( is_waiting ){
             return;
         }
 
+        // If there is a wait time, tick it down and skip, fast forward skips it when it can be skipped
+        if(wait_time > 0){
+            if(fast_forward && wait_skippable)
+                wait_time = 0;
+            else{
+                wait_time -= time;
+                return;
+            }
+        }
+
         while(VNI::main_interpreter.execute_next() && !stopped ){
             if(is_waiting || wait_time > 0)
                 return;
@@ -185,7 +216,8 @@ bool VNInterpreter::execute_next(){
         op.function_ptr == VNOP::jump   ||
         op.function_ptr == VNOP::branch ||
         op.function_ptr == VNOP::jumpto ||
-        op.function_ptr == VNOP::ifbranch
+        op.function_ptr == VNOP::ifbranch ||
+        op.function_ptr == VNOP::backlog_jump
     ){
         op.run(*this);
         // Jumps handle their own skips
@@ -254,6 +286,24 @@ void VNInterpreter::exit() {
     execution_line = vncf->get_operations().size()-1;
 }
 
+bool VNInterpreter::restore(const std::string &filename, int32_t line){
+    VNCompiledFile *previous = vncf;
+    std::string previous_file = current_file;
+
+    if(is_routine || !switch_file(filename, false))
+        return false;
+
+    // Stay in the previous file if the operation is not in the restored one
+    if(!vncf || line < 0 || line >= vncf->get_operations().size()){
+        vncf = previous;
+        current_file = previous_file;
+        return false;
+    }
+
+    execution_line = line;
+    return true;
+}
+
 const VNOperation& VNInterpreter::get_current_op(){
     return vncf->get_operations()[execution_line];
 }
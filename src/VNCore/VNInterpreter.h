@@ -30,6 +30,10 @@ public:
     void recompile_vncf();
     void exit();
     inline void skip(){++execution_line;}
+
+    // Continues from an operation of a file, false if the file or operation does not exist
+    bool restore(const std::string &filename, int32_t line);
+    inline int32_t get_execution_line(){return execution_line;}
     const VNOperation& get_current_op();
     inline const std::string &get_current_file(){
         return current_file;
@@ -42,13 +46,22 @@ namespace VNI{
     extern VNInterpreter main_interpreter;
     extern std::unordered_map<std::string,VNCompiledFile> compiled_files;
     extern std::unordered_map<std::string,VNOperation> aliases;
-    extern std::string elem_text, elem_name;
+    // Element ids say shows text and names on
+    extern uint32_t elem_text, elem_name;
+
+    // Voice clip of the next line said, kept in the backlog with it
+    extern std::string voice;
+
+    // Fast forward continues past every skippable wait, auto advance continues this many seconds after text is revealed, off when negative
+    extern bool fast_forward;
+    extern float auto_advance;
 
     // wait and wake should be called from external threads
     void wait();
     void wait(float time, bool can_skip = true);
     void update(float time);
     void resume();
+    void advance();
     void recompile();
     void stop();
     void open_file(std::string name);
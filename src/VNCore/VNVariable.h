@@ -78,6 +78,9 @@ class VNVariable {
     public:
         uint32_t var_id = 0;
 
+        // Id of a literal element name, given when compiled, 0 otherwise
+        uint32_t element_id = 0;
+
         // Cast is the same as a copy followed by a convert
         void cast( uint8_t t );
         void string_infer_cast();
@@ -62,6 +62,7 @@ void Window::init() {
     glfwSetCharCallback( window, char_callback );
     glfwSetCursorPosCallback( window, cursor_move_callback );
     glfwSetMouseButtonCallback( window, click_callback );
+    glfwSetScrollCallback( window, scroll_callback );
 
     // Enable OpenGL and its Debug
     gladLoadGL();
@@ -113,6 +114,10 @@ void Window::run() {
     std::chrono::duration<double> elapsed_time;
     double update_time = 1.0 / ( FPS );
 
+    // Time since the last frame started, text reveal and waits use it so they keep their speed when frames are late
+    std::chrono::time_point<std::chrono::steady_clock> last_start = std::chrono::steady_clock::now();
+    double frame_time = update_time;
+
     // Set the start position for the interpreter
     VNI::open_file("main");
     VNI::main_interpreter.switch_file("main", true);
@@ -120,6 +125,8 @@ void Window::run() {
 
     while( !glfwWindowShouldClose( window ) ){
         start_time = std::chrono::steady_clock::now();
+        frame_time = fmin( std::chrono::duration<double>( start_time - last_start ).count(), .25 );
+        last_start = start_time;
 
         // Poll GLFW events
         glfwPollEvents();
@@ -128,12 +135,13 @@ void Window::run() {
 
             // Update the menus
             Menu::update();
+            GUI::update( frame_time );
 
             // Update the interpreter, this will read all possible line up to a wait
-            VNI::update(update_time);
+            VNI::update( frame_time );
 
-            // Update asset animations
-            VNAssets::update(update_time);
+            // Update asset animations by the same measured time, armatures step their constraints at a fixed rate within it
+            VNAssets::update( frame_time );
 
             // Render
             render_fbo.bind();
@@ -239,15 +247,19 @@ void key_callback( GLFWwindow *window, int key, int scancode, int action, int mo
     }
     else if( action == GLFW_PRESS ) {
 
-        // Enter key should always resume the VNI
+        // Enter key should always resume the VNI, text still being revealed is shown first
         if(key == GLFW_KEY_ENTER)
-            VNI::resume();
+            VNI::advance();
 
         // Default VNI debug/control keys use ctrl + key, these are hard-coded (for now?)
         if(mods & GLFW_MOD_CONTROL){
             switch(key){
                 case GLFW_KEY_R:
                     VNI::recompile(); break;
+                case GLFW_KEY_F:
+                    VNI::fast_forward = !VNI::fast_forward; break;
+                case GLFW_KEY_A:
+                    VNI::auto_advance = VNI::auto_advance < 0 ? 1.5f : -1; break;
             }
         }
         GUI::key_input( key, mods );
@@ -263,7 +275,8 @@ void char_callback( GLFWwindow *window, unsigned int  codepoint ) {
     GUI::char_input( codepoint );
 }
 
-void cursor_move_callback( GLFWwindow *window, double x, double y ) {
+// Converts window coordinates of the cursor to the 0 to 1 coordinates of the GUI
+static void to_gui_coordinates( GLFWwindow *window, double &x, double &y ) {
     Window *w = static_cast<Window *>( glfwGetWindowUserPointer( window ) );
 
     int width, height;
@@ -283,39 +296,34 @@ void cursor_move_callback( GLFWwindow *window, double x, double y ) {
     // Convert to a 0 to 1 scale and flip y
     x /= width;
     y = 1 - ( y / height );
+}
+
+void cursor_move_callback( GLFWwindow *window, double x, double y ) {
+    to_gui_coordinates( window, x, y );
 
     // Pass to GUI
     GUI::highlight( x, y );
 }
 
 void click_callback( GLFWwindow *window, int key, int action, int mods ) {
-    Window *w = static_cast<Window *>( glfwGetWindowUserPointer( window ) );
-
     // Only allow down-presses
     if( action != GLFW_PRESS )
         return;
 
     double x, y;
-    int width, height;
     glfwGetCursorPos( window, &x, &y );
-    glfwGetWindowSize( window, &width, &height );
-    float r = w->get_ratio();
+    to_gui_coordinates( window, x, y );
 
-    // Offset the input to that of the subwindow
-    if( width > height * r ) {
-        x -= ( width - r * height ) / 2;
-        width = height * r;
-    }
-    else {
-        y -= ( height - width / r ) / 2;
-        height = width / r;
-    }
+    // Pass to GUI
+    GUI::select( x, y );
+}
 
-    // Convert to a 0 to 1 scale and flip y
-    x /= width;
-    y = 1 - ( y / height );
+void scroll_callback( GLFWwindow *window, double xoffset, double yoffset ) {
+    double x, y;
+    glfwGetCursorPos( window, &x, &y );
+    to_gui_coordinates( window, x, y );
 
     // Pass to GUI
-    GUI::select( x, y );
+    GUI::scroll( x, y, yoffset );
 }
 
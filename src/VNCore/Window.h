@@ -14,6 +14,7 @@ void win_resize_callback(GLFWwindow *window, int width, int height);
 void char_callback(GLFWwindow *window, unsigned int  codepoint);
 void cursor_move_callback( GLFWwindow *window, double xpos, double ypos);
 void click_callback(GLFWwindow *window, int key, int action, int mods);
+void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 
 class Window {
     GLFWwindow *window = nullptr;
@@ -2,6 +2,7 @@
 # include "VNDebug.h"
 #include "VNInterpreter.h"
 #include "VNCompiledFile.h"
+#include "Menu.h"
 #include <sstream>
 
 namespace VNOP{
@@ -103,6 +104,10 @@ void OpFormat::init() {
         else if(token.starts_with('&')){
             format.push_back({OpFormatArg::REF, {}});
         }
+        // Element name
+        else if(token.starts_with('@')){
+            format.push_back({OpFormatArg::ELEMENT, {}});
+        }
         // Keyword
         else{
             // If args were started, error
@@ -180,6 +185,12 @@ bool OpFormat::validate(VNOperation &op, VNCompiledFile &vncf){
                     return false;
                 }
             break;
+
+            // Literal element names are given their id, names in variables are found when run
+            case OpFormatArg::ELEMENT:
+                if(op.args[i].var_id == 0)
+                    op.args[i].element_id = Menu::element_id(op.args[i].value_string());
+            break;
         }
     }
 
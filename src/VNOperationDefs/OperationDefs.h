@@ -35,7 +35,7 @@ typedef void ( *OpFuncPtr )( func_args );
 
 // Format for an operation
 struct OpFormatArg {
-    static const uint8_t VAR = 0, ENUM = 1, REF = 2;
+    static const uint8_t VAR = 0, ENUM = 1, REF = 2, ELEMENT = 3;
     uint8_t type = VAR;
     std::vector<std::string> enums;
 };
@@ -132,6 +132,11 @@ namespace VNOP {
     say_start,
     say_continue,
     say_print,
+    say_voice,
+    backlog_jump,
+    backlog_voice,
+    backlog_clear,
+    backlog_limit,
 
     // control
     routine,
@@ -159,6 +164,7 @@ namespace VNOP {
     element_size,
     element_position,
     element_routine,
+    element_list,
 
     // scene
     scene_create,
@@ -175,6 +181,8 @@ namespace VNOP {
     model_mix,
     model_copy,
     model_images,
+    model_layout,
+    model_optimize,
 
     // object
     object_create,
@@ -1,6 +1,8 @@
 #include "VNInterpreter.h"
 #include "VNAssetManager.h"
 #include "OperationDefs.h"
+#include "VNBacklog.h"
+#include "Audio.h"
 
 namespace VNOP{
 
@@ -8,7 +10,7 @@ namespace VNOP{
     void load_ops_character(){
 
         operation_map["say element"] = say_element;
-        format_map[say_element] = {"say element ( text name ) -element"};
+        format_map[say_element] = {"say element ( text name ) @element"};
 
         operation_map["say start"] = say_start;
         format_map[say_start] = {"say start | -char_name :"};
@@ -18,23 +20,44 @@ namespace VNOP{
 
         operation_map["say print"] = say_print;
         format_map[say_print] = {"say print -name | vars..."};
+
+        operation_map["say voice"] = say_voice;
+        format_map[say_voice] = {"say voice -sound"};
+
+        operation_map["backlog jump"] = backlog_jump;
+        format_map[backlog_jump] = {"backlog jump -index"};
+
+        operation_map["backlog voice"] = backlog_voice;
+        format_map[backlog_voice] = {"backlog voice -index"};
+
+        operation_map["backlog clear"] = backlog_clear;
+        format_map[backlog_clear] = {"backlog clear"};
+
+        operation_map["backlog limit"] = backlog_limit;
+        format_map[backlog_limit] = {"backlog limit -entries | -bytes"};
+    }
+
+    // Records a line in the backlog with the voice played for it, routines have no position to return to
+    static void record_line( const std::string &name, const std::string &line, VNInterpreter &vni ) {
+        VNI::backlog.add( name, line, VNI::voice, vni.get_current_file(), vni.is_routine ? -1 : vni.get_execution_line() );
+        VNI::voice.clear();
     }
 };
 
 void VNOP::say_element(func_args){
     if(args[0].value_string() == "text"){
-        VNI::elem_text = args[1].value_string();
+        VNI::elem_text = Menu::element_id(args[1]);
     }
     else if(args[0].value_string() == "name"){
-        VNI::elem_name = args[1].value_string();
+        VNI::elem_name = Menu::element_id(args[1]);
     }
 }
 
 void VNOP::say_start( func_args ) {
     if(!Menu::active)
         return;
-    Element *e_text = Menu::active->element_map[VNI::elem_text];
-    Element *e_name = Menu::active->element_map[VNI::elem_name];
+    Element *e_text = Menu::active->get_element(VNI::elem_text);
+    Element *e_name = Menu::active->get_element(VNI::elem_name);
 
     // If a name is given, show on the name element
     if(e_name){
@@ -53,6 +76,8 @@ void VNOP::say_start( func_args ) {
         e_text->set_text(args.back().value_string());
     }
 
+    record_line(args.size() == 2 ? args[0].value_string() : "", args.back().value_string(), vni);
+
     // Call wait regardless ( otherwise crazy skipping could happen with poorly set-up menus)
     VNI::wait();
 }
@@ -60,12 +85,14 @@ void VNOP::say_start( func_args ) {
 void VNOP::say_continue( func_args ) {
     if(!Menu::active)
         return;
-    Element *e_text = Menu::active->element_map[VNI::elem_text];
+    Element *e_text = Menu::active->get_element(VNI::elem_text);
     if(e_text){
         e_text->flags |= Element::REVEAL_TEXT | Element::LEFT_ALIGN;
         e_text->append_text(args[0].value_string());
     }
 
+    VNI::backlog.append(args[0].value_string());
+
     // Call wait regardless ( otherwise crazy skipping could happen with poorly set-up menus)
     VNI::wait();
 }
@@ -73,8 +100,8 @@ void VNOP::say_continue( func_args ) {
 void VNOP::say_print( func_args ) {
     if(!Menu::active)
         return;
-    Element *e_text = Menu::active->element_map[VNI::elem_text];
-    Element *e_name = Menu::active->element_map[VNI::elem_name];
+    Element *e_text = Menu::active->get_element(VNI::elem_text);
+    Element *e_name = Menu::active->get_element(VNI::elem_name);
 
     // If a name is given, show on the name element
     if(e_name){
@@ -87,19 +114,84 @@ void VNOP::say_print( func_args ) {
         }
     }
 
+    // The printed values separated by spaces
+    std::string line;
+    for(uint8_t i = 1; i < args.size(); ++i){
+        line += args[i].value_string();
+        if(i < args.size()-1)
+            line += " ";
+    }
+
     if(e_text){
         e_text->flags |= Element::REVEAL_TEXT | Element::LEFT_ALIGN;
         e_text->text->set_text("");
-        for(uint8_t i = 1; i < args.size()-1; ++i){
-            e_text->append_text(args[i].value_string()+" ");
-        }
-        if(args.size()>1)
-            e_text->append_text(args.back().value_string());
+        e_text->append_text(line);
 
         // Reset the reveal amount
         e_text->reveal_amount = 0;
+        e_text->reveal_pause = 0;
     }
 
+    record_line(args[0].value_string(), line, vni);
+
     // Call wait regardless ( otherwise crazy skipping could happen with poorly set-up menus)
     VNI::wait();
 }
+
+// Plays a voice clip for the next line, the backlog keeps it to play again
+void VNOP::say_voice( func_args ) {
+    VNI::voice = args[0].value_string();
+    Audio::play_sound(VNI::voice);
+}
+
+/*
+ * Returns the main script to where a backlog line was said, the line and every later one are removed and said again.
+ * Variables keep their current values.
+ * Like jumps this is not followed by an increment, so the interpreter running it skips unless it is the one restored.
+ */
+void VNOP::backlog_jump( func_args ) {
+    int32_t index = args[0].value_int();
+    if(index < 0 || index >= (int32_t)VNI::backlog.size() || VNI::backlog.get_line(index) < 0){
+        vni.skip();
+        return;
+    }
+
+    std::string file = VNI::backlog.get_file(index);
+    int32_t line = VNI::backlog.get_line(index);
+
+    if(!VNI::main_interpreter.restore(file, line)){
+        VNDebug::runtime_error("Unable to return to backlog line in", file, vni);
+        vni.skip();
+        return;
+    }
+
+    // A routine continues after the jump, the main script continues at the restored line
+    if(&vni != &VNI::main_interpreter)
+        vni.skip();
+
+    VNI::backlog.truncate(index);
+    GUI::skip_reveal();
+    VNI::resume();
+}
+
+void VNOP::backlog_voice( func_args ) {
+    int32_t index = args[0].value_int();
+    if(index < 0 || index >= (int32_t)VNI::backlog.size() || VNI::backlog.get_voice(index).empty())
+        return;
+
+    Audio::play_sound(VNI::backlog.get_voice(index));
+}
+
+void VNOP::backlog_clear( func_args ) {
+    VNI::backlog.clear();
+}
+
+// Sets the entries and text bytes kept, older lines are dropped as new ones are said
+void VNOP::backlog_limit( func_args ) {
+    VNI::backlog.max_entries = std::max(args[0].value_int(), 0);
+    if(args.size() > 1)
+        VNI::backlog.max_text_bytes = std::max(args[1].value_int(), 0);
+
+    printf("Backlog: %u lines, %.1f KB, limits %u lines %u bytes\n", VNI::backlog.size(), VNI::backlog.get_memory_size() / 1024.0,
+           VNI::backlog.max_entries, VNI::backlog.max_text_bytes);
+}
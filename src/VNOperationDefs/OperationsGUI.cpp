@@ -15,28 +15,31 @@ namespace VNOP{
         format_map[menu_compact]={"menu compact ( left center ) -start -anchor -width -top -spacing_width -spacing_height"};
 
         operation_map["element create"] =  element_create;
-        format_map[element_create]={"element create ( text button option toggle text-input num-input bar key-capture ) -name "};
+        format_map[element_create]={"element create ( text button option toggle text-input num-input bar key-capture list backlog ) @name"};
 
         operation_map["element delete"] =  element_delete;
-        format_map[element_delete]={"element delete -name"};
+        format_map[element_delete]={"element delete @name"};
 
         operation_map["element enable"] =  element_enable;
-        format_map[element_enable]={"element enable -name -bool"};
+        format_map[element_enable]={"element enable @name -bool"};
 
         operation_map["element value"] =  element_value;
-        format_map[element_value]={"element value -name ( get set ) -value"};
+        format_map[element_value]={"element value @name ( get set ) -value"};
 
         operation_map["element text"] =  element_text;
-        format_map[element_text]={"element text -name ( get set ) -value"};
+        format_map[element_text]={"element text @name ( get set ) -value"};
 
         operation_map["element size"] =  element_size;
-        format_map[element_size]={"element size -name ( get set ) -width -height"};
+        format_map[element_size]={"element size @name ( get set ) -width -height"};
 
         operation_map["element position"] =  element_position;
-        format_map[element_position]={"element position -name ( get set ) -x -y"};
+        format_map[element_position]={"element position @name ( get set ) -x -y"};
 
         operation_map["element routine"] =  element_routine;
-        format_map[element_routine]={"element routine -name -label -file"};
+        format_map[element_routine]={"element routine @name -label -file"};
+
+        operation_map["element list"] =  element_list;
+        format_map[element_list]={"element list @name ( add clear scroll ) | -value"};
     }
 
     /*
@@ -96,28 +99,34 @@ void VNOP::element_create( func_args ) {
     std::string type = args[0].value_string();
 
     if( type == "text" ) {
-        Menu::active->add_element( args[1].value_string(), ElementText() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementText() );
     }
     else if( type == "button" ) {
-        Menu::active->add_element( args[1].value_string(), ElementButton() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementButton() );
     }
     else if( type == "option" ) {
-        Menu::active->add_element( args[1].value_string(), ElementOption() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementOption() );
     }
     else if( type == "toggle" ) {
-        Menu::active->add_element( args[1].value_string(), ElementToggle() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementToggle() );
     }
     else if( type == "text-input" ) {
-        Menu::active->add_element( args[1].value_string(), ElementTextInput() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementTextInput() );
     }
     else if( type == "num-input" ) {
-        Menu::active->add_element( args[1].value_string(), ElementNumInput() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementNumInput() );
     }
     else if( type == "bar" ) {
-        Menu::active->add_element( args[1].value_string(), ElementBar() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementBar() );
     }
     else if( type == "key-capture" ) {
-        Menu::active->add_element( args[1].value_string(), ElementKeyCapture() );
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementKeyCapture() );
+    }
+    else if( type == "list" ) {
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementList() );
+    }
+    else if( type == "backlog" ) {
+        Menu::active->add_element( Menu::element_id( args[1] ), ElementBacklog() );
     }
 }
 
@@ -127,7 +136,7 @@ void VNOP::element_delete( func_args ) {
     if( !Menu::active )
         return;
 
-    Menu::active->remove_element( args[0].value_string() );
+    Menu::active->remove_element( Menu::element_id( args[0] ) );
 }
 
 // element enable <name> <bool>
@@ -136,7 +145,7 @@ void VNOP::element_enable( func_args ) {
     if( !Menu::active )
         return;
 
-    Element *e = Menu::active->element_map[args[0].value_string()];
+    Element *e = Menu::active->get_element( args[0] );
 
     if( !e )
         return;
@@ -149,7 +158,7 @@ void VNOP::element_value( func_args ) {
     if( !Menu::active )
         return;
 
-    Element *e = Menu::active->element_map[args[0].value_string()];
+    Element *e = Menu::active->get_element( args[0] );
 
     if( !e )
         return;
@@ -170,7 +179,7 @@ void VNOP::element_text( func_args ) {
     if( !Menu::active )
         return;
 
-    Element *e = Menu::active->element_map[args[0].value_string()];
+    Element *e = Menu::active->get_element( args[0] );
 
     if( !e )
         return;
@@ -191,7 +200,7 @@ void VNOP::element_size( func_args ) {
     if( !Menu::active )
         return;
 
-    Element *e = Menu::active->element_map[args[0].value_string()];
+    Element *e = Menu::active->get_element( args[0] );
 
     if( !e )
         return;
@@ -213,7 +222,7 @@ void VNOP::element_position( func_args ) {
     if( !Menu::active )
         return;
 
-    Element *e = Menu::active->element_map[args[0].value_string()];
+    Element *e = Menu::active->get_element( args[0] );
 
     if( !e )
         return;
@@ -236,7 +245,7 @@ void VNOP::element_routine( func_args ) {
     if( !Menu::active )
         return;
 
-    Element *e = Menu::active->element_map[args[0].value_string()];
+    Element *e = Menu::active->get_element( args[0] );
 
     if( !e )
         return;
@@ -245,3 +254,29 @@ void VNOP::element_routine( func_args ) {
     e->routine_label = args[1].value_string();
     e->routine_file = args[2].value_string();
 }
+
+// Changes the entries of a list
+// element list <name> <add/clear/scroll> <text or rows>
+void VNOP::element_list( func_args ) {
+    if( !Menu::active )
+        return;
+
+    Element *e = Menu::active->get_element( args[0] );
+
+    if( !e || e->type != LIST )
+        return;
+
+    ElementList *list = static_cast<ElementList *>( e );
+
+    if( args[1].value_string() == "add" ) {
+        ensure_args( 3 )
+        list->add_entry( args[2].value_string() );
+    }
+    else if( args[1].value_string() == "clear" ) {
+        list->clear_entries();
+    }
+    else if( args[1].value_string() == "scroll" ) {
+        ensure_args( 3 )
+        list->scroll( args[2].value_int() );
+    }
+}
@@ -27,6 +27,12 @@ namespace VNOP {
         operation_map["model images"] = model_images;
         format_map[model_images] = {"model images -name | images..."};
 
+        operation_map["model layout"] = model_layout;
+        format_map[model_layout] = {"model layout -name ( separate interleaved )"};
+
+        operation_map["model optimize"] = model_optimize;
+        format_map[model_optimize] = {"model optimize -name"};
+
     }
 }
 
@@ -151,3 +157,49 @@ void VNOP::model_images( func_args ) {
     }
     model->image_changed = true;
 }
+
+// model layout <name> <separate interleaved>
+void VNOP::model_layout( func_args ) {
+    exact_args( 2 )
+    ModelContainer *model = VNAssets::get_model( args[0].value_string() );
+
+    if( !model ){
+        VNDebug::runtime_error("Model not defined", args[0].value_string(), vni);
+        return;
+    }
+
+    uint8_t layout = Mesh::LAYOUT_SEPARATE;
+    if(args[1].value_string() == "interleaved"){
+        layout = Mesh::LAYOUT_INTERLEAVED;
+    }
+
+    model->mesh.set_layout( layout );
+
+    // Report the vertex memory of both layouts
+    uint32_t count = model->mesh.get_vertex_count();
+    uint32_t separate = model->mesh.get_vertex_size( Mesh::LAYOUT_SEPARATE );
+    uint32_t interleaved = model->mesh.get_vertex_size( Mesh::LAYOUT_INTERLEAVED );
+    printf( "Model %s: %u vertices, separate %u bytes (%u per vertex), interleaved %u bytes (%u per vertex)\n",
+            args[0].value_string().c_str(), count, count * separate, separate, count * interleaved, interleaved );
+    fflush( stdout );
+}
+
+// model optimize <name>
+void VNOP::model_optimize( func_args ) {
+    exact_args( 1 )
+    ModelContainer *model = VNAssets::get_model( args[0].value_string() );
+
+    if( !model ){
+        VNDebug::runtime_error("Model not defined", args[0].value_string(), vni);
+        return;
+    }
+
+    uint32_t count = model->mesh.get_vertex_count();
+    float acmr_before, acmr_after;
+    model->mesh.optimize( acmr_before, acmr_after );
+
+    printf( "Model %s: %u -> %u vertices, ACMR %.3f -> %.3f, %s bit indices\n",
+            args[0].value_string().c_str(), count, model->mesh.get_vertex_count(), acmr_before, acmr_after,
+            model->mesh.get_vertex_count() <= UINT16_MAX + 1 ? "16" : "32" );
+    fflush( stdout );
+}
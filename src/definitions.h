@@ -8,7 +8,11 @@
 
 // Armature
 #define ARMATURE_MAX_JOINTS 150 // Must match shader uniform
-#define ARMATURE_CONSTRAINT_TIMESTEP .05f
+#define ARMATURE_CONSTRAINT_TIMESTEP ( 1.0f / 60 ) // Fixed step of softbody constraints, independent of the frame rate
+#define ARMATURE_CONSTRAINT_MAX_SUBSTEPS 8 // Steps per update before time is dropped, so a long frame cannot stall
+#define ANIMATION_COMPRESSION 1 // Quantize and reduce animation keys when loading armatures
+#define ANIMATION_POS_TOLERANCE .0005f // Largest position error allowed when removing keys
+#define ANIMATION_ROT_TOLERANCE .001f // Largest rotation error in radians allowed when removing keys
 
 // Window
 #define FPS 30
@@ -16,6 +20,10 @@
 // FBO
 #define FBO_MAX_COLOR_ATTACHMENTS 8
 
+// Textures
+#define TEXTURE_COMPRESSION 1 // Transcode the image atlas to BC3 with mipmaps, its tiles are cached on disk
+#define ATLAS_LAYER_SIZE 4096 // Width and height atlas layers grow to before more are added, larger images grow them further
+
 // View
 #define VIEW_NEAR .1f
 #define VIEW_FAR 100.0f
@@ -34,5 +42,6 @@
 #define DIR_SOUNDS    "../assets/sounds/"
 #define DIR_FONTS     "../assets/fonts/"
 #define DIR_SCRIPTS   "../scripts/"
+#define DIR_TEXTURE_CACHE "../cache/textures/"
 
 #endif // CFG_VARS_H
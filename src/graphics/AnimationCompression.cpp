@@ -0,0 +1,247 @@
+#include "Armature.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+ * Animation key compression, keys are removed where interpolating their neighbors stays within a tolerance,
+ * then the remaining keys are quantized.
+ */
+
+// Components other than the largest of a unit quaternion lie within +-1/sqrt(2)
+static const float SMALLEST_RANGE = 0.70710678f;
+static const float QUAT_STEPS = 32767;
+static const float POS_STEPS = 65535;
+
+static void encode_rot( const float *q, uint16_t *dest ) {
+    versor n;
+    glm_quat_copy( (float *)q, n );
+    glm_quat_normalize( n );
+
+    uint32_t largest = 0;
+    for( uint32_t i = 1; i < 4; ++i ) {
+        if( fabsf( n[i] ) > fabsf( n[largest] ) )
+            largest = i;
+    }
+
+    // q and -q are the same rotation, keep the largest positive so it can be rebuilt from the others
+    float sign = n[largest] < 0 ? -1 : 1;
+
+    for( uint32_t i = 0, j = 0; i < 4; ++i ) {
+        if( i == largest )
+            continue;
+
+        float v = std::clamp( n[i] * sign / SMALLEST_RANGE * 0.5f + 0.5f, 0.0f, 1.0f );
+        dest[j++] = (uint16_t)lroundf( v * QUAT_STEPS );
+    }
+
+    // The index of the largest uses the top bit of the first two components
+    dest[0] |= ( largest & 1 ) << 15;
+    dest[1] |= ( largest >> 1 ) << 15;
+}
+
+static void decode_rot( const uint16_t *src, versor q ) {
+    uint32_t largest = ( src[0] >> 15 ) | ( ( src[1] >> 15 ) << 1 );
+    float sum = 0;
+
+    for( uint32_t i = 0, j = 0; i < 4; ++i ) {
+        if( i == largest )
+            continue;
+
+        float v = ( ( src[j++] & 0x7FFF ) / QUAT_STEPS * 2 - 1 ) * SMALLEST_RANGE;
+        q[i] = v;
+        sum += v * v;
+    }
+
+    q[largest] = sqrtf( fmaxf( 0, 1 - sum ) );
+}
+
+// Angle in radians between two rotations, from the rotation between them since acos of their dot is too coarse near 1
+static float rot_error( const versor a, const versor b ) {
+    versor inv, r;
+    glm_quat_conjugate( (float *)a, inv );
+    glm_quat_mul( inv, (float *)b, r );
+    return 2 * atan2f( sqrtf( r[0] * r[0] + r[1] * r[1] + r[2] * r[2] ), fabsf( r[3] ) );
+}
+
+/*
+ * Keep the first and last key, and each key where interpolating from the last kept key fails the test.
+ * within(a, b) tests whether every key between a and b is reproduced by interpolating a and b,
+ * same(a, b) tests whether two keys have the same value.
+ * A constant track keeps only its first key, which samples the same as holding it to the end.
+ */
+template<typename Within, typename Same>
+static std::vector<uint32_t> reduce_keys( uint32_t count, Within within, Same same ) {
+    std::vector<uint32_t> kept;
+
+    if( count == 0 )
+        return kept;
+
+    kept.push_back( 0 );
+    uint32_t anchor = 0;
+
+    for( uint32_t k = 2; k < count; ++k ) {
+        if( !within( anchor, k ) ) {
+            anchor = k - 1;
+            kept.push_back( anchor );
+        }
+    }
+
+    if( count > 1 )
+        kept.push_back( count - 1 );
+
+    if( kept.size() == 2 && same( kept[0], kept[1] ) )
+        kept.pop_back();
+
+    return kept;
+}
+
+// Factor of time t between the keys a and b, false if the keys share a time
+static bool key_factor( const std::vector<float> &times, uint32_t a, uint32_t b, uint32_t i, float &factor ) {
+    if( times[b] <= times[a] )
+        return false;
+
+    factor = ( times[i] - times[a] ) / ( times[b] - times[a] );
+    return true;
+}
+
+void AnimChannel::get_pos_key( uint32_t k, vec3 v ) const {
+    if( !compressed ) {
+        glm_vec3_copy( (float *)pos_values.data() + k * 3, v );
+        return;
+    }
+
+    for( uint32_t i = 0; i < 3; ++i )
+        v[i] = pos_min[i] + pos_quantized[k * 3 + i] / POS_STEPS * pos_extent[i];
+}
+
+void AnimChannel::get_rot_key( uint32_t k, versor q ) const {
+    if( !compressed ) {
+        glm_quat_copy( (float *)rot_values.data() + k * 4, q );
+        return;
+    }
+
+    decode_rot( &rot_quantized[k * 3], q );
+}
+
+/*
+ * Keys are quantized first so removed keys are tested against the values that will actually be played,
+ * the error of every removed key including quantization is within the tolerance.
+ */
+void AnimChannel::compress( float pos_tolerance, float rot_tolerance ) {
+    if( compressed )
+        return;
+
+    uint32_t pos_count = pos_times.size();
+    uint32_t rot_count = rot_times.size();
+
+    // Quantize positions within the bounds of the channel
+    glm_vec3_zero( pos_min );
+    glm_vec3_zero( pos_extent );
+
+    if( pos_count ) {
+        vec3 pos_max;
+        glm_vec3_copy( pos_key( 0 ), pos_min );
+        glm_vec3_copy( pos_key( 0 ), pos_max );
+
+        for( uint32_t k = 1; k < pos_count; ++k ) {
+            glm_vec3_minv( pos_min, pos_key( k ), pos_min );
+            glm_vec3_maxv( pos_max, pos_key( k ), pos_max );
+        }
+
+        glm_vec3_sub( pos_max, pos_min, pos_extent );
+    }
+
+    std::vector<uint16_t> pos_all( pos_count * 3 );
+    std::vector<float> pos_decoded( pos_count * 3 );
+
+    for( uint32_t k = 0; k < pos_count; ++k ) {
+        for( uint32_t i = 0; i < 3; ++i ) {
+            float v = pos_extent[i] > 0 ? ( pos_key( k )[i] - pos_min[i] ) / pos_extent[i] : 0;
+            pos_all[k * 3 + i] = (uint16_t)lroundf( std::clamp( v, 0.0f, 1.0f ) * POS_STEPS );
+            pos_decoded[k * 3 + i] = pos_min[i] + pos_all[k * 3 + i] / POS_STEPS * pos_extent[i];
+        }
+    }
+
+    std::vector<uint16_t> rot_all( rot_count * 3 );
+    std::vector<float> rot_decoded( rot_count * 4 );
+
+    for( uint32_t k = 0; k < rot_count; ++k ) {
+        encode_rot( rot_key( k ), &rot_all[k * 3] );
+        decode_rot( &rot_all[k * 3], &rot_decoded[k * 4] );
+    }
+
+    // Remove keys
+    std::vector<uint32_t> pos_kept = reduce_keys( pos_count, [&]( uint32_t a, uint32_t b ) {
+        for( uint32_t i = a + 1; i < b; ++i ) {
+            vec3 v;
+            float factor;
+
+            if( !key_factor( pos_times, a, b, i, factor ) )
+                return false;
+
+            glm_vec3_lerp( &pos_decoded[a * 3], &pos_decoded[b * 3], factor, v );
+            if( glm_vec3_distance( v, pos_key( i ) ) > pos_tolerance )
+                return false;
+        }
+        return true;
+    }, [&]( uint32_t a, uint32_t b ) {
+        return glm_vec3_distance( &pos_decoded[a * 3], pos_key( b ) ) <= pos_tolerance;
+    } );
+
+    std::vector<uint32_t> rot_kept = reduce_keys( rot_count, [&]( uint32_t a, uint32_t b ) {
+        for( uint32_t i = a + 1; i < b; ++i ) {
+            versor q;
+            float factor;
+
+            if( !key_factor( rot_times, a, b, i, factor ) )
+                return false;
+
+            glm_quat_nlerp( &rot_decoded[a * 4], &rot_decoded[b * 4], factor, q );
+            if( rot_error( q, rot_key( i ) ) > rot_tolerance )
+                return false;
+        }
+        return true;
+    }, [&]( uint32_t a, uint32_t b ) {
+        return rot_error( &rot_decoded[a * 4], rot_key( b ) ) <= rot_tolerance;
+    } );
+
+    // Replace the float keys with the kept quantized keys
+    std::vector<float> times;
+
+    for( uint32_t k : pos_kept ) {
+        times.push_back( pos_times[k] );
+        pos_quantized.insert( pos_quantized.end(), &pos_all[k * 3], &pos_all[k * 3] + 3 );
+    }
+    pos_times.swap( times );
+    times.clear();
+
+    for( uint32_t k : rot_kept ) {
+        times.push_back( rot_times[k] );
+        rot_quantized.insert( rot_quantized.end(), &rot_all[k * 3], &rot_all[k * 3] + 3 );
+    }
+    rot_times.swap( times );
+
+    std::vector<float>().swap( pos_values );
+    std::vector<float>().swap( rot_values );
+    compressed = true;
+}
+
+uint64_t AnimChannel::memory_size() const {
+    uint64_t size = ( pos_times.size() + rot_times.size() + pos_values.size() + rot_values.size() ) * sizeof( float );
+    size += ( pos_quantized.size() + rot_quantized.size() ) * sizeof( uint16_t );
+
+    // Bounds of the quantized positions
+    if( compressed )
+        size += sizeof( pos_min ) + sizeof( pos_extent );
+
+    return size;
+}
+
+uint64_t Animation::memory_size() const {
+    uint64_t size = 0;
+
+    for( const AnimChannel &c : channels )
+        size += c.memory_size();
+
+    return size;
+}
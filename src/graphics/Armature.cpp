@@ -1,126 +1,269 @@
 #include "Armature.h"
+#include "QuatBatch.h"
 
 #include <stdexcept>
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
 
 /*
  * Anim Channel
  */
 
-void AnimChannel::value_pos(float t, vec3 v){
-    // Set the default return key out of range
-    uint16_t k = positions.size();
+// Keys a cursor may step forward before falling back to a binary search
+static const uint32_t CURSOR_MAX_STEPS = 4;
 
-    // Quick check out of range
-    if(t > positions.back().t){
-        glm_vec3_copy(positions.back().pos, v);
-        return;
+/*
+ * Find the first key with a time greater than t, starting from the cursor.
+ * Playing forward only steps over a few keys, seeks, loops and reverse playback use a binary search.
+ */
+static inline uint32_t find_key(const std::vector<float> &times, float t, uint32_t &cursor){
+    uint32_t k = cursor;
+
+    // The cursor is usable if no key before it is past t
+    if(k <= times.size() && (k == 0 || times[k-1] <= t)){
+        for(uint32_t step = 0; step <= CURSOR_MAX_STEPS; ++step, ++k){
+            if(k == times.size() || times[k] > t){
+                cursor = k;
+                return k;
+            }
+        }
     }
-    else if(t <= 0 ){
-        glm_vec3_copy(positions.front().pos,v);
-        return;
+
+    k = std::upper_bound(times.begin(), times.end(), t) - times.begin();
+    cursor = k;
+    return k;
+}
+
+/*
+ * Find the keys surrounding t and the factor between them.
+ * Times out of range give the first or last key for both, times before the first key are invalid.
+ */
+static inline bool find_key_pair(const std::vector<float> &times, float t, uint32_t &cursor, uint32_t &from, uint32_t &to, float &factor){
+    if(times.empty())
+        return false;
+
+    // Quick check out of range
+    if(t > times.back() || t <= 0){
+        from = to = t > 0 ? times.size() - 1 : 0;
+        factor = 0;
+        return true;
     }
 
     // Find the first key that exceeds the time sought
-    for(uint16_t i = 0; i < positions.size(); ++i){
-        if(positions[i].t > t){
-            k = i;
-            break;
-        }
-    }
+    uint32_t k = find_key(times, t, cursor);
 
     // If none found, assume out of range (this should have been caught by the first check)
-    if(k == positions.size()){
-        glm_vec3_copy(positions.back().pos, v);
-        return;
+    if(k == times.size()){
+        from = to = k - 1;
+        factor = 0;
+        return true;
     }
 
     // Pre-Animation times are considered invalid and thus do nothing
-    else if( k > 0){
-        // The time t must be greater than the time at k-1 and less than k, lerp between the two
-        glm_vec3_lerp(positions[k-1].pos, positions[k].pos, (t-positions[k-1].t) / (positions[k].t - positions[k-1].t), v );
-    }
+    if(k == 0)
+        return false;
+
+    // The time t must be greater than the time at k-1 and less than k
+    from = k - 1;
+    to = k;
+    factor = (t - times[k-1]) / (times[k] - times[k-1]);
+    return true;
 }
 
-void AnimChannel::value_rot(float t, versor v){
-    // Set the default return key out of range
-    uint16_t k = rotations.size();
+void AnimChannel::value_pos(float t, vec3 v) const{
+    uint32_t cursor = 0;
+    value_pos(t, v, cursor);
+}
 
-    // Quick check out of range
-    if(t > rotations.back().t){
-        glm_quat_copy(rotations.back().rot, v);
+void AnimChannel::value_rot(float t, versor v) const{
+    uint32_t cursor = 0;
+    value_rot(t, v, cursor);
+}
+
+void AnimChannel::value_pos(float t, vec3 v, uint32_t &cursor) const{
+    if(pos_times.empty()){
+        glm_vec3_zero(v);
         return;
     }
-    else if(t <= 0 ){
-        glm_quat_copy(rotations.front().rot, v);
+
+    vec3 from, to;
+    float factor;
+    if(keys_pos(t, cursor, from, to, factor))
+        glm_vec3_lerp(from, to, factor, v);
+}
+
+void AnimChannel::value_rot(float t, versor v, uint32_t &cursor) const{
+    if(rot_times.empty()){
+        glm_quat_identity(v);
         return;
     }
 
-    // Find the first key that exceeds the time sought
-    for(uint16_t i = 0; i < rotations.size(); ++i){
-        if(rotations[i].t > t){
-            k = i;
-            break;
-        }
+    versor from, to;
+    float factor;
+    if(keys_rot(t, cursor, from, to, factor))
+        glm_quat_nlerp(from, to, factor, v);
+}
+
+bool AnimChannel::keys_pos(float t, uint32_t &cursor, vec3 from, vec3 to, float &factor) const{
+    uint32_t k0, k1;
+    if(!find_key_pair(pos_times, t, cursor, k0, k1, factor))
+        return false;
+
+    get_pos_key(k0, from);
+    get_pos_key(k1, to);
+    return true;
+}
+
+bool AnimChannel::keys_rot(float t, uint32_t &cursor, versor from, versor to, float &factor) const{
+    uint32_t k0, k1;
+    if(!find_key_pair(rot_times, t, cursor, k0, k1, factor))
+        return false;
+
+    get_rot_key(k0, from);
+    get_rot_key(k1, to);
+    return true;
+}
+
+
+/*
+ * Animation
+ */
+
+/*
+ * Channel values sampled by Animation::sample, reused by every animation posed on the same thread.
+ * Channels without a sample (before their first key) are skipped by the pose functions.
+ */
+struct PoseBuffer {
+    std::vector<float> pos;
+    std::vector<uint8_t> has_pos, has_rot;
+    QuatBatch::QuatArray from, to, rot;
+    std::vector<float> factor;
+
+    void resize(uint32_t count){
+        pos.resize(count * 3);
+        has_pos.resize(count);
+        has_rot.resize(count);
+        from.resize(count);
+        to.resize(count);
+        rot.resize(count);
+        factor.resize(QuatBatch::QuatArray::padded(count), 0);
     }
+};
 
-    // If none found, assume out of range (this should have been caught by the first check)
-    if(k == rotations.size()){
-        glm_quat_copy(rotations.back().rot, v);
-        return;
+static thread_local PoseBuffer pose_buffer;
+
+// Without cursors every channel searches its keys from the start
+static inline AnimCursor &channel_cursor(AnimCursor *cursors, uint32_t i, AnimCursor &fallback){
+    if(!cursors){
+        fallback = AnimCursor();
+        return fallback;
     }
+    return cursors[i];
+}
 
-    // Pre-Animation times are considered invalid and thus do nothing
-    else if( k > 0){
-        // The time t must be greater than the time at k-1 and less than k, lerp between the two
-        glm_quat_nlerp(rotations[k-1].rot, rotations[k].rot, (t-rotations[k-1].t) / (rotations[k].t - rotations[k-1].t), v );
+void Animation::sample(float time, AnimCursor *cursors) const{
+    PoseBuffer &b = pose_buffer;
+    AnimCursor fallback;
+    uint32_t count = channels.size();
+    b.resize(count);
+
+    for(uint32_t i = 0; i < count; ++i){
+        const AnimChannel &c = channels[i];
+        AnimCursor &cursor = channel_cursor(cursors, i, fallback);
+
+        vec3 p0, p1;
+        float factor;
+        b.has_pos[i] = c.keys_pos(time, cursor.pos, p0, p1, factor);
+        if(b.has_pos[i])
+            glm_vec3_lerp(p0, p1, factor, &b.pos[i*3]);
+
+        // Rotations are gathered and interpolated together below
+        versor q0, q1;
+        b.has_rot[i] = c.keys_rot(time, cursor.rot, q0, q1, b.factor[i]);
+        if(b.has_rot[i]){
+            b.from.set(i, q0);
+            b.to.set(i, q1);
+        }
+        else{
+            b.from.set_identity(i);
+            b.to.set_identity(i);
+            b.factor[i] = 0;
+        }
     }
+
+    QuatBatch::nlerp(b.from, b.to, b.factor.data(), b.rot, count);
 }
 
+void Animation::pose_set(Armature &a, float time, AnimCursor *cursors) const{
+    PoseBuffer &b = pose_buffer;
+    sample(time, cursors);
+    a.pose_changed = true;
+
+    for(uint32_t i = 0; i < channels.size(); ++i){
+        Joint &j = a.joints[channels[i].joint];
+        if(b.has_pos[i])
+            glm_vec3_copy(&b.pos[i*3], j.pos);
+        if(b.has_rot[i])
+            b.rot.get(i, j.rot);
+    }
+}
 
 /*
- * Animation
+ * Add the sampled pose scaled by mix_value on top of the current pose.
+ * Rotations are scaled by a slerp from identity rather than through their axis and angle.
  */
+void Animation::pose_add(Armature &a, float time, float mix_value, AnimCursor *cursors) const{
+    PoseBuffer &b = pose_buffer;
+    sample(time, cursors);
+    a.pose_changed = true;
+    uint32_t count = channels.size();
+
+    for(uint32_t i = 0; i < count; ++i){
+        Joint &j = a.joints[channels[i].joint];
+        if(b.has_pos[i])
+            glm_vec3_muladds(&b.pos[i*3], mix_value, j.pos);
+
+        // Channels without a rotation add the identity
+        b.from.set_identity(i);
+        b.factor[i] = b.has_rot[i] ? mix_value : 0;
+    }
+
+    QuatBatch::slerp(b.from, b.rot, b.factor.data(), b.to, count);
+
+    for(uint32_t i = 0; i < count; ++i)
+        b.from.set(i, a.joints[channels[i].joint].rot);
 
-void Animation::pose_set(Armature &a, float time){
-    for(AnimChannel &c : channels){
-        c.value_pos(time, a.joints[c.joint].pos);
-        c.value_rot(time, a.joints[c.joint].rot);
+    QuatBatch::mul(b.from, b.to, b.rot, count);
+
+    for(uint32_t i = 0; i < count; ++i){
+        if(b.has_rot[i])
+            b.rot.get(i, a.joints[channels[i].joint].rot);
     }
 }
 
-void Animation::pose_add(Armature &a, float time, float mix_value){
-    vec3 p;
-    versor r;
-    vec3 axis;
-    float angle;
-    for(AnimChannel &c : channels){
-        c.value_pos(time, p);
-        c.value_rot(time, r);
-        glm_vec3_muladds(p, mix_value, a.joints[c.joint].pos);
+void Animation::pose_mix( Armature &a, float time, float mix_value, AnimCursor *cursors ) const {
+    PoseBuffer &b = pose_buffer;
+    sample( time, cursors );
+    a.pose_changed = true;
+    uint32_t count = channels.size();
 
-        // Extract the axis and angle from the rotations
-        angle = glm_quat_angle(r);
-        glm_quat_axis(r,axis);
+    for( uint32_t i = 0; i < count; ++i ) {
+        Joint &j = a.joints[channels[i].joint];
+        if( b.has_pos[i] )
+            glm_vec3_lerp( j.pos, &b.pos[i*3], mix_value, j.pos );
 
-        // Scale the angle component only then apply on top of pose
-        angle *= mix_value;
-        glm_quatv(r, angle, axis);
-        glm_quat_mul(a.joints[c.joint].rot, r, a.joints[c.joint].rot);
+        b.from.set( i, j.rot );
+        b.factor[i] = b.has_rot[i] ? mix_value : 0;
     }
-}
 
-void Animation::pose_mix( Armature &a, float time, float mix_value ) {
-    vec3 p;
-    versor r;
+    QuatBatch::nlerp( b.from, b.rot, b.factor.data(), b.to, count );
 
-    for( AnimChannel &c : channels ) {
-        c.value_pos( time, p );
-        c.value_rot( time, r );
-        glm_vec3_lerp( a.joints[c.joint].pos, p, mix_value,  a.joints[c.joint].pos);
-        glm_quat_nlerp( a.joints[c.joint].rot, r, mix_value,  a.joints[c.joint].rot);
+    for( uint32_t i = 0; i < count; ++i ) {
+        if( b.has_rot[i] )
+            b.to.get( i, a.joints[channels[i].joint].rot );
     }
 }
 
@@ -128,70 +271,219 @@ void Animation::pose_mix( Armature &a, float time, float mix_value ) {
  * Armature
  */
 
-void Armature::assign_rest(){
-    if(joints.empty())
-        return;
+/*
+ * Local transforms of every joint, converted together before the hierarchy pass
+ */
+struct LocalBuffer {
+    QuatBatch::QuatArray rot;
+    std::vector<float> x, y, z;
+    std::unique_ptr<mat4[]> tr;
+    uint32_t capacity = 0;
+
+    void resize(uint32_t count){
+        rot.resize(count);
+        count = QuatBatch::QuatArray::padded(count);
+        x.resize(count, 0);
+        y.resize(count, 0);
+        z.resize(count, 0);
+
+        if(count > capacity){
+            tr = std::make_unique<mat4[]>(count);
+            capacity = count;
+        }
+    }
+};
 
-    // Clear the inverse rest of the root
-    glm_mat4_identity(joints[0].tr_inverse_rest);
+static thread_local LocalBuffer local_buffer;
 
-    for(uint8_t i = 1; i < joints.size(); ++i){
-        // Copy the inverse rest of the parent to the child
-        glm_mat4_copy(joints[joints[i].parent].tr_inverse_rest, joints[i].tr_inverse_rest);
+void Armature::update_hierarchy(uint32_t begin, uint32_t end){
+    const uint8_t *parents = info->get_parents();
+    mat4 *local = local_buffer.tr.get();
 
-        // Translate and rotate on top of the inverse rest
-        glm_translate(joints[i].tr_inverse_rest, joints[i].pos);
-        glm_quat_rotate(joints[i].tr_inverse_rest, joints[i].rot, joints[i].tr_inverse_rest);
-    }
-
-    // Inverse the rest transform now that they have all updated
-    for(uint8_t i = 1; i < joints.size(); ++i){
-        glm_inv_tr(joints[i].tr_inverse_rest);
+    for(uint32_t i = begin; i < end; ++i){
+        glm_mul(joints[parents[i]].tr, local[i], joints[i].tr);
+        glm_mul(joints[i].tr, (vec4*)info->get_joint(i).tr_inverse_rest, transform_buffer[i]);
     }
 }
 
-void Armature::update(float t){
+static std::atomic<uint32_t> palette_counter = 0;
+
+bool Armature::update(float t){
 
     // Update all animations
     update_animations(t);
 
+    // Softbodies keep moving after the pose stops
+    bool dynamic = false;
+    for(uint8_t c : constrained_joints)
+        dynamic |= constraints[joints[c].constraint_id]->type == Constraint::SOFTBODY;
+
+    // Keep the transform buffer when nothing that affects it changed
+    palette_updated = pose_changed || dynamic || memcmp(root_last, joints[0].tr, sizeof(mat4)) != 0;
+
+    if(!palette_updated)
+        return false;
+
+    pose_changed = false;
+    glm_mat4_copy(joints[0].tr, root_last);
+    palette_version = ++palette_counter;
+
+    // Constraints step at a fixed rate however long the update is
+    constraint_clock.advance(t);
+
     // Ignore root so it can be transformed by external functions
-    for(uint8_t i = 1; i < joints.size(); ++i){
-        Joint &j = joints[i];
+    glm_mul(joints[0].tr, (vec4*)info->get_joint(0).tr_inverse_rest, transform_buffer[0]);
+
+    // Batched chains are placed once they are stepped, unless a chain needs another placed first
+    update_transforms(1, dynamic && batch_softbodies && !nested_softbodies());
+    return true;
+}
 
-        // Update the local transform
-        glm_translate_make(j.tr, j.pos);
-        glm_quat_rotate(j.tr, j.rot, j.tr);
+bool Armature::nested_softbodies() const{
+    const uint8_t *parents = info->get_parents();
 
-        // Apply on top of parent (parents always have a lower index and have already updated)
-        glm_mul(joints[j.parent].tr, j.tr, j.tr);
+    for(uint8_t c : constrained_joints){
+        const Constraint *con = constraints[joints[c].constraint_id].get();
+        if(con->type != Constraint::SOFTBODY || ((const ConstraintSoftbody*)con)->parent_softbody)
+            continue;
 
-        // Apply constraints (if present)
-        if(j.constraint_id != 0){
-            constraints[j.constraint_id]->update(j, *this);
-            constraints[j.constraint_id]->apply(j, *this);
+        for(uint8_t p = parents[c]; p != 0; p = parents[p]){
+            if(constraints[joints[p].constraint_id]->type == Constraint::SOFTBODY)
+                return true;
         }
     }
+    return false;
+}
+
+void Armature::update_transforms(uint32_t first, bool defer_softbodies){
 
-    // Place into the transform buffer relative to the inverse transform
-    for(uint8_t i = 0; i < joints.size(); ++i){
-        glm_mat4_mul(joints[i].tr, joints[i].tr_inverse_rest, ((mat4*)transform_buffer.get())[i] );
+    // Convert all local transforms to matrices at once
+    LocalBuffer &b = local_buffer;
+    uint32_t count = joints.size();
+    b.resize(count);
+
+    for(uint32_t i = 0; i < count; ++i){
+        b.rot.set(i, joints[i].rot);
+        b.x[i] = joints[i].pos[0];
+        b.y[i] = joints[i].pos[1];
+        b.z[i] = joints[i].pos[2];
+    }
+
+    QuatBatch::to_mat4(b.rot, b.x.data(), b.y.data(), b.z.data(), b.tr.get(), count);
+
+    // Children of a constrained joint need the constrained transform, so the hierarchy runs up to each constrained joint
+    uint32_t begin = first;
+
+    for(uint8_t c : constrained_joints){
+        if(c < first)
+            continue;
+
+        update_hierarchy(begin, c + 1);
+
+        Joint &j = joints[c];
+        Constraint *con = constraints[j.constraint_id].get();
+
+        switch(con->type){
+            case Constraint::SOFTBODY:
+                ((ConstraintSoftbody*)con)->ConstraintSoftbody::update(j, *this);
+                if(defer_softbodies){
+                    begin = c + 1;
+                    continue;
+                }
+                ((ConstraintSoftbody*)con)->ConstraintSoftbody::apply(j, *this);
+                break;
+            case Constraint::TRACK:
+                ((ConstraintTrack*)con)->ConstraintTrack::update(j, *this);
+                ((ConstraintTrack*)con)->ConstraintTrack::apply(j, *this);
+                break;
+        }
+
+        // Replace the skinning transform now that the constraint moved the joint
+        glm_mul(j.tr, (vec4*)info->get_joint(c).tr_inverse_rest, transform_buffer[c]);
+        begin = c + 1;
+    }
+
+    if(!defer_softbodies)
+        update_hierarchy(begin, count);
+}
+
+/*
+ * Joints before the first softbody do not depend on the chains and are kept from the update.
+ * The transform buffer was already given a new version by the update.
+ */
+void Armature::update_softbodies(){
+    if(empty() || !palette_updated || !batch_softbodies)
+        return;
+
+    for(uint8_t c : constrained_joints){
+        if(constraints[joints[c].constraint_id]->type == Constraint::SOFTBODY){
+            update_transforms(c, false);
+            return;
+        }
     }
 }
 
+/*
+ * Dual quaternions cannot hold scale, the transforms are taken relative to the root
+ * and the shader applies the root transform after blending.
+ */
+const vec4 *Armature::get_dual_quaternions(){
+    if(empty())
+        return nullptr;
+
+    uint32_t count = joints.size();
+
+    if(!dual_quaternion_buffer)
+        dual_quaternion_buffer = std::make_unique<vec4[]>(count * 2);
+    else if(dual_quaternion_version == palette_version)
+        return dual_quaternion_buffer.get();
+
+    dual_quaternion_version = palette_version;
+
+    mat4 root_inverse, m;
+    glm_mat4_inv(joints[0].tr, root_inverse);
+
+    for(uint32_t i = 0; i < count; ++i){
+        float *real = dual_quaternion_buffer[i * 2];
+        float *dual = dual_quaternion_buffer[i * 2 + 1];
+
+        glm_mat4_mul(root_inverse, transform_buffer[i], m);
+
+        // Remove any scale left by the root before taking the rotation
+        glm_vec3_normalize(m[0]);
+        glm_vec3_normalize(m[1]);
+        glm_vec3_normalize(m[2]);
+        glm_mat4_quat(m, real);
+
+        // The dual part is half the translation times the rotation
+        versor translation = {m[3][0], m[3][1], m[3][2], 0};
+        glm_quat_mul(translation, real, dual);
+        glm_vec4_scale(dual, 0.5f, dual);
+    }
+
+    return dual_quaternion_buffer.get();
+}
+
+void Armature::add_constraint(uint8_t joint_id, std::unique_ptr<Constraint> c){
+    joints[joint_id].constraint_id = constraints.size();
+    constraints.push_back(std::move(c));
+    constrained_joints.insert(std::lower_bound(constrained_joints.begin(), constrained_joints.end(), joint_id), joint_id);
+}
+
 
-void Armature::assign_info(ArmatureInfo *info){
+void Armature::assign_info(const ArmatureInfo *info){
     info->get_aramture().copy(*this);
 }
 
-void Armature::copy(Armature &dest){
+void Armature::copy(Armature &dest) const{
     if(empty())
         return;
 
     dest.info = info;
 
-    // Reallocate transform buffer and copy data
-    dest.transform_buffer = std::unique_ptr<mat4>(new mat4[joints.size()]);
+    // Reallocate transform buffer only when the joint count changes
+    if(dest.joints.size() != joints.size() || !dest.transform_buffer)
+        dest.transform_buffer = std::make_unique<mat4[]>(joints.size());
     memcpy(dest.transform_buffer.get(), transform_buffer.get(), joints.size()*sizeof(mat4));
 
     // Delete all constraints
@@ -201,7 +493,23 @@ void Armature::copy(Armature &dest){
     for(const auto& c: constraints)
         dest.constraints.push_back(c->get_copy());
 
+    // Copied softbodies still point to their parent in this armature, link them to the copies
+    for(auto& c: dest.constraints){
+        if(c->type != Constraint::SOFTBODY)
+            continue;
+
+        ConstraintSoftbody *sb = (ConstraintSoftbody*)c.get();
+        if(sb->parent_softbody)
+            sb->parent_softbody = (ConstraintSoftbody*)dest.constraints[joints[sb->parent_joint].constraint_id].get();
+    }
+
+    // The copy always computes its own transform buffer and dual quaternions on the next update
+    dest.pose_changed = true;
+    dest.dual_quaternion_buffer = nullptr;
+
     // Copy joints and playing animations
+    dest.constrained_joints = constrained_joints;
+    dest.constraint_clock = constraint_clock;
     dest.joints = joints;
     dest.play_data = play_data;
 }
@@ -231,6 +539,8 @@ void Armature::play_animation(uint8_t anim, float speed, float start, float stop
         if(overwrite_method == PlayData::OVERWRITE){
             play_data[play_id].time = start;
         }
+
+        play_data[play_id].posed = false;
     }
 
     // Create a new animation
@@ -285,15 +595,17 @@ void Armature::reset_pose(){
     update(0);
 }
 
-void Armature::update_animations(float t){
+bool Armature::update_animations(float t){
     if(empty())
-        return;
+        return false;
+
+    // Mixing and adding start from the last pose, they only repeat the same pose when a set is below them
+    bool changed = !play_data.empty() && play_data[0].blend_method != PlayData::SET;
 
     // Update the animation times
     for(uint8_t i = 0; i < play_data.size(); ++i){
         PlayData &pd = play_data[i];
-        Animation &anim = info->get_animation(pd.animation_id);
-
+        float last_time = pd.time;
 
         // Update animation time
         pd.time += t*pd.speed;
@@ -304,6 +616,7 @@ void Armature::update_animations(float t){
                 case PlayData::END:
                     play_data.erase(play_data.begin()+i);
                     --i;
+                    changed = true;
                     continue;
 
                 case PlayData::BACK_LOOPED:
@@ -324,25 +637,45 @@ void Armature::update_animations(float t){
             }
         }
 
+        changed |= !pd.posed || pd.time != last_time;
+    }
+
+    if(!changed)
+        return false;
+
+    for(PlayData &pd : play_data){
+        const Animation &anim = info->get_animation(pd.animation_id);
+
+        // Cursors start at the first key, they correct themselves after the first sample
+        if(pd.cursors.size() != anim.channels.size())
+            pd.cursors.assign(anim.channels.size(), AnimCursor());
+
         // Apply the animation by posing the armature
         switch(pd.blend_method){
             case PlayData::SET:
-                anim.pose_set(*this, pd.time);
+                anim.pose_set(*this, pd.time, pd.cursors.data());
                 break;
             case PlayData::MIX:
-                anim.pose_mix(*this, pd.time, pd.blend_factor);
+                anim.pose_mix(*this, pd.time, pd.blend_factor, pd.cursors.data());
                 break;
             case PlayData::ADD:
-                anim.pose_add(*this, pd.time, pd.blend_factor);
+                anim.pose_add(*this, pd.time, pd.blend_factor, pd.cursors.data());
                 break;
         }
+
+        pd.posed = true;
     }
+
+    return true;
 }
 
 void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
     if(empty())
         return;
     Joint &j = joints[joint_id];
+    const JointInfo &ji = info->get_joint(joint_id);
+
+    pose_changed = true;
 
     // Update the settings of an already existing constraint
     if(j.constraint_id != 0 && constraints[j.constraint_id]->type == Constraint::SOFTBODY){
@@ -350,7 +683,7 @@ void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
         return;
     }
     else if(j.constraint_id != 0){
-        printf("Failed to add softbody: joint %s already has a constraint of another type\n", j.name.c_str());
+        printf("Failed to add softbody: joint %s already has a constraint of another type\n", ji.name.c_str());
         fflush(stdout);
         return;
     }
@@ -365,7 +698,7 @@ void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
         child_id = 0;
 
         // Forbid making a parent joint if more than one softbody chain would be made
-        for(uint8_t c : j.children){
+        for(uint8_t c : ji.children){
             Joint &child = joints[c];
             std::unique_ptr<Constraint> &cc = constraints[child.constraint_id];
 
@@ -374,7 +707,7 @@ void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
 
                 // A child was already set, do not add a constraint
                 if(child_constraint){
-                    printf("Failed to add softbody: joint %s has more than one constrained child\n",j.name.c_str());
+                    printf("Failed to add softbody: joint %s has more than one constrained child\n",ji.name.c_str());
                     fflush(stdout);
                     return;
                 }
@@ -386,7 +719,8 @@ void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
         }
 
         // Forbid placing a softbody on a parent that already has a chained softbody
-        Joint &parent = joints[j.parent];
+        Joint &parent = joints[ji.parent];
+        const JointInfo &parent_info = info->get_joint(ji.parent);
         std::unique_ptr<Constraint> &pc = constraints[parent.constraint_id];
 
         if(pc->type == Constraint::SOFTBODY){
@@ -396,7 +730,7 @@ void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
 
             // Sibling has a softbody
             if(((ConstraintSoftbody*)pc.get())->child_joint != 0){
-                printf("Failed to add softbody: joint %s has a sibling with a softbody constraint\n",j.name.c_str());
+                printf("Failed to add softbody: joint %s has a sibling with a softbody constraint\n",ji.name.c_str());
                 fflush(stdout);
                 return;
             }
@@ -405,19 +739,19 @@ void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
 
                 // Create relationship
                 ((ConstraintSoftbody*)pc.get())->child_joint = joint_id;
-                sb.parent_joint = j.parent;
+                sb.parent_joint = ji.parent;
 
                 // Find the rest positions of the joints to use as joint length
                 mat4 tr;
                 vec3 head, tail;
-                glm_mat4_inv(parent.tr_inverse_rest, tr);
+                glm_mat4_inv((vec4*)parent_info.tr_inverse_rest, tr);
                 glm_vec3_copy(tr[3],head);
-                glm_mat4_inv(j.tr_inverse_rest, tr);
+                glm_mat4_inv((vec4*)ji.tr_inverse_rest, tr);
                 glm_vec3_copy(tr[3],tail);
 
                 ((ConstraintSoftbody*)pc.get())->settings.joint_length = glm_vec3_distance(head, tail);
 
-                printf("%s %f\n", parent.name.c_str(), ((ConstraintSoftbody*)pc.get())->settings.joint_length);
+                printf("%s %f\n", parent_info.name.c_str(), ((ConstraintSoftbody*)pc.get())->settings.joint_length);
                 fflush(stdout);
             }
         }
@@ -434,27 +768,32 @@ void Armature::constraint_softbody(uint8_t joint_id, SoftbodySettings settings){
             // Use this child to determine joint length
             mat4 tr;
             vec3 head, tail;
-            glm_mat4_inv(j.tr_inverse_rest, tr);
+            glm_mat4_inv((vec4*)ji.tr_inverse_rest, tr);
             glm_vec3_copy(tr[3],head);
-            glm_mat4_inv(joints[child_id].tr_inverse_rest, tr);
+            glm_mat4_inv((vec4*)info->get_joint(child_id).tr_inverse_rest, tr);
             glm_vec3_copy(tr[3],tail);
             sb.settings.joint_length = glm_vec3_distance(head, tail);
         }
 
         // If there is a single child present, use its position for joint length
-        else if(j.children.size() == 1){
+        else if(ji.children.size() == 1){
             mat4 tr;
             vec3 head, tail;
-            glm_mat4_inv(j.tr_inverse_rest, tr);
+            glm_mat4_inv((vec4*)ji.tr_inverse_rest, tr);
             glm_vec3_copy(tr[3],head);
-            glm_mat4_inv(joints[j.children[0]].tr_inverse_rest, tr);
+            glm_mat4_inv((vec4*)info->get_joint(ji.children[0]).tr_inverse_rest, tr);
             glm_vec3_copy(tr[3],tail);
             sb.settings.joint_length = glm_vec3_distance(head, tail);
         }
 
         // Place into the constraint list
-        j.constraint_id = constraints.size();
-        constraints.push_back(std::make_unique<ConstraintSoftbody>(sb));
+        add_constraint(joint_id, std::make_unique<ConstraintSoftbody>(sb));
+
+        // Chains changed, they restart from rest on the next update
+        for(uint8_t c : constrained_joints){
+            if(constraints[joints[c].constraint_id]->type == Constraint::SOFTBODY)
+                ((ConstraintSoftbody*)constraints[joints[c].constraint_id].get())->initialized = false;
+        }
 
         // Link the child to the new constraint (if present)
         if(child_constraint){
@@ -467,6 +806,8 @@ void Armature::constraint_track(uint8_t joint_id, vec3 focus, uint8_t axis, bool
     if(empty())
         return;
     Joint &j = joints[joint_id];
+    pose_changed = true;
+
     if(j.constraint_id != 0){
         if( constraints[j.constraint_id]->type == Constraint::TRACK){
             glm_vec3_copy(focus, ((ConstraintTrack*)constraints[j.constraint_id].get())->focus);
@@ -474,18 +815,18 @@ void Armature::constraint_track(uint8_t joint_id, vec3 focus, uint8_t axis, bool
             ((ConstraintTrack*)constraints[j.constraint_id].get())->neg = negate;
         }
         else{
-            printf("Failed to add track: joint %s already has a constraint\n",j.name.c_str());
+            printf("Failed to add track: joint %s already has a constraint\n",info->get_joint(joint_id).name.c_str());
             fflush(stdout);
             return;
         }
     }
     else{
         ConstraintTrack c;
+        c.joint = joint_id;
         glm_vec3_copy(focus, c.focus);
         c.fx = axis;
         c.neg = negate;
-        j.constraint_id = constraints.size();
-        constraints.push_back(std::make_unique<ConstraintTrack>(c));
+        add_constraint(joint_id, std::make_unique<ConstraintTrack>(c));
     }
 }
 
@@ -493,7 +834,7 @@ void Armature::constraint_track(uint8_t joint_id, vec3 focus, uint8_t axis, bool
  * Armature Info
  */
 
-bool ArmatureInfo::load( const std::string &filename ) {
+bool ArmatureInfo::load( const std::string &filename, bool compress_animations ) {
     std::string filepath = ( std::string )DIR_ARMATURES + filename + ".arm";
     std::ifstream filereader;
     filereader.open( filepath, std::ios::out | std::ios::binary );
@@ -504,14 +845,10 @@ bool ArmatureInfo::load( const std::string &filename ) {
     }
 
     // Clear old data
-    armature = Armature();
-    armature.info = this;
-    joint_names.clear();
-    animation_names.clear();
-    animations = {Animation()};
+    clear();
 
     // Read number of joints
-    uint8_t joint_count, name_length, children_count;
+    uint8_t joint_count, name_length, children_count, parent;
     filereader.read( reinterpret_cast<char *>( &joint_count ), 1 );
 
     if( joint_count > ARMATURE_MAX_JOINTS ) {
@@ -522,34 +859,34 @@ bool ArmatureInfo::load( const std::string &filename ) {
 
     // Joints
     for( uint8_t i = 0; i < joint_count; ++i ) {
-        Joint joint;
+        std::string name;
+        vec3 pos;
+        versor rot;
 
         // Name
         filereader.read( reinterpret_cast<char *>( &name_length ), 1 );
         filereader.read( buffer, name_length );
-        joint.name.assign( buffer, name_length );
+        name.assign( buffer, name_length );
 
         // Parent
-        filereader.read( reinterpret_cast<char *>( &joint.parent ), 1 );
+        filereader.read( reinterpret_cast<char *>( &parent ), 1 );
 
-        // Children
+        // Children, these are rebuilt from the parents
         filereader.read( reinterpret_cast<char *>( &children_count ), 1 );
         filereader.read( buffer, children_count );
-        joint.children.assign( buffer, buffer + children_count );
 
         // Position and Rotation
-        filereader.read( reinterpret_cast<char *>( joint.pos ), 12 );
-        filereader.read( reinterpret_cast<char *>( joint.rot ), 16 );
+        filereader.read( reinterpret_cast<char *>( pos ), 12 );
+        filereader.read( reinterpret_cast<char *>( rot ), 16 );
 
         // Add to armature
-        if( armature.joints.size() < ARMATURE_MAX_JOINTS ) {
-            armature.joints.push_back( joint );
-            joint_names[joint.name] = armature.joints.size() - 1;
+        if( joints.size() < ARMATURE_MAX_JOINTS && !add_joint( name, parent, pos, rot ) ) {
+            std::cout << "Invalid parent for joint " << name << " in armature file: " << filepath << std::endl;
+            clear();
+            return false;
         }
     }
 
-    armature.transform_buffer = std::unique_ptr<mat4>(new mat4[armature.joints.size()]);
-
     // Animations
     uint8_t animation_count, channel_count;
     uint32_t poskey_count, rotkey_count;
@@ -581,22 +918,27 @@ bool ArmatureInfo::load( const std::string &filename ) {
             filereader.read( reinterpret_cast<char *>( &poskey_count ), 4 );
             filereader.read( reinterpret_cast<char *>( &rotkey_count ), 4 );
 
-            // Position
-            channel.positions.resize( poskey_count );
+            // Position, keys are stored as time then value
+            channel.pos_times.resize( poskey_count );
+            channel.pos_values.resize( poskey_count * 3 );
 
             for( unsigned int k = 0; k < poskey_count; ++k ) {
-                filereader.read( reinterpret_cast<char *>( &channel.positions[k].t ), 4 );
-                filereader.read( reinterpret_cast<char *>( &channel.positions[k].pos ), 12 );
+                filereader.read( reinterpret_cast<char *>( &channel.pos_times[k] ), 4 );
+                filereader.read( reinterpret_cast<char *>( channel.pos_key( k ) ), 12 );
             }
 
             // Rotation
-            channel.rotations.resize( rotkey_count );
+            channel.rot_times.resize( rotkey_count );
+            channel.rot_values.resize( rotkey_count * 4 );
 
             for( unsigned int k = 0; k < rotkey_count; ++k ) {
-                filereader.read( reinterpret_cast<char *>( &channel.rotations[k].t ), 4 );
-                filereader.read( reinterpret_cast<char *>( &channel.rotations[k].rot ), 16 );
+                filereader.read( reinterpret_cast<char *>( &channel.rot_times[k] ), 4 );
+                filereader.read( reinterpret_cast<char *>( channel.rot_key( k ) ), 16 );
             }
 
+            if( compress_animations )
+                channel.compress( ANIMATION_POS_TOLERANCE, ANIMATION_ROT_TOLERANCE );
+
             animation.channels.push_back( channel );
         }
 
@@ -606,8 +948,62 @@ bool ArmatureInfo::load( const std::string &filename ) {
 
     filereader.close();
 
-    // Construct armature rest transforms
-    armature.assign_rest();
+    return true;
+}
+
+void ArmatureInfo::clear() {
+    armature = Armature();
+    armature.info = this;
+    joints.clear();
+    parents.clear();
+    joint_names.clear();
+    animation_names.clear();
+    animations = {Animation()};
+}
+
+bool ArmatureInfo::add_joint( const std::string &name, uint8_t parent, vec3 pos, versor rot ) {
+    uint8_t id = joints.size();
+
+    // The root is its own parent, every other parent needs a lower index so the hierarchy updates in order
+    if( id == 0 )
+        parent = 0;
+    else if( parent >= id )
+        return false;
+
+    JointInfo joint_info;
+    joint_info.name = name;
+    joint_info.parent = parent;
+
+    // The rest transform is the rest of the parent with the joint applied, the root keeps an identity inverse rest
+    if( id != 0 ) {
+        mat4 rest;
+        glm_mat4_copy( joints[parent].tr_inverse_rest, rest );
+        glm_inv_tr( rest );
+        glm_translate( rest, pos );
+        glm_quat_rotate( rest, rot, rest );
+        glm_inv_tr( rest );
+        glm_mat4_copy( rest, joint_info.tr_inverse_rest );
+        joints[parent].children.push_back( id );
+    }
+
+    Joint joint;
+    glm_vec3_copy( pos, joint.pos );
+    glm_quat_copy( rot, joint.rot );
+
+    joint_names[name] = id;
+    joints.push_back( std::move( joint_info ) );
+    parents.push_back( parent );
+    armature.joints.push_back( joint );
+    armature.transform_buffer = std::make_unique<mat4[]>( joints.size() );
 
     return true;
 }
+
+uint64_t ArmatureInfo::get_animation_memory() const {
+    uint64_t size = 0;
+
+    for( const Animation &a : animations )
+        size += a.memory_size();
+
+    return size;
+}
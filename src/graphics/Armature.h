@@ -14,41 +14,86 @@
 
 class Armature;
 class ArmatureInfo;
+class SoftbodySystem;
 struct Animation;
 
-struct KeyPos {
-    vec3 pos = GLM_VEC3_ZERO_INIT;
-    float t = 0;
-};
-
-struct KeyRot {
-    versor rot =  GLM_QUAT_IDENTITY_INIT;
-    float t = 0;
+/*
+ * The keys last used by a playing animation in a channel.
+ * Each holds the index of the first key after the sampled time, so sampling forward in time
+ * only steps over the keys passed since the last sample.
+ */
+struct AnimCursor {
+    uint32_t pos = 0;
+    uint32_t rot = 0;
 };
 
+/*
+ * Keys are stored with their times apart from their values, so key searches only read times.
+ * Position keys are 3 floats and rotation keys 4 floats in the value arrays.
+ * Compressed channels have fewer keys and hold quantized values instead of floats:
+ * positions are 16 bits per component within the channel bounds,
+ * rotations are the 3 smallest components at 15 bits each with the index of the largest.
+ */
 struct AnimChannel {
     uint8_t joint;
-    std::vector<KeyPos> positions;
-    std::vector<KeyRot> rotations;
+    std::vector<float> pos_times;
+    std::vector<float> pos_values;
+    std::vector<float> rot_times;
+    std::vector<float> rot_values;
+
+    bool compressed = false;
+    vec3 pos_min = GLM_VEC3_ZERO_INIT;
+    vec3 pos_extent = GLM_VEC3_ZERO_INIT;
+    std::vector<uint16_t> pos_quantized;
+    std::vector<uint16_t> rot_quantized;
+
+    inline float *pos_key(uint32_t k){return pos_values.data() + k*3;}
+    inline float *rot_key(uint32_t k){return rot_values.data() + k*4;}
+
+    // Read a key as floats from either storage
+    void get_pos_key(uint32_t k, vec3 v) const;
+    void get_rot_key(uint32_t k, versor q) const;
 
     // Get the value at a given time t in the channel
-    void value_pos(float t, vec3 v);
-    void value_rot(float t, versor v);
+    void value_pos(float t, vec3 v) const;
+    void value_rot(float t, versor v) const;
+
+    // Same as above, starting the key search from a cursor and updating it
+    void value_pos(float t, vec3 v, uint32_t &cursor) const;
+    void value_rot(float t, versor v, uint32_t &cursor) const;
+
+    // Get the pair of keys and the factor between them at time t, false if t is before the first key
+    bool keys_pos(float t, uint32_t &cursor, vec3 from, vec3 to, float &factor) const;
+    bool keys_rot(float t, uint32_t &cursor, versor from, versor to, float &factor) const;
+
+    // Remove keys that interpolation reproduces within the tolerances, then quantize the rest
+    void compress(float pos_tolerance, float rot_tolerance);
+
+    // Bytes used by the keys
+    uint64_t memory_size() const;
 };
 
+/*
+ * Animations are owned by the armature info and shared by every armature using it, posing only reads them.
+ */
 struct Animation {
     std::string name;
     float duration = 0;
     std::vector<AnimChannel> channels;
 
+    // Sample every channel at time t into the pose buffer, the rotations of all channels are interpolated together
+    void sample(float time, AnimCursor *cursors) const;
+
     // Set pose to match that at time t
-    void pose_set(Armature &a, float time);
+    void pose_set(Armature &a, float time, AnimCursor *cursors = nullptr) const;
 
     // Add scaled pos at time t on to the current pose
-    void pose_add(Armature &a, float time, float mix_value);
+    void pose_add(Armature &a, float time, float mix_value, AnimCursor *cursors = nullptr) const;
 
     // Mix the current pose with the pose at time t
-    void pose_mix(Armature &a, float time, float mix_value);
+    void pose_mix(Armature &a, float time, float mix_value, AnimCursor *cursors = nullptr) const;
+
+    uint64_t memory_size() const;
 };
 
 struct PlayData {
@@ -86,19 +131,37 @@ struct PlayData {
     uint8_t animation_id = 0;
     uint8_t end_method = END;
     uint8_t blend_method = SET;
+
+    // Whether the armature has been posed at the current time, a paused or clamped animation is not posed again
+    bool posed = false;
+
+    // Key search cursors for each channel of the animation
+    std::vector<AnimCursor> cursors;
 };
 
 
 
-struct Joint{
+/*
+ * The parts of a joint that are the same for every armature of an armature info.
+ * Parents always have a lower index than their children.
+ */
+struct JointInfo{
 
     std::string name;
     std::vector<uint8_t> children;
-    uint8_t parent;
-    uint8_t constraint_id = 0;
-    uint8_t animation_applications = 0;
+    uint8_t parent = 0;
 
     mat4 tr_inverse_rest = GLM_MAT4_IDENTITY_INIT;
+
+};
+
+/*
+ * The pose of a joint in a single armature, plain data so copying an armature only copies arrays.
+ */
+struct Joint{
+
+    uint8_t constraint_id = 0;
+
     mat4 tr = GLM_MAT4_IDENTITY_INIT;
 
     vec3 pos = GLM_VEC3_ZERO_INIT;
@@ -110,38 +173,84 @@ struct Joint{
 class Armature {
     friend ArmatureInfo;
     friend Animation;
+    friend SoftbodySystem;
 
-    ArmatureInfo *info = nullptr;
+    const ArmatureInfo *info = nullptr;
     std::vector<std::unique_ptr<Constraint>> constraints;
 
-    // Applies all playing animations
-    void update_animations(float t);
+    // Joints with a constraint in increasing order
+    std::vector<uint8_t> constrained_joints;
+
+    // Places a constraint into the constraint list and assigns it to a joint
+    void add_constraint(uint8_t joint_id, std::unique_ptr<Constraint> c);
+
+    // Multiplies each joint in [begin, end) by its parent and writes its skinning transform
+    void update_hierarchy(uint32_t begin, uint32_t end);
+
+    // Builds the transforms of every joint from first on, running the constraints on the way
+    // Deferred softbodies only record their animated pose, joints from the last constrained joint on are left for update_softbodies
+    void update_transforms(uint32_t first, bool defer_softbodies);
+
+    // Whether a softbody chain starts below a joint moved by another chain, its animated pose then depends on the other chain
+    bool nested_softbodies() const;
+
+    // Applies all playing animations, returns false when the animations would give the same pose as the last update
+    bool update_animations(float t);
+
+    // Set when the local pose changes, the root transform and softbodies are checked separately
+    bool pose_changed = true;
+    bool palette_updated = false;
+    mat4 root_last = GLM_MAT4_ZERO_INIT;
+
+    // Changes whenever the transform buffer changes, unique across all armatures
+    uint32_t palette_version = 0;
+
+    // Skinning transforms relative to the root as dual quaternions, a real and dual part per joint
+    std::unique_ptr<vec4[]> dual_quaternion_buffer = nullptr;
+    uint32_t dual_quaternion_version = 0;
 
 public:
 
     // This is used for constraints, this does NOT change the actual scale
     float scale_constraint = 1;
 
+    // Fixed steps of the softbody constraints, the timestep can be changed per armature
+    ConstraintClock constraint_clock;
+
+    // Softbody chains are left to a SoftbodySystem stepping many armatures, update_softbodies places them afterwards
+    bool batch_softbodies = false;
+
     Armature(){
         // Add the null constraint since the default constraint id is 0
         constraints.push_back(std::unique_ptr<Constraint>(new Constraint()));
     }
 
     std::vector<Joint> joints;
-    std::unique_ptr<mat4> transform_buffer = nullptr;
+    std::unique_ptr<mat4[]> transform_buffer = nullptr;
     std::vector<PlayData> play_data;
 
-    // Assigns the current transform for all joints as the new rest transform
-    void assign_rest();
-
     // Applies all animations, constraints, and updates the transform buffer
-    void update(float t);
+    // Nothing is recomputed when no animation, constraint or root transform changed, returns whether the transform buffer changed
+    bool update(float t);
+
+    // Rebuilds the joints from the first softbody on once a SoftbodySystem has stepped the chains
+    void update_softbodies();
+
+    // Forces the next update to recompute the transform buffer, needed after changing joints directly
+    inline void mark_changed(){ pose_changed = true; }
+
+    // Whether the last update changed the transform buffer
+    inline bool is_palette_updated() const{ return palette_updated; }
+    inline uint32_t get_palette_version() const{ return palette_version; }
+
+    // The transform buffer as dual quaternions relative to the root transform, converted when the buffer has changed
+    const vec4 *get_dual_quaternions();
 
-    // Assigns an armature to an armature info
-    void assign_info(ArmatureInfo *info);
+    // Assigns an armature to an armature info, starting from its rest pose
+    void assign_info(const ArmatureInfo *info);
 
-    // Copies an armature to another
-    void copy(Armature &dest);
+    // Copies an armature to another, the joint names, hierarchy and animations stay shared through the info
+    void copy(Armature &dest) const;
 
     // Adds a new playing animation
     void play_animation(uint8_t anim,float speed, float start, float stop, uint8_t end_method, uint8_t blend_method, float blend_factor, uint8_t overwrite_method, bool add_bottom = false);
@@ -158,22 +267,30 @@ public:
     // Resets the pose to 0, displays the rest pose
     void reset_pose();
 
-    // Add a softbody constraint (can't be removed)
+    // Add a softbody constraint (can't be removed), softbodies move on their own so their armatures update every frame
     void constraint_softbody(uint8_t joint_id, SoftbodySettings settings);
     void constraint_track(uint8_t joint_id, vec3 focus, uint8_t axis, bool negate);
 
     // Must be initialized, otherwise will crash
     inline Joint& get_root(){return joints[0];}
     inline Joint& get_joint(uint8_t joint_id){return joints[joint_id];}
-    inline ArmatureInfo* get_info() const{ return info; }
-    inline bool empty(){return !transform_buffer || !info || joints.empty();}
+    inline const ArmatureInfo* get_info() const{ return info; }
+    inline bool empty() const{return !transform_buffer || !info || joints.empty();}
     inline Constraint* get_constraint(uint8_t id){ if( id == 0 || id >= constraints.size())return nullptr;return constraints[id].get();}
 
 
 };
 
+/*
+ * Everything loaded from an armature file, shared by every armature assigned to it and not changed after loading.
+ * The armature held here is in the rest pose and is copied to create new armatures.
+ */
 class ArmatureInfo {
     Armature armature;
+    std::vector<JointInfo> joints;
+
+    // Parent of each joint, parents always have a lower index than their children
+    std::vector<uint8_t> parents;
 
     // Place an empty animation at the start of the list for null
     std::vector<Animation> animations =  {Animation()};
@@ -183,14 +300,30 @@ class ArmatureInfo {
 
 public:
 
-    inline Armature &get_aramture(){
+    ArmatureInfo(){
+        armature.info = this;
+    }
+
+    inline const Armature &get_aramture() const{
         return armature;
     }
 
-    inline Animation &get_animation(uint8_t id){
+    inline const JointInfo &get_joint(uint8_t id) const{
+        return joints[id];
+    }
+
+    inline const uint8_t *get_parents() const{
+        return parents.data();
+    }
+
+    inline const Animation &get_animation(uint8_t id) const{
         return animations[id];
     }
 
+    inline uint8_t get_animation_count() const{
+        return animations.size();
+    }
+
     inline uint8_t get_animation_id(const std::string& name) const{
         try{
             return animation_names.at(name);
@@ -209,7 +342,17 @@ public:
         }
     }
 
-    bool load(const std::string& filename);
+    // Loads the joints and animations, animation keys are compressed unless disabled
+    bool load(const std::string& filename, bool compress_animations = ANIMATION_COMPRESSION);
+
+    // Bytes used by the keys of all animations
+    uint64_t get_animation_memory() const;
+
+    // Removes all joints and animations
+    void clear();
+
+    // Adds a joint with its rest transform relative to the parent, the parent must already be added
+    bool add_joint(const std::string &name, uint8_t parent, vec3 pos, versor rot);
 
 
 };
@@ -1,80 +1,124 @@
 #include "ArmatureConstraints.h"
 #include "Armature.h"
+#include "SoftbodySystem.h"
+#include <cmath>
+#include <cstring>
 
 
-void ConstraintSoftbody::update(Joint &j, Armature& arm){
-
-    // Declare the head position of this constraint
-    vec3 head;
-
-    // If the contraint has a parent, use parent tail as head
-    if( parent_softbody )
-        glm_vec3_copy( parent_softbody->tail, head);
-
-    // Use joint transform otherwise
-    else
-        glm_vec3_copy(j.tr[3], head);
+/*
+ * Constraint Clock
+ */
 
+void ConstraintClock::advance(float t){
+    frame_start = accumulated;
+    frame_time = t;
+    accumulated += t;
 
-    // Set the absolute velocity to the difference in tail position
-    vec3 abs_vel;
-    glm_vec3_sub(tail, last_tail, abs_vel);
+    substeps = accumulated / timestep;
 
-    // Localize the absolute velocity by removing the head component
-    vec3 local_vel = GLM_VEC3_ZERO_INIT;
-    glm_vec3_sub(abs_vel, head, local_vel);
+    // Drop the time that does not fit rather than falling further behind
+    if(substeps > ARMATURE_CONSTRAINT_MAX_SUBSTEPS){
+        frame_start -= (substeps - ARMATURE_CONSTRAINT_MAX_SUBSTEPS) * timestep;
+        substeps = ARMATURE_CONSTRAINT_MAX_SUBSTEPS;
+    }
 
-    // Add the previous animation position (acts as animated velocity)
-    glm_vec3_add(local_vel, last_anim_pos, local_vel);
+    accumulated -= substeps * timestep;
+    alpha = glm_clamp(accumulated / timestep, 0, 1);
+}
 
-    // Save the head as the last animated position for the next frame
-    glm_vec3_copy(head, last_anim_pos);
+float ConstraintClock::substep_fraction(uint32_t substep) const{
+    if(frame_time <= 0)
+        return 1;
+    return glm_clamp(((substep + 1) * timestep - frame_start) / frame_time, 0, 1);
+}
 
-    // Remove the local component from the absolute velocity
-    glm_vec3_sub(abs_vel, local_vel, abs_vel);
+/*
+ * Softbody
+ */
 
-    // Save the tail before updating it
-    glm_vec3_copy(tail, last_tail);
+ConstraintSoftbody *ConstraintSoftbody::get_child(Armature &arm){
+    if(child_joint == 0)
+        return nullptr;
+    return (ConstraintSoftbody*)arm.get_constraint(arm.get_joint(child_joint).constraint_id);
+}
 
-    /*
-     * Update the tail position.
-     * This approximation applies air drag to the absolute velocity
-     * friction to the local velocity
-     * and gravity acceleration
-     */
+// Settings are an amount per reference step, this is the same amount over a step of length h
+static inline float per_step(float amount, float h){
+    return 1 - powf(1 - amount, h / softbody_reference_step);
+}
 
-    tail[0] += ((1-settings.drag)) * abs_vel[0] + (1-settings.friction) * local_vel[0];
-    tail[1] += ((1-settings.drag)) * abs_vel[1] + (1-settings.friction) * local_vel[1] - settings.gravity * timestep_sqr;
-    tail[2] += ((1-settings.drag)) * abs_vel[2] + (1-settings.friction) * local_vel[2];
+const ConstraintSoftbody::StepAmounts &ConstraintSoftbody::get_step_amounts(float h){
+    if(h == step_length && memcmp(&settings, &step_settings, sizeof(SoftbodySettings)) == 0)
+        return step_amounts;
 
-    // Length elasticity
+    float r = h / softbody_reference_step;
+    step_amounts.keep_drag = 1 - per_step(settings.drag, h);
+    step_amounts.keep_friction = 1 - per_step(settings.friction, h);
+    step_amounts.gravity = settings.gravity * softbody_gravity_scale * r * r;
+    step_amounts.elasticity = per_step(settings.elasticity, h);
+    step_amounts.rigidity = per_step(settings.rigidity, h);
 
-    // Extract tail in local space
-    vec3 ideal_tail;
-    glm_vec3_sub(tail, head, ideal_tail);
+    step_length = h;
+    step_settings = settings;
+    return step_amounts;
+}
 
-    // Scale the tail to match that of the joint length
-    glm_vec3_scale(ideal_tail, arm.scale_constraint*settings.joint_length / (glm_vec3_norm(ideal_tail) + GLM_FLT_EPSILON), ideal_tail);
+/*
+ * Records the animated head and rotation of the first joint, the chain is stepped from them by a SoftbodySystem.
+ * An armature that is not batched steps its chain here, alone in a system of its own.
+ */
+void ConstraintSoftbody::update(Joint &j, Armature& arm){
 
-    // Place tail back in global space
-    glm_vec3_add(ideal_tail, head, ideal_tail);
+    // Joints further down are stepped with the first joint of their chain
+    if(parent_softbody)
+        return;
 
-    // Lerp correction using elasticity as factor
-    glm_vec3_sub(ideal_tail, tail, ideal_tail);
-    glm_vec3_scale(ideal_tail, settings.elasticity, ideal_tail);
-    glm_vec3_add(tail, ideal_tail, tail);
+    float scale = arm.scale_constraint;
+    vec3 up = {0, 1, 0};
 
-    // Restoration using rigidity
+    // Animated head and rotation of the first joint, scale is removed from the rotation
+    mat4 m;
+    glm_vec3_copy(j.tr[3], anim_head);
+    glm_mat4_copy(j.tr, m);
+    glm_vec3_normalize(m[0]);
+    glm_vec3_normalize(m[1]);
+    glm_vec3_normalize(m[2]);
+    glm_mat4_quat(m, anim_rot);
+
+    // Start at rest, with every tail along its joint
+    if(!initialized){
+        vec3 link_head;
+        versor link_rot;
+        glm_vec3_copy(anim_head, link_head);
+        glm_quat_copy(anim_rot, link_rot);
+
+        for(ConstraintSoftbody *c = this; c; c = c->get_child(arm)){
+            glm_quat_rotatev(link_rot, up, c->tail);
+            glm_vec3_scale(c->tail, scale * c->settings.joint_length, c->tail);
+            glm_vec3_add(c->tail, link_head, c->tail);
+            glm_vec3_copy(c->tail, c->last_tail);
+            glm_vec3_copy(c->tail, c->render_tail);
+            glm_vec3_copy(link_head, c->last_anim_pos);
+            glm_vec3_copy(c->tail, link_head);
+
+            ConstraintSoftbody *child = c->get_child(arm);
+            if(child)
+                glm_quat_mul(link_rot, arm.get_joint(child->joint).rot, link_rot);
+        }
+
+        glm_vec3_copy(anim_head, last_head);
+        glm_quat_copy(anim_rot, last_rot);
+        initialized = true;
+    }
 
-    // Reuse ideal tail position, extract as the +y-basis column of the transform
-    // Rigidity will attempt to return to the original rotation
-    glm_vec3_scale(j.tr[1], arm.scale_constraint*settings.joint_length, ideal_tail);
-    glm_vec3_add(ideal_tail, j.tr[3], ideal_tail);
+    if(arm.batch_softbodies)
+        return;
 
-    // Lerp correction using rigidity as factor
-    glm_vec3_sub(ideal_tail, tail, ideal_tail);
-    glm_vec3_scale(ideal_tail, settings.rigidity, ideal_tail);
-    glm_vec3_add(tail, ideal_tail, tail);
+    static thread_local SoftbodySystem single;
+    single.thread_count = 1;
+    single.clear();
+    single.add_chain(arm, this);
+    single.solve();
 }
 
 void ConstraintSoftbody::apply(Joint &j, Armature& arm){
@@ -86,7 +130,7 @@ void ConstraintSoftbody::apply(Joint &j, Armature& arm){
     vec3 head;
     // If there is a parent, use its tail
     if(parent_softbody){
-        glm_vec3_copy(parent_softbody->tail, head);
+        glm_vec3_copy(parent_softbody->render_tail, head);
     }
     // Otherwise use the joint transform
     else{
@@ -97,7 +141,7 @@ void ConstraintSoftbody::apply(Joint &j, Armature& arm){
 
     // Find vector to tail
     vec3 to_tail;
-    glm_vec3_sub(tail, head, to_tail);
+    glm_vec3_sub(render_tail, head, to_tail);
 
     // Normalize to_tail (forward should already be normalized)
     glm_vec3_normalize(to_tail);
@@ -123,7 +167,7 @@ void ConstraintTrack::update(Joint &j, Armature& arm){
 
     versor r;
     vec3 pos;
-    glm_mat4_mulv3(j.tr_inverse_rest, up, 0, up);
+    glm_mat4_mulv3((vec4*)arm.get_info()->get_joint(joint).tr_inverse_rest, up, 0, up);
 
     // Deconstructed forp, uses +x forward instead of +z forward, fx changes the axis
     vec3 dir;
@@ -4,7 +4,9 @@
 #include <vector>
 #include <inttypes.h>
 #include <cglm/vec3.h>
+#include <cglm/quat.h>
 #include <memory>
+#include "definitions.h"
 
 struct Joint;
 class Armature;
@@ -27,8 +29,33 @@ struct Constraint{
     inline virtual std::unique_ptr<Constraint> get_copy(){return std::unique_ptr<Constraint>(new Constraint());}
 };
 
-const static float timestep = 0.02f;
-const static float timestep_sqr = timestep * timestep;
+/*
+ * Softbody settings are amounts per step of this length, they were tuned at one step per frame.
+ * Other step lengths scale them so a chain behaves the same at any step length.
+ */
+const static float softbody_reference_step = 1.0f / FPS;
+const static float softbody_gravity_scale = 0.02f * 0.02f;
+
+/*
+ * Fixed steps of the constraints of an armature, time is accumulated across updates.
+ * Each update runs the whole steps that fit, what is left over interpolates between the last two steps.
+ */
+struct ConstraintClock{
+    float timestep = ARMATURE_CONSTRAINT_TIMESTEP;
+
+    // Time carried over from previous updates and the time of the current update
+    float accumulated = 0;
+    float frame_start = 0;
+    float frame_time = 0;
+
+    uint32_t substeps = 0;
+    float alpha = 0;
+
+    void advance(float t);
+
+    // Fraction of the current update at the end of a substep
+    float substep_fraction(uint32_t substep) const;
+};
 
 struct SoftbodySettings{
     float elasticity = 0.7;
@@ -48,15 +75,47 @@ struct ConstraintSoftbody : public Constraint{
     vec3 last_tail = GLM_VEC3_ZERO_INIT;
     vec3 last_anim_pos = GLM_VEC3_ZERO_INIT;
 
+    // Tail between the last two steps at the time of the update, used to place the joint
+    vec3 render_tail = GLM_VEC3_ZERO_INIT;
+
+    // Animated head and rotation of the first joint of a chain at this update and the last
+    vec3 anim_head = GLM_VEC3_ZERO_INIT;
+    versor anim_rot = GLM_QUAT_IDENTITY_INIT;
+    vec3 last_head = GLM_VEC3_ZERO_INIT;
+    versor last_rot = GLM_QUAT_IDENTITY_INIT;
+    bool initialized = false;
+
     SoftbodySettings settings;
 
     ConstraintSoftbody *parent_softbody = nullptr;
     uint8_t parent_joint = 0;
     uint8_t child_joint = 0;
 
+    // The first joint of a chain steps the whole chain, joints further down the chain only place themselves
+    // Chains of an armature with batch_softbodies set are stepped later by a SoftbodySystem
     virtual void update(Joint &j, Armature& arm) override;
     virtual void apply(Joint &j, Armature& arm) override;
     virtual std::unique_ptr<Constraint> get_copy() override;
+
+    ConstraintSoftbody *get_child(Armature &arm);
+
+    // Settings as amounts over one step of length h
+    struct StepAmounts{
+        float keep_drag;
+        float keep_friction;
+        float gravity;
+        float elasticity;
+        float rigidity;
+    };
+
+    // Recomputed only when the step length or settings change
+    const StepAmounts &get_step_amounts(float h);
+
+private:
+
+    StepAmounts step_amounts;
+    SoftbodySettings step_settings;
+    float step_length = 0;
 };
 
 struct ConstraintTrack : public Constraint{
@@ -51,6 +51,7 @@ void FBO::free(){
     
     // Delete the FBO
     glDeleteFramebuffers(1,&fboid);
+    fboid = 0;
     
 }
 
@@ -0,0 +1,267 @@
+#include "ImageDecode.h"
+#include "ThreadPool.h"
+#include "library/stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// The SSSE3 kernel is compiled for SSSE3 on its own and chosen at runtime, the build does not assume it
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define IMAGEDECODE_SSSE3 1
+#define IMAGEDECODE_TARGET_SSSE3 __attribute__(( target( "ssse3" ) ))
+#elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define IMAGEDECODE_SSSE3 1
+#define IMAGEDECODE_TARGET_SSSE3
+#endif
+
+#if defined( IMAGEDECODE_SSSE3 )
+#include <tmmintrin.h>
+#elif defined( __SSE2__ ) || defined( _M_X64 )
+#include <emmintrin.h>
+#endif
+
+#if defined( __ARM_NEON )
+#include <arm_neon.h>
+#endif
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define IMAGEDECODE_SSE2 1
+#endif
+
+namespace ImageDecode {
+
+    // Round c * a / 255 exactly for 8 bit inputs
+    static inline uint8_t mul_255( uint32_t c, uint32_t a ) {
+        uint32_t t = c * a + 128;
+        return ( t + ( t >> 8 ) ) >> 8;
+    }
+
+    // Tables converting between sRGB and linear, the linear table is fine enough for the darkest sRGB steps
+    static const uint32_t LINEAR_STEPS = 8192;
+
+    struct SRGBTables {
+        float to_linear[256];
+        uint8_t to_srgb[LINEAR_STEPS];
+
+        SRGBTables() {
+            for( uint32_t i = 0; i < 256; ++i ) {
+                float c = i / 255.0f;
+                to_linear[i] = c <= 0.04045f ? c / 12.92f : powf( ( c + 0.055f ) / 1.055f, 2.4f );
+            }
+
+            for( uint32_t i = 0; i < LINEAR_STEPS; ++i ) {
+                float l = (float)i / ( LINEAR_STEPS - 1 );
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf( l, 1.0f / 2.4f ) - 0.055f;
+                to_srgb[i] = (uint8_t)( c * 255.0f + 0.5f );
+            }
+        }
+    };
+
+    static const SRGBTables &srgb_tables() {
+        static SRGBTables tables;
+        return tables;
+    }
+
+#if defined( IMAGEDECODE_SSSE3 )
+    static bool has_ssse3() {
+#if defined( _MSC_VER )
+        static const bool supported = []() {
+            int info[4];
+            __cpuid( info, 1 );
+            return ( info[2] & ( 1 << 9 ) ) != 0;
+        }();
+#else
+        static const bool supported = __builtin_cpu_supports( "ssse3" );
+#endif
+        return supported;
+    }
+
+    // Spread 12 bytes of RGB to 16 bytes with a zero alpha, then set the alpha, returns the pixels expanded
+    IMAGEDECODE_TARGET_SSSE3 static uint32_t expand_rgb_ssse3( const uint8_t *src, uint32_t pixel_count, uint8_t *dest ) {
+        const __m128i shuffle = _mm_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+        const __m128i alpha = _mm_set1_epi32( (int)0xFF000000 );
+        uint32_t i = 0;
+
+        for( ; i + 16 <= pixel_count; i += 16 ) {
+            const uint8_t *s = src + (uint64_t)i * 3;
+            uint8_t *d = dest + (uint64_t)i * 4;
+            __m128i a = _mm_loadu_si128( (const __m128i *)s );
+            __m128i b = _mm_loadu_si128( (const __m128i *)( s + 16 ) );
+            __m128i c = _mm_loadu_si128( (const __m128i *)( s + 32 ) );
+
+            __m128i p0 = a;
+            __m128i p1 = _mm_alignr_epi8( b, a, 12 );
+            __m128i p2 = _mm_alignr_epi8( c, b, 8 );
+            __m128i p3 = _mm_srli_si128( c, 4 );
+
+            _mm_storeu_si128( (__m128i *)d, _mm_or_si128( _mm_shuffle_epi8( p0, shuffle ), alpha ) );
+            _mm_storeu_si128( (__m128i *)( d + 16 ), _mm_or_si128( _mm_shuffle_epi8( p1, shuffle ), alpha ) );
+            _mm_storeu_si128( (__m128i *)( d + 32 ), _mm_or_si128( _mm_shuffle_epi8( p2, shuffle ), alpha ) );
+            _mm_storeu_si128( (__m128i *)( d + 48 ), _mm_or_si128( _mm_shuffle_epi8( p3, shuffle ), alpha ) );
+        }
+
+        return i;
+    }
+#endif
+
+    /*
+     * Expand 1 (gray), 2 (gray alpha), 3 (RGB) or 4 channel pixels to RGBA.
+     * RGB is the common case for opaque images and is expanded 16 pixels at a time when SIMD is available,
+     * on x86 only when the CPU has SSSE3.
+     */
+    void expand_to_rgba( const uint8_t *src, uint32_t channels, uint32_t pixel_count, uint8_t *dest ) {
+        uint32_t i = 0;
+
+        switch( channels ) {
+            case 4:
+                memcpy( dest, src, (uint64_t)pixel_count * 4 );
+                return;
+
+            case 3:
+#if defined( IMAGEDECODE_SSSE3 )
+                if( has_ssse3() )
+                    i = expand_rgb_ssse3( src, pixel_count, dest );
+#elif defined( __ARM_NEON )
+            {
+                const uint8x16_t alpha = vdupq_n_u8( 255 );
+
+                for( ; i + 16 <= pixel_count; i += 16 ) {
+                    uint8x16x3_t rgb = vld3q_u8( src + (uint64_t)i * 3 );
+                    uint8x16x4_t rgba = {{ rgb.val[0], rgb.val[1], rgb.val[2], alpha }};
+                    vst4q_u8( dest + (uint64_t)i * 4, rgba );
+                }
+            }
+#endif
+                for( ; i < pixel_count; ++i ) {
+                    dest[i * 4 + 0] = src[i * 3 + 0];
+                    dest[i * 4 + 1] = src[i * 3 + 1];
+                    dest[i * 4 + 2] = src[i * 3 + 2];
+                    dest[i * 4 + 3] = 255;
+                }
+                return;
+
+            case 2:
+                for( ; i < pixel_count; ++i ) {
+                    uint8_t g = src[i * 2];
+                    dest[i * 4 + 0] = g;
+                    dest[i * 4 + 1] = g;
+                    dest[i * 4 + 2] = g;
+                    dest[i * 4 + 3] = src[i * 2 + 1];
+                }
+                return;
+
+            case 1:
+                for( ; i < pixel_count; ++i ) {
+                    uint8_t g = src[i];
+                    dest[i * 4 + 0] = g;
+                    dest[i * 4 + 1] = g;
+                    dest[i * 4 + 2] = g;
+                    dest[i * 4 + 3] = 255;
+                }
+                return;
+        }
+    }
+
+    /*
+     * Multiply the color of each pixel by its alpha in place.
+     * sRGB colors are converted to linear, multiplied, and converted back.
+     */
+    void premultiply( uint8_t *rgba, uint32_t pixel_count, bool srgb ) {
+        uint32_t i = 0;
+
+        if( srgb ) {
+            const SRGBTables &tables = srgb_tables();
+
+            for( ; i < pixel_count; ++i ) {
+                uint8_t *p = rgba + (uint64_t)i * 4;
+                uint8_t a = p[3];
+
+                if( a == 255 )
+                    continue;
+
+                float scale = a / 255.0f * ( LINEAR_STEPS - 1 );
+                p[0] = tables.to_srgb[(uint32_t)( tables.to_linear[p[0]] * scale + 0.5f )];
+                p[1] = tables.to_srgb[(uint32_t)( tables.to_linear[p[1]] * scale + 0.5f )];
+                p[2] = tables.to_srgb[(uint32_t)( tables.to_linear[p[2]] * scale + 0.5f )];
+            }
+            return;
+        }
+
+#if defined( IMAGEDECODE_SSE2 )
+        // 4 pixels at a time as 16 bit lanes, the alpha lane is multiplied by 255 so it is unchanged
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i color_mask = _mm_setr_epi16( -1, -1, -1, 0, -1, -1, -1, 0 );
+        const __m128i alpha_one = _mm_setr_epi16( 0, 0, 0, 255, 0, 0, 0, 255 );
+        const __m128i round = _mm_set1_epi16( 128 );
+
+        auto multiply = [&]( __m128i c ) {
+            __m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( c, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+            a = _mm_or_si128( _mm_and_si128( a, color_mask ), alpha_one );
+            __m128i t = _mm_add_epi16( _mm_mullo_epi16( c, a ), round );
+            return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+        };
+
+        for( ; i + 4 <= pixel_count; i += 4 ) {
+            __m128i *p = (__m128i *)( rgba + (uint64_t)i * 4 );
+            __m128i v = _mm_loadu_si128( p );
+            __m128i lo = multiply( _mm_unpacklo_epi8( v, zero ) );
+            __m128i hi = multiply( _mm_unpackhi_epi8( v, zero ) );
+            _mm_storeu_si128( p, _mm_packus_epi16( lo, hi ) );
+        }
+#endif
+
+        for( ; i < pixel_count; ++i ) {
+            uint8_t *p = rgba + (uint64_t)i * 4;
+            p[0] = mul_255( p[0], p[3] );
+            p[1] = mul_255( p[1], p[3] );
+            p[2] = mul_255( p[2], p[3] );
+        }
+    }
+
+    ImageInfo read_info( const std::string &filepath ) {
+        ImageInfo info;
+        int w, h, c;
+
+        if( stbi_info( filepath.c_str(), &w, &h, &c ) ) {
+            info.width = w, info.height = h, info.channels = c;
+            info.valid = true;
+        }
+
+        return info;
+    }
+
+    /*
+     * Decode a png to RGBA into dest, which holds width * height pixels.
+     * Fails without writing if the file does not load or is not the expected size.
+     */
+    bool decode_png( const std::string &filepath, uint32_t width, uint32_t height, uint8_t *dest, bool premultiplied, bool srgb ) {
+        int w, h, c;
+        unsigned char *data = stbi_load( filepath.c_str(), &w, &h, &c, 0 );
+
+        if( !data )
+            return false;
+
+        if( (uint32_t)w != width || (uint32_t)h != height ) {
+            stbi_image_free( data );
+            return false;
+        }
+
+        expand_to_rgba( data, c, width * height, dest );
+        stbi_image_free( data );
+
+        // Images without alpha are unchanged by premultiplying
+        if( premultiplied && ( c == 2 || c == 4 ) )
+            premultiply( dest, width * height, srgb );
+
+        return true;
+    }
+
+    // Read the size of every file, the headers are small but the files may be on a slow disk
+    void read_infos( const std::vector<std::string> &filepaths, std::vector<ImageInfo> &dest, uint32_t thread_count ) {
+        dest.assign( filepaths.size(), ImageInfo() );
+        ThreadPool::parallel_for( filepaths.size(), thread_count, [&]( uint32_t i ) {
+            dest[i] = read_info( filepaths[i] );
+        } );
+    }
+}
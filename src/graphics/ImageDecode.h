@@ -0,0 +1,29 @@
+#ifndef IMAGEDECODE_H
+#define IMAGEDECODE_H
+
+#include <string>
+#include <vector>
+#include <inttypes.h>
+
+/*
+ * Decoding of png images to RGBA8 across multiple threads.
+ * Images of any channel count are expanded to RGBA, and can be premultiplied by their alpha.
+ * When sRGB is set, premultiplication is done on linear colors so the result is correct when sampled as sRGB.
+ */
+namespace ImageDecode {
+
+    // Size of an image on disk, valid is false if the file could not be read
+    struct ImageInfo {
+        uint32_t width = 0, height = 0, channels = 0;
+        bool valid = false;
+    };
+
+    void expand_to_rgba( const uint8_t *src, uint32_t channels, uint32_t pixel_count, uint8_t *dest );
+    void premultiply( uint8_t *rgba, uint32_t pixel_count, bool srgb );
+
+    ImageInfo read_info( const std::string &filepath );
+    bool decode_png( const std::string &filepath, uint32_t width, uint32_t height, uint8_t *dest, bool premultiplied, bool srgb );
+    void read_infos( const std::vector<std::string> &filepaths, std::vector<ImageInfo> &dest, uint32_t thread_count = 0 );
+};
+
+#endif // IMAGEDECODE_H
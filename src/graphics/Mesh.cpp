@@ -3,6 +3,9 @@
 #include <sstream>
 #include <regex>
 #include <iterator>
+#include <cstring>
+#include <cmath>
+#include <unordered_map>
 
 void Mesh::set_attribute_format( uint8_t attrb, uint8_t data_type, uint8_t vector_size) {
     // Return if invalid attribute or the attribute format is already set
@@ -23,8 +26,9 @@ void Mesh::copy_attribute_format(const Mesh& src_mesh){
 }
 
 // Append the indices in the range of the given partition. All indices are shifted by the vertex start
-void Mesh::append_indices( std::vector<uint32_t> src_indices, const Partition &src_partition, uint32_t vertex_start ) {
+void Mesh::append_indices( const std::vector<uint32_t> &src_indices, const Partition &src_partition, uint32_t vertex_start ) {
     indices.reserve( indices.size() + src_partition.index_end - src_partition.index_begin );
+    index_dirty_begin = indices.size() < index_dirty_begin ? indices.size() : index_dirty_begin;
 
     for( uint32_t i = src_partition.index_begin; i < src_partition.index_end; ++i ) {
         indices.push_back(src_indices[i] - src_partition.vertex_begin + vertex_start);
@@ -79,6 +83,7 @@ void Mesh::set_from_blend(const Mesh &src_mesh, const Mesh &other_mesh, uint8_t
     attributes[attrb].blend(src_mesh.attributes[attrb],other_mesh.attributes[attrb],f);
 
     updated = true;
+    bounds_changed = true;
 }
 
 // Append a partition of a mesh
@@ -120,6 +125,7 @@ void Mesh::append_mesh( const Mesh &src_mesh, uint32_t src_part_first, uint32_t
         append_indices( src_mesh.indices, p, partitions.back().vertex_begin );
     }
     updated = true;
+    bounds_changed = true;
 }
 
 void Mesh::append_mesh_transformed( Mesh &src_mesh,  mat4 transform, uint32_t src_part_first, uint32_t src_part_last) {
@@ -173,11 +179,13 @@ void Mesh::append_mesh_transformed( Mesh &src_mesh,  mat4 transform, uint32_t sr
         append_indices( src_mesh.indices, p, partitions.back().vertex_begin );
     }
     updated = true;
+    bounds_changed = true;
 }
 
 void Mesh::remove_attribute( uint8_t attrb ) {
     attributes[attrb].clear();
     updated = true;
+    bounds_changed = true;
 }
 
 void Mesh::clear() {
@@ -186,7 +194,9 @@ void Mesh::clear() {
     }
     indices.clear();
     partitions.clear();
+    index_dirty_begin = 0;
     updated = true;
+    bounds_changed = true;
 }
 
 // Read a PLY file from assets and append it
@@ -448,22 +458,293 @@ void Mesh::append_PLY( std::string filename ) {
         attributes[i].append(attrb_data[i]);
     }
     updated = true;
+    bounds_changed = true;
 }
 
-// Load to VAO
+// Load the changed ranges to the VAO
 void Mesh::to_VAO( VAO *vao, uint32_t partition_first, uint32_t partition_last ) {
+
+    // The VAO holds the other layout, start over
+    if( vao->is_interleaved() != ( layout == LAYOUT_INTERLEAVED ) && vao->vaoid != 0 ) {
+        vao->free();
+        invalidate();
+    }
+
+    if( layout == LAYOUT_INTERLEAVED ) {
+        to_VAO_interleaved( vao );
+    }
+    else {
+        for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+            if( attributes[i].is_set ) {
+
+                // Convert color to float
+                if( i == ATTRB_COL )
+                    attributes[i].load_vbo( i, vao, true );
+                else
+                    attributes[i].load_vbo( i, vao );
+            }
+        }
+    }
+
+    // Use 16 bit indices when possible, switching types rewrites all indices
+    GLenum type = get_vertex_count() <= UINT16_MAX + 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    if( type != index_type ) {
+        index_type = type;
+        index_dirty_begin = 0;
+    }
+
+    // Rewrite indices from the first changed index, this also shrinks the index count after clearing
+    uint32_t index_begin = index_dirty_begin < indices.size() ? index_dirty_begin : indices.size();
+
+    if( type == GL_UNSIGNED_SHORT ) {
+        std::vector<GLushort> narrowed( indices.begin() + index_begin, indices.end() );
+        vao->load_index( narrowed.size(), narrowed.data(), index_begin );
+    }
+    else {
+        vao->load_index( indices.size() - index_begin, indices.data() + index_begin, index_begin );
+    }
+
+    index_dirty_begin = UINT32_MAX;
+}
+
+// Convert a float to a half float, rounding to nearest
+static uint16_t float_to_half( float f ) {
+    uint32_t bits;
+    memcpy( &bits, &f, 4 );
+
+    uint16_t sign = ( bits >> 16 ) & 0x8000;
+    int32_t exponent = ( ( bits >> 23 ) & 0xFF ) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // Zero, too small for a half denormal
+    if( exponent < -10 )
+        return sign;
+
+    // Infinity and NaN
+    if( ( ( bits >> 23 ) & 0xFF ) == 0xFF )
+        return sign | 0x7C00 | ( mantissa ? 0x200 : 0 );
+
+    // Denormal
+    if( exponent <= 0 ) {
+        mantissa |= 0x800000;
+        uint32_t shift = 14 - exponent;
+        uint32_t half_mantissa = mantissa >> shift;
+
+        if( ( mantissa >> ( shift - 1 ) ) & 1 )
+            ++half_mantissa;
+
+        return sign | half_mantissa;
+    }
+
+    // Overflow to infinity
+    if( exponent >= 31 )
+        return sign | 0x7C00;
+
+    // Normal, rounding may carry into the exponent which is still correct
+    uint16_t half = sign | ( exponent << 10 ) | ( mantissa >> 13 );
+
+    if( mantissa & 0x1000 )
+        ++half;
+
+    return half;
+}
+
+// Pack a normalized vector as signed 10_10_10_2, w is unused
+static uint32_t pack_snorm_10_10_10_2( const float *v ) {
+    uint32_t packed = 0;
+
+    for( uint8_t i = 0; i < 3; ++i ) {
+        float c = v[i] < -1.0f ? -1.0f : ( v[i] > 1.0f ? 1.0f : v[i] );
+        int32_t q = (int32_t)roundf( c * 511.0f );
+        packed |= ( (uint32_t)q & 0x3FF ) << ( i * 10 );
+    }
+
+    return packed;
+}
+
+static uint8_t float_to_unorm8( float f ) {
+    f = f < 0.0f ? 0.0f : ( f > 1.0f ? 1.0f : f );
+    return (uint8_t)roundf( f * 255.0f );
+}
+
+/*
+ * Set the packed format of each attribute in an interleaved vertex and return the stride.
+ * Every attribute starts on a 4 byte boundary.
+ */
+uint32_t Mesh::get_interleaved_formats( AttributeFormat *formats ) {
+    uint32_t offset = 0;
+
+    for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+        Attribute_Data &a = attributes[i];
+        AttributeFormat &f = formats[i];
+        f = AttributeFormat();
+
+        if( !a.is_set )
+            continue;
+
+        uint32_t size = 0;
+        f.vec_size = a.vector_size;
+        f.offset = offset;
+
+        if( a.data_type == Attribute_Data::BYTE ) {
+            // Colors are normalized, everything else is read as integers
+            f.type = GL_UNSIGNED_BYTE;
+            f.normalized = i == ATTRB_COL;
+            f.integer = i != ATTRB_COL;
+            size = a.vector_size;
+        }
+        else if( ( i == ATTRB_NORM || i == ATTRB_SK_NORM ) && a.vector_size == 3 ) {
+            // The packed type requires a vector size of 4, the shader ignores the extra component
+            f.type = GL_INT_2_10_10_10_REV;
+            f.vec_size = 4;
+            f.normalized = true;
+            size = 4;
+        }
+        else if( i == ATTRB_UV ) {
+            f.type = GL_HALF_FLOAT;
+            size = a.vector_size * 2;
+        }
+        else if( i == ATTRB_COL || i == ATTRB_WEIGHTS ) {
+            f.type = GL_UNSIGNED_BYTE;
+            f.normalized = true;
+            size = a.vector_size;
+        }
+        else {
+            f.type = GL_FLOAT;
+            size = a.vector_size * 4;
+        }
+
+        offset += ( size + 3 ) & ~3u;
+    }
+
+    return offset;
+}
+
+// Pack the changed vertices of every attribute and load them into a single buffer
+void Mesh::to_VAO_interleaved( VAO *vao ) {
+    AttributeFormat formats[NUM_ATTRBS];
+    uint32_t stride = get_interleaved_formats( formats );
+    uint32_t vertex_count = get_vertex_count();
+
+    // A new layout invalidates everything already packed
+    if( stride != interleaved_stride ) {
+        for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+            attributes[i].invalidate();
+        }
+        interleaved_stride = stride;
+    }
+
+    // Vertices are packed whole, so use the union of the changed ranges
+    uint32_t begin = UINT32_MAX, end = 0;
+
     for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
-        if( attributes[i].is_set ) {
+        uint32_t b, e;
+        attributes[i].take_dirty_range( b, e );
+        begin = b < begin ? b : begin;
+        end = e > end ? e : end;
+    }
+
+    end = end < vertex_count ? end : vertex_count;
+
+    if( begin >= end || stride == 0 )
+        return;
+
+    std::vector<uint8_t> packed( ( end - begin ) * stride, 0 );
+
+    for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+        Attribute_Data &a = attributes[i];
+        AttributeFormat &f = formats[i];
+
+        if( !a.is_set )
+            continue;
+
+        uint32_t n = a.vector_size;
+        uint32_t last = end < a.get_vertex_count() ? end : a.get_vertex_count();
+
+        for( uint32_t v = begin; v < last; ++v ) {
+            uint8_t *dest = packed.data() + ( v - begin ) * stride + f.offset;
+
+            if( a.data_type == Attribute_Data::BYTE ) {
+                memcpy( dest, a.get_byte_data() + v * n, n );
+                continue;
+            }
+
+            const float *src = a.get_float_data() + v * n;
+
+            if( f.type == GL_INT_2_10_10_10_REV ) {
+                uint32_t p = pack_snorm_10_10_10_2( src );
+                memcpy( dest, &p, 4 );
+            }
+            else if( f.type == GL_HALF_FLOAT ) {
+                for( uint32_t c = 0; c < n; ++c ) {
+                    uint16_t h = float_to_half( src[c] );
+                    memcpy( dest + c * 2, &h, 2 );
+                }
+            }
+            else if( f.type == GL_UNSIGNED_BYTE ) {
+                uint32_t sum = 0;
+                uint8_t largest = 0;
+
+                for( uint8_t c = 0; c < n; ++c ) {
+                    dest[c] = float_to_unorm8( src[c] );
+                    sum += dest[c];
+                    largest = dest[c] > dest[largest] ? c : largest;
+                }
 
-            // Convert color to float
-            if( i == ATTRB_COL )
-                attributes[i].load_vbo( i, vao, true );
-            else
-                attributes[i].load_vbo( i, vao );
+                // Keep weights summing to one after rounding, only when they were already normalized
+                if( i == ATTRB_WEIGHTS && sum + n > 255 && sum < 255 + n )
+                    dest[largest] = (uint8_t)( dest[largest] + 255 - sum );
+            }
+            else {
+                memcpy( dest, src, n * 4 );
+            }
         }
     }
 
-    vao->load_index( indices.size(), indices.data() );
+    vao->load_interleaved( begin, end - begin, stride, formats, packed.data() );
+}
+
+void Mesh::set_layout( uint8_t layout ) {
+    if( this->layout == layout )
+        return;
+
+    this->layout = layout;
+    invalidate();
+}
+
+uint8_t Mesh::get_layout() {
+    return layout;
+}
+
+uint32_t Mesh::get_vertex_count() {
+    return attributes[ATTRB_POS].get_vertex_count();
+}
+
+// Size of a single vertex in bytes for the given layout
+uint32_t Mesh::get_vertex_size( uint8_t layout ) {
+    if( layout == LAYOUT_INTERLEAVED ) {
+        AttributeFormat formats[NUM_ATTRBS];
+        return get_interleaved_formats( formats );
+    }
+
+    uint32_t size = 0;
+
+    for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+        if( attributes[i].is_set )
+            size += attributes[i].vector_size * ( attributes[i].data_type == Attribute_Data::FLOAT ? 4 : 1 );
+    }
+
+    return size;
+}
+
+// Mark the entire mesh for upload, used when loading into a VAO that does not hold this mesh
+void Mesh::invalidate() {
+    for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+        attributes[i].invalidate();
+    }
+    index_dirty_begin = 0;
+    updated = true;
 }
 
 void Mesh::merge_partitions(){
@@ -487,3 +768,308 @@ void Mesh::get_bounding_box( uint32_t partition, vec3* box){
     pos.get_min_max(box[0],box[1], partitions[partition].vertex_begin, partitions[partition].vertex_end);
     return;
 }
+
+// Size of the simulated post-transform cache used for ordering and measuring
+static const uint32_t VERTEX_CACHE_SIZE = 32;
+
+// Average cache miss ratio, the number of vertices transformed per triangle with a FIFO cache
+static float compute_acmr( const uint32_t *index, uint32_t count, uint32_t cache_size ) {
+    if( count < 3 )
+        return 0.0f;
+
+    std::vector<uint32_t> cache( cache_size, UINT32_MAX );
+    uint32_t head = 0, misses = 0;
+
+    for( uint32_t i = 0; i < count; ++i ) {
+        if( std::find( cache.begin(), cache.end(), index[i] ) == cache.end() ) {
+            cache[head] = index[i];
+            head = ( head + 1 ) % cache_size;
+            ++misses;
+        }
+    }
+
+    return (float)misses / ( count / 3 );
+}
+
+// Score of a vertex from its cache position and the number of triangles still using it
+static float forsyth_vertex_score( int32_t cache_pos, uint32_t remaining ) {
+    if( remaining == 0 )
+        return -1.0f;
+
+    float score = 0.0f;
+
+    // The last triangle's vertices get a fixed score so it is not reused immediately
+    if( cache_pos >= 0 ) {
+        if( cache_pos < 3 )
+            score = 0.75f;
+        else
+            score = powf( 1.0f - ( cache_pos - 3 ) / (float)( VERTEX_CACHE_SIZE - 3 ), 1.5f );
+    }
+
+    // Favor vertices with few triangles left so they leave the cache sooner
+    return score + 2.0f / sqrtf( (float)remaining );
+}
+
+/*
+ * Reorder triangles for the post-transform cache using Forsyth's linear-speed algorithm.
+ * The next triangle is the best scoring triangle touching the cache, otherwise the next unused triangle.
+ * Indices must be local, in the range of 0 to vertex count.
+ */
+static void reorder_triangles( uint32_t *index, uint32_t index_count, uint32_t vertex_count ) {
+    uint32_t tri_count = index_count / 3;
+
+    if( tri_count == 0 )
+        return;
+
+    // Build the triangles used by each vertex
+    std::vector<uint32_t> remaining( vertex_count, 0 ), adj_offset( vertex_count + 1, 0 ), adj( tri_count * 3 );
+
+    for( uint32_t i = 0; i < tri_count * 3; ++i ) {
+        ++remaining[index[i]];
+    }
+
+    for( uint32_t v = 0; v < vertex_count; ++v ) {
+        adj_offset[v + 1] = adj_offset[v] + remaining[v];
+    }
+
+    std::vector<uint32_t> fill( adj_offset.begin(), adj_offset.end() - 1 );
+
+    for( uint32_t i = 0; i < tri_count * 3; ++i ) {
+        adj[fill[index[i]]++] = i / 3;
+    }
+
+    std::vector<int32_t> cache_pos( vertex_count, -1 );
+    std::vector<float> vertex_score( vertex_count );
+    std::vector<bool> emitted( tri_count, false );
+    std::vector<uint32_t> cache, next_cache, ordered;
+    cache.reserve( VERTEX_CACHE_SIZE + 3 );
+    next_cache.reserve( VERTEX_CACHE_SIZE + 3 );
+    ordered.reserve( tri_count * 3 );
+
+    for( uint32_t v = 0; v < vertex_count; ++v ) {
+        vertex_score[v] = forsyth_vertex_score( -1, remaining[v] );
+    }
+
+    uint32_t cursor = 0;
+    int64_t best = -1;
+
+    for( uint32_t n = 0; n < tri_count; ++n ) {
+
+        // Nothing in the cache is usable, take the next triangle in order
+        if( best < 0 ) {
+            while( emitted[cursor] )
+                ++cursor;
+            best = cursor;
+        }
+
+        uint32_t t = best;
+        const uint32_t *tri = index + t * 3;
+        emitted[t] = true;
+        ordered.insert( ordered.end(), tri, tri + 3 );
+
+        // Remove the triangle from its vertices
+        for( uint8_t k = 0; k < 3; ++k ) {
+            uint32_t *begin = adj.data() + adj_offset[tri[k]];
+            uint32_t *end = begin + remaining[tri[k]];
+            uint32_t *found = std::find( begin, end, t );
+
+            if( found != end ) {
+                *found = end[-1];
+                --remaining[tri[k]];
+            }
+        }
+
+        // The triangle's vertices move to the front of the cache
+        next_cache.clear();
+
+        for( uint8_t k = 0; k < 3; ++k ) {
+            if( std::find( next_cache.begin(), next_cache.end(), tri[k] ) == next_cache.end() )
+                next_cache.push_back( tri[k] );
+        }
+
+        for( uint32_t v : cache ) {
+            if( v != tri[0] && v != tri[1] && v != tri[2] )
+                next_cache.push_back( v );
+        }
+
+        // Vertices past the cache size are evicted
+        for( uint32_t i = 0; i < next_cache.size(); ++i ) {
+            cache_pos[next_cache[i]] = i < VERTEX_CACHE_SIZE ? i : -1;
+            vertex_score[next_cache[i]] = forsyth_vertex_score( cache_pos[next_cache[i]], remaining[next_cache[i]] );
+        }
+
+        // Find the best triangle touching the cache
+        best = -1;
+        float best_score = -1.0f;
+
+        for( uint32_t v : next_cache ) {
+            for( uint32_t i = 0; i < remaining[v]; ++i ) {
+                const uint32_t *a = index + adj[adj_offset[v] + i] * 3;
+                float score = vertex_score[a[0]] + vertex_score[a[1]] + vertex_score[a[2]];
+
+                if( score > best_score ) {
+                    best_score = score;
+                    best = adj[adj_offset[v] + i];
+                }
+            }
+        }
+
+        if( next_cache.size() > VERTEX_CACHE_SIZE )
+            next_cache.resize( VERTEX_CACHE_SIZE );
+
+        cache.swap( next_cache );
+    }
+
+    std::copy( ordered.begin(), ordered.end(), index );
+}
+
+/*
+ * Optimize each partition for rendering, partitions keep their index ranges but may lose vertices.
+ * Identical vertices are welded, triangles are reordered for the post-transform cache,
+ * then vertices are reordered by first use for fetch locality and unused vertices are removed.
+ * The average cache miss ratio before and after is returned.
+ */
+void Mesh::optimize( float &acmr_before, float &acmr_after ) {
+    acmr_before = compute_acmr( indices.data(), indices.size(), VERTEX_CACHE_SIZE );
+    acmr_after = acmr_before;
+
+    if( partitions.empty() )
+        return;
+
+    // New vertex to old vertex
+    std::vector<uint32_t> order;
+    order.reserve( get_vertex_count() );
+
+    std::vector<uint32_t> local, weld, placed;
+    std::unordered_map<std::string, uint32_t> unique;
+    std::string key;
+
+    for( Partition &p : partitions ) {
+        uint32_t p_count = p.vertex_end - p.vertex_begin;
+
+        // Weld each vertex to the first vertex with identical data
+        weld.resize( p_count );
+        unique.clear();
+        unique.reserve( p_count );
+
+        for( uint32_t v = 0; v < p_count; ++v ) {
+            key.clear();
+
+            for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+                if( attributes[i].is_set )
+                    attributes[i].append_vertex_key( p.vertex_begin + v, key );
+            }
+
+            weld[v] = unique.emplace( key, v ).first->second;
+        }
+
+        // Indices local to the partition, out of range indices are clamped to the first vertex
+        local.clear();
+
+        for( uint32_t i = p.index_begin; i < p.index_end; ++i ) {
+            uint32_t index = indices[i];
+            local.push_back( index >= p.vertex_begin && index < p.vertex_end ? weld[index - p.vertex_begin] : 0 );
+        }
+
+        reorder_triangles( local.data(), local.size() - local.size() % 3, p_count );
+
+        // Place vertices in the order they are first used
+        placed.assign( p_count, UINT32_MAX );
+        uint32_t vertex_begin = order.size();
+
+        for( uint32_t &index : local ) {
+            if( placed[index] == UINT32_MAX ) {
+                placed[index] = order.size();
+                order.push_back( p.vertex_begin + index );
+            }
+            index = placed[index];
+        }
+
+        std::copy( local.begin(), local.end(), indices.begin() + p.index_begin );
+        p.vertex_begin = vertex_begin;
+        p.vertex_end = order.size();
+    }
+
+    for( uint8_t i = 0; i < NUM_ATTRBS; ++i ) {
+        if( attributes[i].is_set )
+            attributes[i].remap( order );
+    }
+
+    index_dirty_begin = 0;
+    updated = true;
+    bounds_changed = true;
+
+    acmr_after = compute_acmr( indices.data(), indices.size(), VERTEX_CACHE_SIZE );
+}
+
+/*
+ * Get the bounds of the entire mesh, recomputing them if the vertices changed.
+ * Positions must be 3 floats, otherwise the bounds are not valid.
+ * Joint bounds are only computed when joint ids are bytes, id 0 and zero weights are ignored like in the shaders.
+ */
+const MeshBounds &Mesh::get_bounds() {
+    if( !bounds_changed )
+        return bounds;
+
+    bounds_changed = false;
+    bounds.valid = false;
+    bounds.joints.clear();
+
+    Attribute_Data &pos = attributes[ATTRB_POS];
+    uint32_t count = get_vertex_count();
+
+    if( !pos.is_set || pos.data_type != Attribute_Data::FLOAT || pos.vector_size != 3 || count == 0 )
+        return bounds;
+
+    const float *p = pos.get_float_data();
+    pos.get_min_max( bounds.box[0], bounds.box[1] );
+
+    // Sphere around the box center, the radius is the farthest vertex
+    glm_aabb_center( bounds.box, bounds.sphere );
+    float radius_sqr = 0;
+
+    for( uint32_t v = 0; v < count; ++v ) {
+        float d = glm_vec3_distance2( (float *)p + v * 3, bounds.sphere );
+        radius_sqr = d > radius_sqr ? d : radius_sqr;
+    }
+
+    bounds.sphere[3] = sqrtf( radius_sqr );
+    bounds.valid = true;
+
+    Attribute_Data &joints = attributes[ATTRB_JOINTS];
+    Attribute_Data &weights = attributes[ATTRB_WEIGHTS];
+
+    if( !joints.is_set || joints.data_type != Attribute_Data::BYTE || joints.get_vertex_count() < count )
+        return bounds;
+
+    bool has_weights = weights.is_set && weights.data_type == Attribute_Data::FLOAT && weights.vector_size == joints.vector_size && weights.get_vertex_count() >= count;
+    const uint8_t *j = joints.get_byte_data();
+    const float *w = weights.get_float_data();
+    uint8_t n = joints.vector_size;
+
+    for( uint32_t v = 0; v < count; ++v ) {
+        for( uint8_t k = 0; k < n; ++k ) {
+            uint8_t id = j[v * n + k];
+
+            if( id == 0 || ( has_weights && w[v * n + k] <= 0 ) )
+                continue;
+
+            if( id >= bounds.joints.size() )
+                bounds.joints.resize( id + 1 );
+
+            JointBounds &jb = bounds.joints[id];
+
+            if( !jb.used ) {
+                glm_vec3_copy( (float *)p + v * 3, jb.box[0] );
+                glm_vec3_copy( (float *)p + v * 3, jb.box[1] );
+                jb.used = true;
+            }
+            else {
+                glm_vec3_minv( jb.box[0], (float *)p + v * 3, jb.box[0] );
+                glm_vec3_maxv( jb.box[1], (float *)p + v * 3, jb.box[1] );
+            }
+        }
+    }
+
+    return bounds;
+}
@@ -13,6 +13,15 @@ class Attribute_Data {
         std::vector<float> data_float;
         std::vector<uint8_t> data_byte;
 
+        // Range of vertices changed since the last upload, empty when begin >= end
+        uint32_t dirty_begin = UINT32_MAX;
+        uint32_t dirty_end = 0;
+
+        void mark_dirty( uint32_t begin, uint32_t end ) {
+            dirty_begin = begin < dirty_begin ? begin : dirty_begin;
+            dirty_end = end > dirty_end ? end : dirty_end;
+        }
+
     public:
         static const uint8_t
         NONE = 0,
@@ -45,6 +54,8 @@ class Attribute_Data {
         }
 
         void append( std::vector<char> &src_data ) {
+            uint32_t start = get_vertex_count();
+
             if( data_type == Attribute_Data::FLOAT ) {
                 data_float.reserve( src_data.size() / 4 );
 
@@ -59,6 +70,8 @@ class Attribute_Data {
                     data_byte.push_back( src_data[i] );
                 }
             }
+
+            mark_dirty( start, get_vertex_count() );
         }
 
         void blend(const Attribute_Data &src, const Attribute_Data &other, float f, uint32_t src_start = 0, uint32_t src_end = UINT32_MAX){
@@ -84,6 +97,8 @@ class Attribute_Data {
                     data_byte[i] = (uint8_t)(src.data_byte[i] + ( other.data_byte[i] - src.data_byte[i] ) * f);
                 }
             }
+
+            mark_dirty( src_start, src_end < get_vertex_count() ? src_end : get_vertex_count() );
         }
 
 
@@ -97,12 +112,16 @@ class Attribute_Data {
             if( src_start >= src_end )
                 src_start = src_end;
 
+            uint32_t start = get_vertex_count();
+
             if( data_type == FLOAT ) {
                 data_float.insert( data_float.end(), src.data_float.begin() + src_start * vector_size,  src.data_float.begin() + src_end * vector_size );
             }
             else if( data_type == BYTE ) {
                 data_byte.insert( data_byte.end(), src.data_byte.begin() + src_start * vector_size,  src.data_byte.begin() + src_end * vector_size );
             }
+
+            mark_dirty( start, get_vertex_count() );
         }
 
         void append_transformed( Attribute_Data &src, mat4 transform, bool is_normal, uint32_t src_start = 0, uint32_t src_end = UINT32_MAX ) {
@@ -119,6 +138,7 @@ class Attribute_Data {
                 return;
 
             data_float.reserve( ( src_end - src_start ) * 3 + data_float.size() );
+            mark_dirty( get_vertex_count(), get_vertex_count() + src_end - src_start );
 
             vec3 scale;
             mat4 normal_matrix;
@@ -176,22 +196,94 @@ class Attribute_Data {
             }
         }
 
+        // Uploads only the vertices changed since the last upload
         void load_vbo( uint8_t attribute, VAO *vao, bool byte_to_float = false ) {
             if( !is_set )
                 return;
 
+            uint32_t end = dirty_end < get_vertex_count() ? dirty_end : get_vertex_count();
+
+            if( dirty_begin >= end ) {
+                dirty_begin = UINT32_MAX;
+                dirty_end = 0;
+                return;
+            }
+
+            uint32_t offset = dirty_begin * vector_size;
+            uint32_t size = ( end - dirty_begin ) * vector_size;
+
+            if( data_type == FLOAT ) {
+                vao->load_attrb_float( attribute, dirty_begin, 0, vector_size, size, data_float.data() + offset );
+            }
+            else if( data_type == BYTE ) {
+                vao->load_attrb_byte( attribute, dirty_begin, 0, vector_size, size, byte_to_float, data_byte.data() + offset );
+            }
+
+            dirty_begin = UINT32_MAX;
+            dirty_end = 0;
+        }
+
+        // Take the range of vertices changed since the last upload, the range is reset
+        void take_dirty_range( uint32_t &begin, uint32_t &end ) {
+            begin = dirty_begin;
+            end = dirty_end < get_vertex_count() ? dirty_end : get_vertex_count();
+            dirty_begin = UINT32_MAX;
+            dirty_end = 0;
+        }
+
+        // Append the raw bytes of a vertex, used to find identical vertices
+        void append_vertex_key( uint32_t vertex, std::string &key ) const {
+            if( data_type == FLOAT && vertex < get_vertex_count() ) {
+                key.append( reinterpret_cast<const char *>( data_float.data() + vertex * vector_size ), vector_size * sizeof( float ) );
+            }
+            else if( data_type == BYTE && vertex < get_vertex_count() ) {
+                key.append( reinterpret_cast<const char *>( data_byte.data() + vertex * vector_size ), vector_size );
+            }
+        }
+
+        // Rebuild the data so vertex i is the old vertex order[i], all data is marked as changed
+        void remap( const std::vector<uint32_t> &order ) {
+            uint32_t count = get_vertex_count();
+
             if( data_type == FLOAT ) {
-                vao->load_attrb_float( attribute, 0, 0, vector_size, data_float.size(), data_float.data() );
+                std::vector<float> remapped( order.size() * vector_size, 0.0f );
+                for( uint32_t i = 0; i < order.size(); ++i ) {
+                    if( order[i] < count )
+                        std::copy_n( data_float.begin() + order[i] * vector_size, vector_size, remapped.begin() + i * vector_size );
+                }
+                data_float.swap( remapped );
             }
             else if( data_type == BYTE ) {
-                vao->load_attrb_byte( attribute, 0, 0, vector_size, data_byte.size(), byte_to_float, data_byte.data() );
+                std::vector<uint8_t> remapped( order.size() * vector_size, 0 );
+                for( uint32_t i = 0; i < order.size(); ++i ) {
+                    if( order[i] < count )
+                        std::copy_n( data_byte.begin() + order[i] * vector_size, vector_size, remapped.begin() + i * vector_size );
+                }
+                data_byte.swap( remapped );
             }
+
+            mark_dirty( 0, get_vertex_count() );
+        }
+
+        const float *get_float_data() const {
+            return data_float.data();
+        }
+
+        const uint8_t *get_byte_data() const {
+            return data_byte.data();
+        }
+
+        // Marks all data as needing uploaded, used when the VAO no longer matches
+        void invalidate() {
+            mark_dirty( 0, get_vertex_count() );
         }
 
         void clear() {
             data_float.clear();
             data_byte.clear();
             is_set = false;
+            dirty_begin = UINT32_MAX;
+            dirty_end = 0;
         }
 };
 
@@ -199,6 +291,24 @@ struct Partition {
     uint32_t vertex_begin, vertex_end, index_begin, index_end;
 };
 
+// Box of the vertices influenced by a joint
+struct JointBounds {
+    bool used = false;
+    vec3 box[2];
+};
+
+/*
+ * Local space bounds of a mesh.
+ * The sphere is stored as a center and radius.
+ * Joint bounds are indexed by joint id, a skinned vertex is always within the union of its joints' transformed boxes.
+ */
+struct MeshBounds {
+    bool valid = false;
+    vec3 box[2];
+    vec4 sphere;
+    std::vector<JointBounds> joints;
+};
+
 /*
  * Made of multiple partitions which designate the sizes of the mesh.
  * A partition is created on appending only.
@@ -209,6 +319,11 @@ struct Partition {
  * Indicies store the ibo data.
  * These are only changed on appending or clearing.
  * The attribute format is automatically set if it is not set on any append.
+ * Only the ranges changed since the last upload are written to the VAO.
+ * The layout selects between a buffer per attribute or a single interleaved buffer with packed formats.
+ * Interleaved vertices store normals as 10_10_10_2, uvs as half floats, colors and weights as unorm8.
+ * Indices are uploaded as 16 bit when every vertex can be addressed.
+ * Optimizing welds identical vertices and reorders triangles and vertices for the vertex caches.
  */
 class Mesh {
 
@@ -216,11 +331,33 @@ class Mesh {
         Attribute_Data attributes[NUM_ATTRBS];
         std::vector<uint32_t> indices;
 
-        void append_indices( std::vector<uint32_t> src_indices, const Partition &src_partition, uint32_t vertex_start );
+        // First index changed since the last upload
+        uint32_t index_dirty_begin = UINT32_MAX;
+
+        uint8_t layout = 0;
+
+        // Stride of the last interleaved upload, a change requires all vertices to be repacked
+        uint32_t interleaved_stride = 0;
+
+        // Index type of the last upload, a change requires all indices to be rewritten
+        GLenum index_type = GL_UNSIGNED_INT;
+
+        // Bounds are recomputed on request after the vertices change
+        MeshBounds bounds;
+        bool bounds_changed = true;
+
+        uint32_t get_interleaved_formats( AttributeFormat *formats );
+        void to_VAO_interleaved( VAO *vao );
+
+        void append_indices( const std::vector<uint32_t> &src_indices, const Partition &src_partition, uint32_t vertex_start );
         bool is_append_compatible( const Mesh &other );
         void add_partition( uint32_t v_count, uint32_t i_count );
 
     public:
+        static const uint8_t
+        LAYOUT_SEPARATE = 0,
+        LAYOUT_INTERLEAVED = 1;
+
         bool updated = false;
 
         void set_attribute_format( uint8_t attrb, uint8_t data_type, uint8_t vector_size );
@@ -232,8 +369,15 @@ class Mesh {
         void remove_attribute( uint8_t attrb );
         void clear();
         void to_VAO( VAO *vao, uint32_t partition_first = 0, uint32_t partition_last = UINT32_MAX );
+        void invalidate();
+        void set_layout( uint8_t layout );
+        uint8_t get_layout();
+        uint32_t get_vertex_count();
+        uint32_t get_vertex_size( uint8_t layout );
+        void optimize( float &acmr_before, float &acmr_after );
         void merge_partitions();
         void get_bounding_box( uint32_t partition, vec3 *box );
+        const MeshBounds &get_bounds();
 };
 
 #endif // MESH_H
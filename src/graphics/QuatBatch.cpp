@@ -0,0 +1,164 @@
+#include "QuatBatch.h"
+#include "SimdFloat4.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace QuatBatch {
+
+    using namespace SimdFloat4;
+    using SimdFloat4::load;
+    using SimdFloat4::store;
+
+    struct Q4 {
+        F4 x, y, z, w;
+    };
+
+    static inline Q4 load( const QuatArray &q, uint32_t i ) {
+        return { load( &q.x[i] ), load( &q.y[i] ), load( &q.z[i] ), load( &q.w[i] ) };
+    }
+
+    static inline void store( QuatArray &q, uint32_t i, const Q4 &a ) {
+        store( &q.x[i], a.x ), store( &q.y[i], a.y ), store( &q.z[i], a.z ), store( &q.w[i], a.w );
+    }
+
+    static inline F4 dot( const Q4 &a, const Q4 &b ) {
+        return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    }
+
+    static inline Q4 normalized( const Q4 &a ) {
+        F4 inv = splat( 1 ) / sqrt( dot( a, a ) );
+        return { a.x * inv, a.y * inv, a.z * inv, a.w * inv };
+    }
+
+    // wa * a + wb * b
+    static inline Q4 weighted( const Q4 &a, F4 wa, const Q4 &b, F4 wb ) {
+        return { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+    }
+
+    // acos for x in [0, 1], error within 7e-5 radians
+    static inline F4 acos_positive( F4 x ) {
+        F4 p = splat( -0.0187293f );
+        p = p * x + splat( 0.0742610f );
+        p = p * x - splat( 0.2121144f );
+        p = p * x + splat( 1.5707288f );
+        return p * sqrt( splat( 1 ) - x );
+    }
+
+    // sin for x in [0, pi/2], error within 4e-6
+    static inline F4 sin_quadrant( F4 x ) {
+        F4 x2 = x * x;
+        F4 p = splat( 1.0f / 362880 );
+        p = p * x2 - splat( 1.0f / 5040 );
+        p = p * x2 + splat( 1.0f / 120 );
+        p = p * x2 - splat( 1.0f / 6 );
+        p = p * x2 + splat( 1 );
+        return p * x;
+    }
+
+    void QuatArray::resize( uint32_t count ) {
+        count = padded( count );
+        x.resize( count, 0 ), y.resize( count, 0 ), z.resize( count, 0 ), w.resize( count, 1 );
+    }
+
+    void QuatArray::set( uint32_t i, const versor q ) {
+        x[i] = q[0], y[i] = q[1], z[i] = q[2], w[i] = q[3];
+    }
+
+    void QuatArray::get( uint32_t i, versor q ) const {
+        q[0] = x[i], q[1] = y[i], q[2] = z[i], q[3] = w[i];
+    }
+
+    void QuatArray::set_identity( uint32_t i ) {
+        x[i] = 0, y[i] = 0, z[i] = 0, w[i] = 1;
+    }
+
+    void nlerp( const QuatArray &a, const QuatArray &b, const float *t, QuatArray &dest, uint32_t count ) {
+        for( uint32_t i = 0; i < count; i += 4 ) {
+            Q4 qa = load( a, i ), qb = load( b, i );
+            F4 ft = load( t + i );
+
+            // Flip b to the same hemisphere as a
+            F4 d = dot( qa, qb );
+            F4 wb = copy_sign( ft, d );
+            F4 wa = splat( 1 ) - ft;
+
+            store( dest, i, normalized( weighted( qa, wa, qb, wb ) ) );
+        }
+    }
+
+    void slerp( const QuatArray &a, const QuatArray &b, const float *t, QuatArray &dest, uint32_t count ) {
+        const F4 one = splat( 1 );
+        const F4 nearly_parallel = splat( 0.9995f );
+
+        for( uint32_t i = 0; i < count; i += 4 ) {
+            Q4 qa = load( a, i ), qb = load( b, i );
+            F4 ft = load( t + i );
+            F4 d = dot( qa, qb );
+            F4 cos_angle = abs( d );
+
+            // Weights along the arc, the angle between the quaternions is at most pi/2 after flipping
+            F4 angle = acos_positive( cos_angle );
+            F4 inv_sin = one / sin_quadrant( angle );
+            F4 wa = sin_quadrant( ( one - ft ) * angle ) * inv_sin;
+            F4 wb = sin_quadrant( ft * angle ) * inv_sin;
+
+            // Nearly parallel quaternions divide by almost 0, use linear weights there
+            F4 parallel = greater( cos_angle, nearly_parallel );
+            wa = select( parallel, one - ft, wa );
+            wb = copy_sign( select( parallel, ft, wb ), d );
+
+            // Normalizing removes the error of the approximations
+            store( dest, i, normalized( weighted( qa, wa, qb, wb ) ) );
+        }
+    }
+
+    void mul( const QuatArray &a, const QuatArray &b, QuatArray &dest, uint32_t count ) {
+        for( uint32_t i = 0; i < count; i += 4 ) {
+            Q4 p = load( a, i ), q = load( b, i );
+            Q4 r;
+            r.x = p.w * q.x + p.x * q.w + p.y * q.z - p.z * q.y;
+            r.y = p.w * q.y - p.x * q.z + p.y * q.w + p.z * q.x;
+            r.z = p.w * q.z + p.x * q.y - p.y * q.x + p.z * q.w;
+            r.w = p.w * q.w - p.x * q.x - p.y * q.y - p.z * q.z;
+            store( dest, i, r );
+        }
+    }
+
+    void normalize( QuatArray &q, uint32_t count ) {
+        for( uint32_t i = 0; i < count; i += 4 ) {
+            store( q, i, normalized( load( q, i ) ) );
+        }
+    }
+
+    void to_mat4( const QuatArray &rot, const float *x, const float *y, const float *z, mat4 *dest, uint32_t count ) {
+        const F4 zero = splat( 0 ), one = splat( 1 );
+
+        for( uint32_t i = 0; i < count; i += 4 ) {
+            Q4 q = load( rot, i );
+
+            // Scaling by the squared length keeps unnormalized quaternions the same as glm_quat_mat4
+            F4 s = splat( 2 ) / dot( q, q );
+            F4 xs = q.x * s, ys = q.y * s, zs = q.z * s;
+            F4 xx = q.x * xs, yy = q.y * ys, zz = q.z * zs;
+            F4 xy = q.x * ys, xz = q.x * zs, yz = q.y * zs;
+            F4 wx = q.w * xs, wy = q.w * ys, wz = q.w * zs;
+
+            // Each row holds one element of 4 matrices, transposing gives a column of each matrix
+            F4 columns[4][4] = {
+                { one - yy - zz, xy + wz, xz - wy, zero },
+                { xy - wz, one - xx - zz, yz + wx, zero },
+                { xz + wy, yz - wx, one - xx - yy, zero },
+                { load( x + i ), load( y + i ), load( z + i ), one }
+            };
+
+            uint32_t n = std::min( 4u, count - i );
+
+            for( uint32_t c = 0; c < 4; ++c ) {
+                transpose( columns[c] );
+                for( uint32_t k = 0; k < n; ++k )
+                    store( dest[i + k][c], columns[c][k] );
+            }
+        }
+    }
+}
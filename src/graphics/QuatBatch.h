@@ -0,0 +1,42 @@
+#ifndef QUATBATCH_H
+#define QUATBATCH_H
+
+#include <vector>
+#include <inttypes.h>
+#include <cglm/quat.h>
+#include <cglm/mat4.h>
+
+/*
+ * Quaternion kernels over many quaternions at once.
+ * Quaternions are stored as separate x, y, z and w arrays so 4 are processed per SIMD operation.
+ */
+namespace QuatBatch {
+
+    // Arrays are padded to a multiple of 4 with identity quaternions, factor arrays passed to kernels need the same padding
+    struct QuatArray {
+        std::vector<float> x, y, z, w;
+
+        void resize( uint32_t count );
+        void set( uint32_t i, const versor q );
+        void get( uint32_t i, versor q ) const;
+        void set_identity( uint32_t i );
+        inline uint32_t size() const { return x.size(); }
+        static inline uint32_t padded( uint32_t count ) { return ( count + 3 ) & ~3u; }
+    };
+
+    // Shortest path interpolation from a to b by t, normalized
+    void nlerp( const QuatArray &a, const QuatArray &b, const float *t, QuatArray &dest, uint32_t count );
+
+    // Constant speed interpolation from a to b by t, nearly parallel quaternions use nlerp
+    void slerp( const QuatArray &a, const QuatArray &b, const float *t, QuatArray &dest, uint32_t count );
+
+    // The product a * b, the same as glm_quat_mul
+    void mul( const QuatArray &a, const QuatArray &b, QuatArray &dest, uint32_t count );
+
+    void normalize( QuatArray &q, uint32_t count );
+
+    // Translation and rotation matrices, the same as glm_translate_make followed by glm_quat_rotate, positions need the same padding
+    void to_mat4( const QuatArray &rot, const float *x, const float *y, const float *z, mat4 *dest, uint32_t count );
+};
+
+#endif // QUATBATCH_H
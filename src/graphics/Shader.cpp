@@ -53,6 +53,9 @@ void Shader::linkDefaultUniforms() {
     uniform_locations[UNIFORM_TEXID] = glGetUniformLocation( program_id, "tex_id" )  ;
     uniform_locations[UNIFORM_TEXDIM] = glGetUniformLocation( program_id, "tex_dim" )  ;
     uniform_locations[UNIFORM_JOINTS] = glGetUniformLocation( program_id, "joints" ) ;
+    uniform_locations[UNIFORM_TEXRECT] = glGetUniformLocation( program_id, "tex_rect" ) ;
+    uniform_locations[UNIFORM_JOINT_DQS] = glGetUniformLocation( program_id, "joint_dqs" ) ;
+    uniform_locations[UNIFORM_TEXT_EFFECTS] = glGetUniformLocation( program_id, "text_effects" ) ;
 }
 
 void Shader::linkUniform( std::string uniformName, Uniform uniform ) {
@@ -72,6 +75,10 @@ void Shader::uniformVec4f( Uniform uniform, const vec4 &vec ) {
     glUniform4fv( active->uniform_locations[uniform], 1, vec );
 }
 
+void Shader::uniformVec4fArray( Uniform uniform, vec4 *vectors, uint32_t count ) {
+    glUniform4fv( active->uniform_locations[uniform], count, vectors[0] );
+}
+
 void Shader::uniformVec3f( Uniform uniform, const vec3 &vec ) {
     glUniform3fv( active->uniform_locations[uniform], 1, vec );
 }
@@ -92,6 +99,10 @@ void Shader::uniformUint( Uniform uniform, uint32_t i ) {
     glUniform1ui( active->uniform_locations[uniform], i );
 }
 
+bool Shader::hasUniform( Uniform uniform ) {
+    return active && (int32_t)active->uniform_locations[uniform] != -1;
+}
+
 bool Shader::bind(Shader &shader) {
     active = &shader;
     if( glIsProgram( active->program_id ) == GL_TRUE ){
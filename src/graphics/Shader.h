@@ -30,6 +30,9 @@ enum Uniform : uint8_t {
     UNIFORM_TEXDIM,      // The texture dimensions
     UNIFORM_FACTOR,      // f any given factor
     UNIFORM_JOINTS,      // mat4[] list of joint transforms
+    UNIFORM_TEXRECT,     // vec4[2] atlas rects of the selected textures
+    UNIFORM_JOINT_DQS,   // vec4[] joint transforms relative to the transform as dual quaternions, real then dual part
+    UNIFORM_TEXT_EFFECTS,// vec4 outline width, shadow offset x and y, shadow softness of distance field text
     NUM_UNIFORMS         // Last enum, number of existing uniforms
 };
 
@@ -64,12 +67,16 @@ class Shader {
         static void uniformMat4f( Uniform, const mat4& );
         static void uniformMat4fArray(Uniform, mat4*, uint32_t);
         static void uniformVec4f( Uniform, const vec4& );
+        static void uniformVec4fArray( Uniform, vec4*, uint32_t );
         static void uniformVec3f( Uniform, const vec3& );
         static void uniformVec2f( Uniform, const vec2& );
         static void uniformFloat( Uniform, float );
         static void uniformInt( Uniform, int );
         static void uniformUint( Uniform, uint32_t );
 
+        // Whether the bound shader uses a uniform
+        static bool hasUniform( Uniform );
+
     private:
         void linkDefaultAttributes();
         void linkDefaultUniforms();
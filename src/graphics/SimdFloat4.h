@@ -0,0 +1,84 @@
+#ifndef SIMDFLOAT4_H
+#define SIMDFLOAT4_H
+
+#include <inttypes.h>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define SIMDFLOAT4_SSE2 1
+#endif
+
+/*
+ * 4 floats processed together, SSE when available and plain loops otherwise.
+ * Masks are all bits set in lanes where a comparison holds, they combine with &.
+ */
+namespace SimdFloat4 {
+
+#if defined( SIMDFLOAT4_SSE2 )
+    struct F4 {
+        __m128 v;
+    };
+
+    inline F4 load( const float *p ) { return { _mm_loadu_ps( p ) }; }
+    inline void store( float *p, F4 a ) { _mm_storeu_ps( p, a.v ); }
+    inline F4 splat( float f ) { return { _mm_set1_ps( f ) }; }
+    inline F4 operator+( F4 a, F4 b ) { return { _mm_add_ps( a.v, b.v ) }; }
+    inline F4 operator-( F4 a, F4 b ) { return { _mm_sub_ps( a.v, b.v ) }; }
+    inline F4 operator*( F4 a, F4 b ) { return { _mm_mul_ps( a.v, b.v ) }; }
+    inline F4 operator/( F4 a, F4 b ) { return { _mm_div_ps( a.v, b.v ) }; }
+    inline F4 sqrt( F4 a ) { return { _mm_sqrt_ps( a.v ) }; }
+    inline F4 greater( F4 a, F4 b ) { return { _mm_cmpgt_ps( a.v, b.v ) }; }
+
+    // The sign bit of s applied to a
+    inline F4 copy_sign( F4 a, F4 s ) { return { _mm_xor_ps( a.v, _mm_and_ps( s.v, _mm_set1_ps( -0.0f ) ) ) }; }
+    inline F4 abs( F4 a ) { return { _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.v ) }; }
+    inline F4 select( F4 mask, F4 a, F4 b ) { return { _mm_or_ps( _mm_and_ps( mask.v, a.v ), _mm_andnot_ps( mask.v, b.v ) ) }; }
+    inline void transpose( F4 *r ) { _MM_TRANSPOSE4_PS( r[0].v, r[1].v, r[2].v, r[3].v ); }
+    inline F4 operator&( F4 a, F4 b ) { return { _mm_and_ps( a.v, b.v ) }; }
+    inline F4 min( F4 a, F4 b ) { return { _mm_min_ps( a.v, b.v ) }; }
+    inline F4 max( F4 a, F4 b ) { return { _mm_max_ps( a.v, b.v ) }; }
+#else
+    struct F4 {
+        float v[4];
+    };
+
+    template<typename Fn>
+    inline F4 each( Fn fn ) {
+        F4 r;
+        for( uint32_t i = 0; i < 4; ++i )
+            r.v[i] = fn( i );
+        return r;
+    }
+
+    inline F4 load( const float *p ) { return each( [&]( uint32_t i ) { return p[i]; } ); }
+    inline void store( float *p, F4 a ) { memcpy( p, a.v, 16 ); }
+    inline F4 splat( float f ) { return each( [&]( uint32_t ) { return f; } ); }
+    inline F4 operator+( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] + b.v[i]; } ); }
+    inline F4 operator-( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] - b.v[i]; } ); }
+    inline F4 operator*( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] * b.v[i]; } ); }
+    inline F4 operator/( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] / b.v[i]; } ); }
+    inline F4 sqrt( F4 a ) { return each( [&]( uint32_t i ) { return sqrtf( a.v[i] ); } ); }
+    inline F4 greater( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] > b.v[i] ? 1.0f : 0.0f; } ); }
+    inline F4 copy_sign( F4 a, F4 s ) { return each( [&]( uint32_t i ) { return s.v[i] < 0 ? -a.v[i] : a.v[i]; } ); }
+    inline F4 abs( F4 a ) { return each( [&]( uint32_t i ) { return fabsf( a.v[i] ); } ); }
+    inline F4 select( F4 mask, F4 a, F4 b ) { return each( [&]( uint32_t i ) { return mask.v[i] != 0 ? a.v[i] : b.v[i]; } ); }
+
+    inline void transpose( F4 *r ) {
+        for( uint32_t i = 0; i < 4; ++i ) {
+            for( uint32_t j = i + 1; j < 4; ++j )
+                std::swap( r[i].v[j], r[j].v[i] );
+        }
+    }
+
+    inline F4 operator&( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] != 0 && b.v[i] != 0 ? 1.0f : 0.0f; } ); }
+    inline F4 min( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] < b.v[i] ? a.v[i] : b.v[i]; } ); }
+    inline F4 max( F4 a, F4 b ) { return each( [&]( uint32_t i ) { return a.v[i] > b.v[i] ? a.v[i] : b.v[i]; } ); }
+#endif
+
+    inline F4 less( F4 a, F4 b ) { return greater( b, a ); }
+};
+
+#endif // SIMDFLOAT4_H
@@ -0,0 +1,288 @@
+#include "SoftbodySystem.h"
+#include "SimdFloat4.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace SimdFloat4;
+
+namespace {
+
+    struct V3 {
+        F4 x, y, z;
+    };
+
+    struct Q4 {
+        F4 x, y, z, w;
+    };
+
+    inline V3 operator+( const V3 &a, const V3 &b ) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    inline V3 operator-( const V3 &a, const V3 &b ) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    inline V3 operator*( const V3 &a, F4 s ) { return { a.x * s, a.y * s, a.z * s }; }
+
+    inline F4 dot( const V3 &a, const V3 &b ) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    inline V3 cross( const V3 &a, const V3 &b ) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    inline V3 select( F4 mask, const V3 &a, const V3 &b ) { return { select( mask, a.x, b.x ), select( mask, a.y, b.y ), select( mask, a.z, b.z ) }; }
+
+    inline V3 lerp( const V3 &a, const V3 &b, F4 t ) { return a + ( b - a ) * t; }
+
+    inline Q4 normalized( const Q4 &q ) {
+        F4 inv = splat( 1 ) / sqrt( q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w );
+        return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+    }
+
+    inline Q4 mul( const Q4 &p, const Q4 &q ) {
+        return { p.w * q.x + p.x * q.w + p.y * q.z - p.z * q.y,
+                 p.w * q.y - p.x * q.z + p.y * q.w + p.z * q.x,
+                 p.w * q.z + p.x * q.y - p.y * q.x + p.z * q.w,
+                 p.w * q.w - p.x * q.x - p.y * q.y - p.z * q.z };
+    }
+
+    // Same as glm_quat_nlerp, b is flipped to the hemisphere of a
+    inline Q4 nlerp( const Q4 &a, const Q4 &b, F4 t ) {
+        F4 wb = copy_sign( t, a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w );
+        F4 wa = splat( 1 ) - t;
+        return normalized( { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb } );
+    }
+
+    // The +y axis of a rotation
+    inline V3 rotate_up( const Q4 &q ) {
+        return { splat( 2 ) * ( q.x * q.y - q.w * q.z ),
+                 splat( 1 ) - splat( 2 ) * ( q.x * q.x + q.z * q.z ),
+                 splat( 2 ) * ( q.y * q.z + q.w * q.x ) };
+    }
+
+    inline V3 normalized( const V3 &v ) {
+        return v * ( splat( 1 ) / sqrt( max( dot( v, v ), splat( 1e-30f ) ) ) );
+    }
+
+    // Rotation from unit vector a to unit vector b, half a turn around an axis across a when they are opposite
+    inline Q4 from_vecs( const V3 &a, const V3 &b ) {
+        F4 w = splat( 1 ) + dot( a, b );
+        V3 axis = cross( a, b );
+
+        V3 across = cross( a, { splat( 1 ), splat( 0 ), splat( 0 ) } );
+        across = select( greater( dot( across, across ), splat( 1e-6f ) ), across, cross( a, { splat( 0 ), splat( 0 ), splat( 1 ) } ) );
+
+        F4 opposite = greater( splat( 1e-6f ), w );
+        axis = select( opposite, across, axis );
+        w = select( opposite, splat( 0 ), w );
+
+        return normalized( Q4{ axis.x, axis.y, axis.z, w } );
+    }
+
+    inline V3 load3( std::vector<float> *fields, uint32_t first, uint32_t i ) {
+        return { load( &fields[first][i] ), load( &fields[first + 1][i] ), load( &fields[first + 2][i] ) };
+    }
+
+    inline Q4 load4( std::vector<float> *fields, uint32_t first, uint32_t i ) {
+        return { load( &fields[first][i] ), load( &fields[first + 1][i] ), load( &fields[first + 2][i] ), load( &fields[first + 3][i] ) };
+    }
+
+    inline void store3( std::vector<float> *fields, uint32_t first, uint32_t i, const V3 &v ) {
+        store( &fields[first][i], v.x ), store( &fields[first + 1][i], v.y ), store( &fields[first + 2][i], v.z );
+    }
+}
+
+void SoftbodySystem::clear() {
+    chains.clear();
+}
+
+void SoftbodySystem::add_chain( Armature &a, ConstraintSoftbody *first ) {
+    uint32_t length = 0;
+    for( ConstraintSoftbody *c = first; c; c = c->get_child( a ) )
+        ++length;
+
+    chains.push_back( { &a, first, length } );
+}
+
+void SoftbodySystem::add( Armature &a ) {
+    for( uint8_t c : a.constrained_joints ) {
+        Constraint *con = a.constraints[a.joints[c].constraint_id].get();
+        if( con->type == Constraint::SOFTBODY && !( (ConstraintSoftbody *)con )->parent_softbody )
+            add_chain( a, (ConstraintSoftbody *)con );
+    }
+}
+
+/*
+ * Steps every joint of the 4 chains of a block from the first to the last in each substep, each joint starts from the tail of the last.
+ * The head and rotation of the first joint are interpolated across the update so the substeps see the same motion at any frame rate.
+ * Lanes with fewer substeps or shorter chains keep their values through a mask.
+ */
+void SoftbodySystem::solve_block( uint32_t block ) {
+    const Block &b = blocks[block];
+    uint32_t l = block * 4;
+
+    V3 last_head = load3( lanes, LAST_HEAD_X, l ), anim_head = load3( lanes, HEAD_X, l );
+    Q4 last_rot = load4( lanes, LAST_ROT_X, l ), anim_rot = load4( lanes, ROT_X, l );
+    F4 substeps = load( &lanes[SUBSTEPS][l] );
+    F4 frame_start = load( &lanes[FRAME_START][l] );
+    F4 frame_time = load( &lanes[FRAME_TIME][l] );
+    F4 timestep = load( &lanes[TIMESTEP][l] );
+    F4 zero = splat( 0 ), one = splat( 1 ), half = splat( 0.5f );
+
+    for( uint32_t s = 0; s < b.substeps; ++s ) {
+        F4 running = greater( substeps, splat( s ) );
+
+        // Fraction of the update at the end of this substep, as ConstraintClock::substep_fraction
+        F4 f = ( splat( s + 1 ) * timestep - frame_start ) / frame_time;
+        f = select( greater( frame_time, zero ), min( max( f, zero ), one ), one );
+
+        V3 head = lerp( last_head, anim_head, f );
+        Q4 rot = nlerp( last_rot, anim_rot, f );
+
+        for( uint32_t k = 0; k < b.length; ++k ) {
+            uint32_t p = b.first_particle + k * 4;
+            F4 m = running & greater( load( &particles[ACTIVE][p] ), half );
+            F4 length = load( &particles[LENGTH][p] );
+
+            V3 tail = load3( particles, TAIL_X, p );
+            V3 last_tail = load3( particles, LAST_TAIL_X, p );
+            V3 last_anim = load3( particles, LAST_ANIM_X, p );
+
+            // Movement of the head and tail over the last step, and the tail's own movement without the head's
+            V3 head_move = head - last_anim;
+            V3 local_move = ( tail - last_tail ) - head_move;
+            V3 moved = tail + head_move * load( &particles[KEEP_DRAG][p] ) + local_move * load( &particles[KEEP_FRICTION][p] );
+            moved.y = moved.y - load( &particles[GRAVITY][p] );
+
+            // Length elasticity
+            V3 to_tail = moved - head;
+            V3 correction = head + to_tail * ( length / ( sqrt( dot( to_tail, to_tail ) ) + splat( GLM_FLT_EPSILON ) ) ) - moved;
+            moved = moved + correction * load( &particles[ELASTICITY][p] );
+
+            // Restoration using rigidity
+            V3 up = rotate_up( rot );
+            correction = head + up * length - moved;
+            moved = moved + correction * load( &particles[RIGIDITY][p] );
+
+            store3( particles, LAST_TAIL_X, p, select( m, tail, last_tail ) );
+            store3( particles, LAST_ANIM_X, p, select( m, head, last_anim ) );
+            store3( particles, TAIL_X, p, select( m, moved, tail ) );
+
+            // The next joint is animated relative to this joint turned towards its tail
+            Q4 turn = from_vecs( up, normalized( moved - head ) );
+            Q4 child = load4( particles, CHILD_ROT_X, p );
+            rot = normalized( mul( mul( turn, rot ), child ) );
+            head = moved;
+        }
+    }
+
+    // Place the tails between the last two steps
+    F4 alpha = load( &lanes[ALPHA][l] );
+    for( uint32_t k = 0; k < b.length; ++k ) {
+        uint32_t p = b.first_particle + k * 4;
+        store3( particles, RENDER_X, p, lerp( load3( particles, LAST_TAIL_X, p ), load3( particles, TAIL_X, p ), alpha ) );
+    }
+}
+
+/*
+ * Chains of similar length share a block so few lanes are wasted, empty lanes and links are padded and masked off.
+ */
+void SoftbodySystem::solve() {
+
+    std::stable_sort( chains.begin(), chains.end(), []( const Chain &a, const Chain &b ) { return a.length < b.length; } );
+
+    blocks.clear();
+    uint32_t particle_count = 0;
+
+    for( uint32_t i = 0; i < chains.size(); i += 4 ) {
+        Block b = { particle_count, 0, 0 };
+        for( uint32_t c = i; c < std::min<uint32_t>( i + 4, chains.size() ); ++c ) {
+            b.length = std::max( b.length, chains[c].length );
+            b.substeps = std::max( b.substeps, chains[c].armature->constraint_clock.substeps );
+        }
+        blocks.push_back( b );
+        particle_count += b.length * 4;
+    }
+
+    // Padding is still, with a unit length and identity rotations so it stays finite
+    for( std::vector<float> &f : lanes )
+        f.assign( blocks.size() * 4, 0 );
+    for( std::vector<float> &f : particles )
+        f.assign( particle_count, 0 );
+
+    lanes[LAST_ROT_W].assign( blocks.size() * 4, 1 );
+    lanes[ROT_W].assign( blocks.size() * 4, 1 );
+    particles[CHILD_ROT_W].assign( particle_count, 1 );
+    particles[LENGTH].assign( particle_count, 1 );
+    links.assign( particle_count, nullptr );
+
+    // Gather
+    for( uint32_t i = 0; i < chains.size(); ++i ) {
+        const Chain &chain = chains[i];
+        const Block &b = blocks[i / 4];
+        const ConstraintClock &clock = chain.armature->constraint_clock;
+        ConstraintSoftbody *root = chain.first;
+        uint32_t l = i;
+
+        for( uint32_t d = 0; d < 3; ++d ) {
+            lanes[LAST_HEAD_X + d][l] = root->last_head[d];
+            lanes[HEAD_X + d][l] = root->anim_head[d];
+        }
+        for( uint32_t d = 0; d < 4; ++d ) {
+            lanes[LAST_ROT_X + d][l] = root->last_rot[d];
+            lanes[ROT_X + d][l] = root->anim_rot[d];
+        }
+
+        lanes[SUBSTEPS][l] = clock.substeps;
+        lanes[FRAME_START][l] = clock.frame_start;
+        lanes[FRAME_TIME][l] = clock.frame_time;
+        lanes[TIMESTEP][l] = clock.timestep;
+        lanes[ALPHA][l] = clock.alpha;
+
+        // The next update interpolates from this one
+        glm_vec3_copy( root->anim_head, root->last_head );
+        glm_quat_copy( root->anim_rot, root->last_rot );
+
+        float h = clock.timestep;
+        uint32_t p = b.first_particle + i % 4;
+
+        for( ConstraintSoftbody *c = root; c; c = c->get_child( *chain.armature ), p += 4 ) {
+            links[p] = c;
+
+            for( uint32_t d = 0; d < 3; ++d ) {
+                particles[TAIL_X + d][p] = c->tail[d];
+                particles[LAST_TAIL_X + d][p] = c->last_tail[d];
+                particles[LAST_ANIM_X + d][p] = c->last_anim_pos[d];
+            }
+
+            ConstraintSoftbody *child = c->get_child( *chain.armature );
+            if( child ) {
+                for( uint32_t d = 0; d < 4; ++d )
+                    particles[CHILD_ROT_X + d][p] = chain.armature->get_joint( child->joint ).rot[d];
+            }
+
+            const ConstraintSoftbody::StepAmounts &amounts = c->get_step_amounts( h );
+            particles[KEEP_DRAG][p] = amounts.keep_drag;
+            particles[KEEP_FRICTION][p] = amounts.keep_friction;
+            particles[GRAVITY][p] = amounts.gravity;
+            particles[ELASTICITY][p] = amounts.elasticity;
+            particles[RIGIDITY][p] = amounts.rigidity;
+            particles[LENGTH][p] = chain.armature->scale_constraint * c->settings.joint_length;
+            particles[ACTIVE][p] = 1;
+        }
+    }
+
+    uint32_t per_task = std::max( blocks_per_task, 1u );
+    uint32_t tasks = ( blocks.size() + per_task - 1 ) / per_task;
+
+    ThreadPool::parallel_for( tasks, thread_count, [&]( uint32_t t ) {
+        for( uint32_t b = t * per_task; b < std::min<uint32_t>( ( t + 1 ) * per_task, blocks.size() ); ++b )
+            solve_block( b );
+    } );
+
+    // Scatter
+    for( uint32_t p = 0; p < particle_count; ++p ) {
+        ConstraintSoftbody *c = links[p];
+        if( !c )
+            continue;
+
+        for( uint32_t d = 0; d < 3; ++d ) {
+            c->tail[d] = particles[TAIL_X + d][p];
+            c->last_tail[d] = particles[LAST_TAIL_X + d][p];
+            c->last_anim_pos[d] = particles[LAST_ANIM_X + d][p];
+            c->render_tail[d] = particles[RENDER_X + d][p];
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef SOFTBODYSYSTEM_H
+#define SOFTBODYSYSTEM_H
+
+#include <vector>
+#include <inttypes.h>
+#include "Armature.h"
+
+/*
+ * Steps the softbody chains of many armatures together.
+ * Chains are gathered into flat arrays each update and grouped in blocks of 4, one chain per SIMD lane.
+ * Blocks are spread across threads, then the results are written back to the constraints.
+ * An armature steps its own chains through a system holding only that armature unless batch_softbodies is set.
+ */
+class SoftbodySystem {
+
+    struct Chain {
+        Armature *armature;
+        ConstraintSoftbody *first;
+        uint32_t length;
+    };
+
+    // A block holds 4 chains, its particles are stored by link then by lane
+    struct Block {
+        uint32_t first_particle;
+        uint32_t length;
+        uint32_t substeps;
+    };
+
+    std::vector<Chain> chains;
+    std::vector<Block> blocks;
+    std::vector<ConstraintSoftbody *> links;
+
+    // Values of each chain, indexed by lane across all blocks
+    enum LaneField : uint8_t {
+        LAST_HEAD_X, LAST_HEAD_Y, LAST_HEAD_Z,
+        HEAD_X, HEAD_Y, HEAD_Z,
+        LAST_ROT_X, LAST_ROT_Y, LAST_ROT_Z, LAST_ROT_W,
+        ROT_X, ROT_Y, ROT_Z, ROT_W,
+        SUBSTEPS, FRAME_START, FRAME_TIME, TIMESTEP, ALPHA,
+        NUM_LANE_FIELDS
+    };
+
+    // Values of each joint of each chain
+    enum ParticleField : uint8_t {
+        TAIL_X, TAIL_Y, TAIL_Z,
+        LAST_TAIL_X, LAST_TAIL_Y, LAST_TAIL_Z,
+        LAST_ANIM_X, LAST_ANIM_Y, LAST_ANIM_Z,
+        RENDER_X, RENDER_Y, RENDER_Z,
+        CHILD_ROT_X, CHILD_ROT_Y, CHILD_ROT_Z, CHILD_ROT_W,
+        KEEP_DRAG, KEEP_FRICTION, GRAVITY, ELASTICITY, RIGIDITY, LENGTH, ACTIVE,
+        NUM_PARTICLE_FIELDS
+    };
+
+    std::vector<float> lanes[NUM_LANE_FIELDS];
+    std::vector<float> particles[NUM_PARTICLE_FIELDS];
+
+    void solve_block(uint32_t block);
+
+public:
+
+    // Threads used by solve, 0 uses one per core
+    uint32_t thread_count = 0;
+
+    // Blocks given to a thread at a time
+    uint32_t blocks_per_task = 16;
+
+    void clear();
+
+    // Adds a chain starting at a softbody without a parent softbody, the constraint must have been updated this frame
+    void add_chain(Armature &a, ConstraintSoftbody *first);
+
+    // Adds every chain of an armature
+    void add(Armature &a);
+
+    // Steps every chain by the substeps of its armature's clock and writes the results back to the constraints
+    void solve();
+
+    inline uint32_t get_chain_count() const{ return chains.size(); }
+    inline uint32_t get_particle_count() const{ return links.size(); }
+};
+
+#endif // SOFTBODYSYSTEM_H
@@ -48,6 +48,12 @@ void Texture::load_png(std::string filename, uint32_t scale_type, uint32_t exten
     }
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
     stbi_image_free(data);
+
+    // Linear textures are mipmapped so they do not alias when scaled down
+    if(scale_type == GL_LINEAR){
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
 }
 
 /*
@@ -83,6 +89,30 @@ void Texture::allocate(){
         glGenTextures(1, &tid);
 }
 
+void Texture::allocate_empty(uint32_t width, uint32_t height, uint32_t format, uint32_t scale_type){
+    allocate();
+    glBindTexture(GL_TEXTURE_2D, tid);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, scale_type );
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, scale_type );
+    this->width = width, this->height = height, channels = format == GL_RED ? 1 : 4;
+
+    // Cleared so regions that were never written sample as empty
+    std::vector<uint8_t> zero(width * height * channels, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, zero.data());
+}
+
+void Texture::upload_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t format, const void *data){
+    if(!is_allocated())
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, tid);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, data);
+}
+
 bool Texture::is_allocated(){
     return tid != 0;
 }
@@ -147,7 +177,7 @@ void TextureArray::load_atlas(std::string filename,  uint8_t tile_count, uint32_
     unsigned char *data = nullptr;
     {
         int w, h, c;
-        unsigned char *data = stbi_load(filepath.c_str(), &w, &h, &c, 0);
+        data = stbi_load(filepath.c_str(), &w, &h, &c, 0);
         width = w, height = h, channels = c;
     }
     if(!data){
@@ -158,11 +188,13 @@ void TextureArray::load_atlas(std::string filename,  uint8_t tile_count, uint32_
     if(width != height){
         printf("Failed to load atlas, texture must be a square : %s\n", filename.c_str());
         fflush(stdout);
+        stbi_image_free(data);
         return;
     }
     if(width%tile_count != 0){
         printf("Failed to load atlas, dimensions must be multiple of tile count : %s\n", filename.c_str());
         fflush(stdout);
+        stbi_image_free(data);
         return;
     }
 
@@ -177,77 +209,18 @@ void TextureArray::load_atlas(std::string filename,  uint8_t tile_count, uint32_
     for(uint32_t y = 0; y < tile_count; ++y){
         for( uint32_t x = 0; x < tile_count; ++x){
             // Find the offset in the data that is represented by x and y
-            unsigned char* subdata = data + (channels*tile_size)*(y*width + x);
+            unsigned char* subdata = data + channels*tile_size*(y*width + x);
 
             // Copy the tile over row-by-row
             for(uint32_t r = 0; r < tile_size; ++r){
                 std::copy(subdata + r*width*channels, subdata+ channels*(r*width + tile_size), tile.begin() + r*tile_size*channels);
-
-                uint32_t i = y * tile_count + x;
-                glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, tile_size, tile_size, 1, format, GL_UNSIGNED_BYTE, tile.data());
             }
+
+            // Upload the whole tile once
+            uint32_t i = y * tile_count + x;
+            glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, tile_size, tile_size, 1, format, GL_UNSIGNED_BYTE, tile.data());
         }
     }
 
     stbi_image_free(data);
 }
-
-void TextureArray::load_file_list(std::vector<std::string> filenames,  uint32_t scale_type, uint32_t extention_type, uint32_t format){
-
-    allocate();
-    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_id);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, extention_type);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, extention_type);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, scale_type );
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, scale_type );
-
-    uint32_t image_id = 0;
-    width = 0; height = 0, channels = 0;
-    std::string filepath;
-    bool initialized = false;
-
-    for(std::string& filename : filenames){
-        // Place name in map
-
-        bool failed = false;
-        // Read data from each file, if data is not read, a blank texture is used instead
-        filepath = (std::string)DIR_TEXTURES + filename + ".png";
-        unsigned char *data = nullptr;
-        {
-            int w, h, c;
-            data = stbi_load(filepath.c_str(), &w, &h, &c, 0);
-
-            if(!initialized){
-                width = w, height = h, channels = c;
-                // Create an empty texture slot to fill
-                glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, width, height, filenames.size(), 0, format, GL_UNSIGNED_BYTE, nullptr);
-                initialized = true;
-            }
-            else if(w!=width || h!=height || c!=channels){
-                printf("Dimensions do not match previous images in list: %s\n", filename.c_str());
-                fflush(stdout);
-                failed = true;
-                if(data)
-                     stbi_image_free(data);
-                ++image_id;
-                continue;
-            }
-        }
-
-        // If the data failed to load, skip the image
-        if(!data){
-            printf("Failed to load image in image list : %s\n", filename.c_str());
-            fflush(stdout);
-            ++image_id;
-            continue;
-        }
-
-        // Load subimage
-        glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, 0, 0, image_id, width, height, 1, format, GL_UNSIGNED_BYTE, data);
-
-        // Free the data
-        stbi_image_free(data);
-
-        ++image_id;
-    }
-}
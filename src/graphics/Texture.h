@@ -29,6 +29,10 @@ class Texture {
     void load_png ( std::string filename, uint32_t scale_type = GL_NEAREST, uint32_t extention_type = GL_CLAMP, uint32_t format = GL_RGBA );
     void from_FBO( FBO &fbo, uint32_t slot, uint32_t scale_type = GL_NEAREST );
     void allocate();
+
+    // Allocates storage without data, regions are then written with upload_region
+    void allocate_empty( uint32_t width, uint32_t height, uint32_t format = GL_RGBA, uint32_t scale_type = GL_NEAREST );
+    void upload_region( uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t format, const void *data );
     bool is_allocated();
     void free();
     inline uint32_t get_width(){return width;}
@@ -54,7 +58,6 @@ class TextureArray{
         void free();
         void bind(uint32_t texture_slot);
         void load_atlas(std::string filename, uint8_t tile_count, uint32_t scale_type = GL_NEAREST, uint32_t extention_type = GL_CLAMP, uint32_t format = GL_RGBA);
-        void load_file_list(std::vector<std::string> filenames,  uint32_t scale_type = GL_NEAREST, uint32_t extention_type = GL_CLAMP, uint32_t format = GL_RGBA);
         inline float get_ratio(){return (float)height/width;}
 
 };
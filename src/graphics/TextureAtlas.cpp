@@ -0,0 +1,391 @@
+#include "TextureAtlas.h"
+#include "TextureCompression.h"
+#include "ImageDecode.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+// Padded images are cached apart from other transcodes of the image, bump the version when the tile layout changes
+static const std::string TILE_SUFFIX = ".atlas1";
+
+// Size of an image with its padding, rounded up to whole blocks of the smallest level
+static uint32_t tile_extent( uint32_t image_extent ){
+    uint32_t padded = image_extent + 2 * TextureAtlas::PADDING;
+    return ( padded + TextureAtlas::TILE_ALIGN - 1 ) / TextureAtlas::TILE_ALIGN * TextureAtlas::TILE_ALIGN;
+}
+
+// Whole atlases were once cached by their set of images, those files are no longer read
+static void remove_set_caches(){
+    std::error_code ec;
+
+    for( const std::filesystem::directory_entry &file : std::filesystem::directory_iterator( DIR_TEXTURE_CACHE, ec ) ){
+        std::string name = file.path().filename().string();
+
+        if( name.rfind( "atlas_", 0 ) == 0 && file.path().extension() == ".vna" )
+            std::filesystem::remove( file.path(), ec );
+    }
+}
+
+TextureAtlas::~TextureAtlas(){
+    free();
+}
+
+// Add an image by name, the atlas must be built before a new image can be used
+uint32_t TextureAtlas::add( const std::string &name ){
+    auto found = entry_map.find( name );
+
+    if( found != entry_map.end() )
+        return found->second;
+
+    uint32_t id = entries.size();
+    entries.push_back( AtlasEntry() );
+    entries.back().name = name;
+    entry_map[name] = id;
+    changed = true;
+    return id;
+}
+
+const AtlasEntry &TextureAtlas::get_entry( uint32_t id ){
+    return entries[id < entries.size() ? id : 0];
+}
+
+void TextureAtlas::bind( uint32_t texture_slot ){
+    if( texture_id ){
+        glActiveTexture( GL_TEXTURE0 + texture_slot );
+        glBindTexture( GL_TEXTURE_2D_ARRAY, texture_id );
+    }
+}
+
+// Every image is placed again by the next build
+void TextureAtlas::free(){
+    if( texture_id ){
+        glDeleteTextures( 1, &texture_id );
+        texture_id = 0;
+    }
+
+    skylines.clear();
+    size = layers = texture_size = texture_layers = 0;
+    memory_size = 0;
+    placed = 0;
+    changed = !entries.empty();
+}
+
+// Find the lowest position a rectangle fits on the skyline of a layer, ties go to the leftmost
+bool TextureAtlas::skyline_find( uint32_t layer, uint32_t w, uint32_t h, uint32_t &best_x, uint32_t &best_y, uint32_t &best_index ){
+    const std::vector<SkylineNode> &nodes = skylines[layer];
+    uint32_t best_bottom = UINT32_MAX;
+
+    for( uint32_t i = 0; i < nodes.size(); ++i ){
+        uint32_t x = nodes[i].x;
+
+        if( x + w > size )
+            break;
+
+        // The rectangle rests on the highest node it spans
+        uint32_t y = 0, remaining = w;
+
+        for( uint32_t j = i; j < nodes.size() && remaining > 0; ++j ){
+            y = nodes[j].y > y ? nodes[j].y : y;
+            remaining = nodes[j].width >= remaining ? 0 : remaining - nodes[j].width;
+        }
+
+        if( y + h > size )
+            continue;
+
+        if( y + h < best_bottom ){
+            best_bottom = y + h;
+            best_x = x;
+            best_y = y;
+            best_index = i;
+        }
+    }
+
+    return best_bottom != UINT32_MAX;
+}
+
+// Raise the skyline under a placed rectangle
+void TextureAtlas::skyline_add( uint32_t layer, uint32_t index, uint32_t x, uint32_t y, uint32_t w, uint32_t h ){
+    std::vector<SkylineNode> &nodes = skylines[layer];
+    nodes.insert( nodes.begin() + index, {x, y + h, w} );
+
+    // Remove or shrink the nodes now covered
+    for( uint32_t i = index + 1; i < nodes.size(); ){
+        if( nodes[i].x >= x + w )
+            break;
+
+        if( nodes[i].x + nodes[i].width <= x + w ){
+            nodes.erase( nodes.begin() + i );
+            continue;
+        }
+
+        uint32_t shrink = x + w - nodes[i].x;
+        nodes[i].x += shrink;
+        nodes[i].width -= shrink;
+        break;
+    }
+
+    // Merge neighbors at the same height
+    for( uint32_t i = 0; i + 1 < nodes.size(); ){
+        if( nodes[i].y == nodes[i + 1].y ){
+            nodes[i].width += nodes[i + 1].width;
+            nodes.erase( nodes.begin() + i + 1 );
+        }
+        else
+            ++i;
+    }
+}
+
+// Layers grow to the right and up, placed images keep their positions and the new space is free in every layer
+void TextureAtlas::grow( uint32_t new_size ){
+    for( std::vector<SkylineNode> &nodes : skylines ){
+        if( nodes.back().y == 0 )
+            nodes.back().width += new_size - size;
+        else
+            nodes.push_back( {size, 0, new_size - size} );
+    }
+
+    size = new_size;
+}
+
+/*
+ * Place an image at the lowest position of the first layer with room.
+ * When no layer has room the layers double in size up to ATLAS_LAYER_SIZE, after that a layer is added.
+ * An image larger than ATLAS_LAYER_SIZE grows the layers to its size and is given a new layer,
+ * every layer shares the size so the layers already placed grow with it.
+ */
+void TextureAtlas::place( AtlasEntry &e ){
+    uint32_t w = tile_extent( e.width ), h = tile_extent( e.height );
+    uint32_t x = 0, y = 0, index = 0;
+
+    while( true ){
+        for( uint32_t layer = 0; layer < skylines.size(); ++layer ){
+            if( skyline_find( layer, w, h, x, y, index ) ){
+                skyline_add( layer, index, x, y, w, h );
+                e.x = x + PADDING;
+                e.y = y + PADDING;
+                e.layer = layer;
+                return;
+            }
+        }
+
+        if( !skylines.empty() && size < ATLAS_LAYER_SIZE )
+            grow( std::min( size * 2, (uint32_t)ATLAS_LAYER_SIZE ) );
+        else if( std::max( w, h ) > size )
+            grow( std::max( std::max( w, h ), (uint32_t)MIN_SIZE ) );
+        else
+            skylines.push_back( { {0, 0, size} } );
+    }
+}
+
+/*
+ * Make the texture as large as the packing.
+ * The texture is replaced when the layers grow or a layer is added, the images already in it are copied on the GPU.
+ */
+void TextureAtlas::allocate( bool compressed ){
+    if( texture_id && texture_size == size && texture_layers == layers )
+        return;
+
+    GLuint new_id = 0;
+    glGenTextures( 1, &new_id );
+    glBindTexture( GL_TEXTURE_2D_ARRAY, new_id );
+    glTexStorage3D( GL_TEXTURE_2D_ARRAY, levels, compressed ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_RGBA8, size, size, layers );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1 );
+
+    if( texture_id ){
+        for( uint32_t level = 0; level < levels; ++level ){
+            glCopyImageSubData( texture_id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, new_id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                                texture_size >> level, texture_size >> level, texture_layers );
+        }
+
+        glDeleteTextures( 1, &texture_id );
+    }
+
+    texture_id = new_id;
+    texture_size = size;
+    texture_layers = layers;
+    memory_size = 0;
+
+    // BC3 is a byte per pixel
+    for( uint32_t level = 0; level < levels; ++level ){
+        uint64_t s = size >> level;
+        memory_size += s * s * layers * ( compressed ? 1 : 4 );
+    }
+}
+
+/*
+ * Decode an image into its tile with every level, the padding repeats the edge pixels to the end of the tile.
+ * Compressed tiles are read from the texture cache when it is newer than the image, otherwise they are cached.
+ */
+void TextureAtlas::load_tile( AtlasEntry &e, std::vector<std::vector<uint8_t>> &tile_levels, bool compressed ){
+    uint32_t w = tile_extent( e.width ), h = tile_extent( e.height );
+    TextureCompression::CompressedImage tile;
+
+    if( compressed && TextureCompression::read_cache( e.name, tile, TILE_SUFFIX ) && tile.width == w && tile.height == h && tile.levels.size() == levels ){
+        tile_levels.swap( tile.levels );
+        return;
+    }
+
+    std::string path = (std::string)DIR_TEXTURES + e.name + ".png";
+    std::vector<uint8_t> data( (uint64_t)e.width * e.height * 4 );
+
+    if( !ImageDecode::decode_png( path, e.width, e.height, data.data(), false, false ) ){
+        printf( "Failed to load image for atlas: %s\n", e.name.c_str() );
+        fflush( stdout );
+        e.loaded = false;
+        return;
+    }
+
+    std::vector<uint8_t> pixels( (uint64_t)w * h * 4 );
+
+    for( uint32_t py = 0; py < h; ++py ){
+        int32_t sy = std::clamp( (int32_t)py - (int32_t)PADDING, 0, (int32_t)e.height - 1 );
+        const uint8_t *src = data.data() + (uint64_t)sy * e.width * 4;
+        uint8_t *row = pixels.data() + (uint64_t)py * w * 4;
+
+        for( uint32_t px = 0; px < PADDING; ++px )
+            memcpy( row + px * 4, src, 4 );
+
+        memcpy( row + PADDING * 4, src, e.width * 4 );
+
+        for( uint32_t px = PADDING + e.width; px < w; ++px )
+            memcpy( row + px * 4, src + ( e.width - 1 ) * 4, 4 );
+    }
+
+    if( compressed ){
+        TextureCompression::compress_mips( pixels.data(), w, h, tile, levels );
+        TextureCompression::write_cache( e.name, tile, TILE_SUFFIX );
+        tile_levels.swap( tile.levels );
+    }
+    else{
+        // Levels are made per tile as well, so adding an image does not regenerate the mips of the whole texture
+        tile_levels.resize( levels );
+        tile_levels[0].swap( pixels );
+
+        for( uint32_t level = 1; level < levels; ++level )
+            TextureCompression::downsample( tile_levels[level - 1].data(), w >> ( level - 1 ), h >> ( level - 1 ), tile_levels[level] );
+    }
+}
+
+// Upload every level of a tile, tiles are aligned so each level starts and ends on a block
+void TextureAtlas::upload_tile( const AtlasEntry &e, const std::vector<std::vector<uint8_t>> &tile_levels, bool compressed ){
+    uint32_t x = e.x - PADDING, y = e.y - PADDING;
+    uint32_t w = tile_extent( e.width ), h = tile_extent( e.height );
+    glBindTexture( GL_TEXTURE_2D_ARRAY, texture_id );
+
+    for( uint32_t level = 0; level < tile_levels.size(); ++level ){
+        if( compressed ){
+            glCompressedTexSubImage3D( GL_TEXTURE_2D_ARRAY, level, x >> level, y >> level, e.layer, w >> level, h >> level, 1,
+                                       GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, tile_levels[level].size(), tile_levels[level].data() );
+        }
+        else{
+            glTexSubImage3D( GL_TEXTURE_2D_ARRAY, level, x >> level, y >> level, e.layer, w >> level, h >> level, 1,
+                             GL_RGBA, GL_UNSIGNED_BYTE, tile_levels[level].data() );
+        }
+    }
+}
+
+/*
+ * Place and upload the images added since the last build, images already in the atlas are not decoded or uploaded again.
+ * Images keep their ids and locations, their normalized rects change when the layers grow.
+ */
+void TextureAtlas::build(){
+    changed = false;
+
+    if( placed == entries.size() )
+        return;
+
+    if( placed == 0 )
+        remove_set_caches();
+
+    auto start_time = std::chrono::steady_clock::now();
+    bool compressed = TEXTURE_COMPRESSION;
+    uint32_t first = placed;
+    levels = MAX_LEVELS;
+
+    // Sizes are read from the headers of the new images
+    std::vector<std::string> paths;
+    std::vector<ImageDecode::ImageInfo> infos;
+
+    for( uint32_t i = first; i < entries.size(); ++i )
+        paths.push_back( (std::string)DIR_TEXTURES + entries[i].name + ".png" );
+
+    ImageDecode::read_infos( paths, infos );
+
+    std::vector<uint32_t> order;
+    GLint max_size = 0;
+    glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+
+    for( uint32_t i = first; i < entries.size(); ++i ){
+        AtlasEntry &e = entries[i];
+        const ImageDecode::ImageInfo &info = infos[i - first];
+        e.loaded = false;
+
+        if( !info.valid ){
+            printf( "Failed to load image for atlas: %s\n", e.name.c_str() );
+            fflush( stdout );
+            continue;
+        }
+
+        // Larger images than a layer grow the layers to fit, up to what the GPU allows
+        if( tile_extent( info.width ) > (uint32_t)max_size || tile_extent( info.height ) > (uint32_t)max_size ){
+            printf( "Image is larger than the maximum texture size %d: %s\n", max_size, e.name.c_str() );
+            fflush( stdout );
+            continue;
+        }
+
+        e.width = info.width;
+        e.height = info.height;
+        e.loaded = true;
+        order.push_back( i );
+    }
+
+    placed = entries.size();
+
+    if( order.empty() )
+        return;
+
+    // Tallest first packs the new images tighter
+    std::stable_sort( order.begin(), order.end(), [this]( uint32_t a, uint32_t b ){
+        return entries[a].height != entries[b].height ? entries[a].height > entries[b].height : entries[a].width > entries[b].width;
+    });
+
+    for( uint32_t i : order )
+        place( entries[i] );
+
+    layers = skylines.size();
+    allocate( compressed );
+
+    // Tiles are decoded or read from the cache across threads, then uploaded on this thread
+    std::vector<std::vector<std::vector<uint8_t>>> tiles( order.size() );
+
+    ThreadPool::parallel_for( order.size(), 0, [&]( uint32_t i ){
+        load_tile( entries[order[i]], tiles[i], compressed );
+    } );
+
+    for( uint32_t i = 0; i < order.size(); ++i ){
+        if( entries[order[i]].loaded )
+            upload_tile( entries[order[i]], tiles[i], compressed );
+    }
+
+    // Normalized rects within the layer
+    for( AtlasEntry &e : entries ){
+        if( !e.loaded )
+            continue;
+
+        e.rect[0] = (float)e.x / size;
+        e.rect[1] = (float)e.y / size;
+        e.rect[2] = (float)( e.x + e.width ) / size;
+        e.rect[3] = (float)( e.y + e.height ) / size;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    printf( "Added %u images to the atlas of %u images in %u layers (%ux%u) in %.1f ms, %.2f MB\n",
+            (uint32_t)order.size(), (uint32_t)entries.size(), layers, size, size, elapsed.count() * 1000, memory_size / ( 1024.0 * 1024.0 ) );
+    fflush( stdout );
+}
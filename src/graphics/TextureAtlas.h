@@ -0,0 +1,85 @@
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cglm/cglm.h>
+#include "library/glad_common.h"
+
+// Location of an image within the atlas, the rect is u0 v0 u1 v1
+struct AtlasEntry {
+    std::string name;
+    uint32_t width = 0, height = 0;
+    uint32_t x = 0, y = 0, layer = 0;
+    vec4 rect = {0, 0, 1, 1};
+    bool loaded = false;
+};
+
+/*
+ * Packs images of any size into the layers of a single texture array.
+ * Images are added by name and placed when the atlas is built, only images added since the last build are placed and uploaded.
+ * New images go in the free space of the existing layers, the layers only grow or are added when an image does not fit.
+ * Images larger than ATLAS_LAYER_SIZE grow every layer to their size, as a texture array of them would.
+ * Images are padded with their edge pixels so filtering and the first mip levels do not bleed.
+ * Padded images are cached on disk one at a time as atlas tiles.
+ */
+class TextureAtlas {
+    // A segment of the top edge of the packed images in a layer
+    struct SkylineNode {
+        uint32_t x, y, width;
+    };
+
+    GLuint texture_id = 0;
+    uint32_t size = 0, layers = 0, levels = 0;
+    uint64_t memory_size = 0;
+    bool changed = false;
+
+    // Size and layers of the texture, the packing can be ahead of it until the next build
+    uint32_t texture_size = 0, texture_layers = 0;
+
+    std::vector<AtlasEntry> entries;
+    std::unordered_map<std::string, uint32_t> entry_map;
+    std::vector<std::vector<SkylineNode>> skylines;
+
+    // Entries before this have been placed
+    uint32_t placed = 0;
+
+    // Forbid Copy
+    TextureAtlas( TextureAtlas const& );
+    TextureAtlas& operator=( TextureAtlas const& );
+
+    bool skyline_find( uint32_t layer, uint32_t w, uint32_t h, uint32_t &x, uint32_t &y, uint32_t &index );
+    void skyline_add( uint32_t layer, uint32_t index, uint32_t x, uint32_t y, uint32_t w, uint32_t h );
+    void grow( uint32_t new_size );
+    void place( AtlasEntry &e );
+    void allocate( bool compressed );
+    void load_tile( AtlasEntry &e, std::vector<std::vector<uint8_t>> &tile_levels, bool compressed );
+    void upload_tile( const AtlasEntry &e, const std::vector<std::vector<uint8_t>> &tile_levels, bool compressed );
+
+    public:
+        static const uint32_t PADDING = 8;
+
+        // Levels are limited so the padding covers at least a pixel on the smallest level
+        static const uint32_t MAX_LEVELS = 4;
+
+        // Tiles start and end on a 4x4 block of the smallest level, so each level of a tile is uploaded on its own
+        static const uint32_t TILE_ALIGN = 4 << ( MAX_LEVELS - 1 );
+
+        // Size layers start at, they double up to ATLAS_LAYER_SIZE before another layer is added
+        static const uint32_t MIN_SIZE = 256;
+
+        TextureAtlas(){}
+        ~TextureAtlas();
+
+        uint32_t add( const std::string &name );
+        const AtlasEntry &get_entry( uint32_t id );
+        void build();
+        void bind( uint32_t texture_slot );
+        void free();
+        inline bool is_changed(){return changed;}
+        inline bool is_allocated(){return texture_id != 0;}
+        inline uint64_t get_memory_size(){return memory_size;}
+};
+
+#endif // TEXTUREATLAS_H
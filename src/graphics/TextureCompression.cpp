@@ -0,0 +1,377 @@
+#include "TextureCompression.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+
+namespace TextureCompression {
+
+    // Cache header, bump the version when the encoder output changes
+    static const char CACHE_MAGIC[4] = {'V', 'N', 'T', 'C'};
+    static const uint32_t CACHE_VERSION = 1;
+
+    uint32_t CompressedImage::get_level_width( uint32_t level ) const {
+        return width >> level ? width >> level : 1;
+    }
+
+    uint32_t CompressedImage::get_level_height( uint32_t level ) const {
+        return height >> level ? height >> level : 1;
+    }
+
+    uint64_t CompressedImage::get_size() const {
+        uint64_t size = 0;
+
+        for( const std::vector<uint8_t> &level : levels ) {
+            size += level.size();
+        }
+
+        return size;
+    }
+
+    // Number of levels down to 1x1
+    uint32_t mip_count( uint32_t width, uint32_t height ) {
+        uint32_t count = 1;
+
+        while( width > 1 || height > 1 ) {
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            ++count;
+        }
+
+        return count;
+    }
+
+    // Size in bytes, 16 bytes per 4x4 block
+    uint32_t bc3_size( uint32_t width, uint32_t height ) {
+        return ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * 16;
+    }
+
+    /*
+     * Halve an image with a box filter, odd edges reuse the last pixel.
+     * Color is weighted by alpha so transparent pixels do not darken edges.
+     */
+    void downsample( const uint8_t *rgba, uint32_t width, uint32_t height, std::vector<uint8_t> &dest ) {
+        uint32_t w = width > 1 ? width / 2 : 1;
+        uint32_t h = height > 1 ? height / 2 : 1;
+        dest.resize( w * h * 4 );
+
+        for( uint32_t y = 0; y < h; ++y ) {
+            uint32_t y0 = y * 2, y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+
+            for( uint32_t x = 0; x < w; ++x ) {
+                uint32_t x0 = x * 2, x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+                const uint8_t *p[4] = {
+                    rgba + ( y0 * width + x0 ) * 4,
+                    rgba + ( y0 * width + x1 ) * 4,
+                    rgba + ( y1 * width + x0 ) * 4,
+                    rgba + ( y1 * width + x1 ) * 4
+                };
+
+                uint32_t alpha = p[0][3] + p[1][3] + p[2][3] + p[3][3];
+                uint8_t *d = dest.data() + ( y * w + x ) * 4;
+
+                for( uint8_t c = 0; c < 3; ++c ) {
+                    if( alpha == 0 )
+                        d[c] = ( p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2 ) / 4;
+                    else
+                        d[c] = ( p[0][c] * p[0][3] + p[1][c] * p[1][3] + p[2][c] * p[2][3] + p[3][c] * p[3][3] + alpha / 2 ) / alpha;
+                }
+
+                d[3] = ( alpha + 2 ) / 4;
+            }
+        }
+    }
+
+    static uint16_t to_565( const uint8_t *c ) {
+        return ( ( c[0] * 31 + 127 ) / 255 ) << 11 | ( ( c[1] * 63 + 127 ) / 255 ) << 5 | ( ( c[2] * 31 + 127 ) / 255 );
+    }
+
+    static void from_565( uint16_t v, int32_t *c ) {
+        c[0] = ( v >> 11 ) & 31;
+        c[1] = ( v >> 5 ) & 63;
+        c[2] = v & 31;
+        c[0] = ( c[0] << 3 ) | ( c[0] >> 2 );
+        c[1] = ( c[1] << 2 ) | ( c[1] >> 4 );
+        c[2] = ( c[2] << 3 ) | ( c[2] >> 2 );
+    }
+
+    /*
+     * Encode the alpha half of a block.
+     * Both the 8 value mode and the 6 value mode with explicit 0 and 255 are tried, the one with less error is kept.
+     */
+    static void encode_alpha_block( const uint8_t *alpha, uint8_t *dest ) {
+        uint8_t min = 255, max = 0, min_inner = 255, max_inner = 0;
+
+        for( uint8_t i = 0; i < 16; ++i ) {
+            min = alpha[i] < min ? alpha[i] : min;
+            max = alpha[i] > max ? alpha[i] : max;
+
+            if( alpha[i] != 0 && alpha[i] != 255 ) {
+                min_inner = alpha[i] < min_inner ? alpha[i] : min_inner;
+                max_inner = alpha[i] > max_inner ? alpha[i] : max_inner;
+            }
+        }
+
+        if( min_inner > max_inner )
+            min_inner = max_inner = 0;
+
+        uint8_t endpoints[2][2] = { { max, min }, { min_inner, max_inner } };
+        uint64_t best_bits = 0;
+        uint32_t best_error = UINT32_MAX;
+        uint8_t best = 0;
+
+        for( uint8_t mode = 0; mode < 2; ++mode ) {
+            int32_t a0 = endpoints[mode][0], a1 = endpoints[mode][1];
+            int32_t palette[8];
+            palette[0] = a0;
+            palette[1] = a1;
+
+            if( mode == 0 ) {
+                for( uint8_t i = 1; i < 7; ++i ) {
+                    palette[i + 1] = ( ( 7 - i ) * a0 + i * a1 ) / 7;
+                }
+            }
+            else {
+                for( uint8_t i = 1; i < 5; ++i ) {
+                    palette[i + 1] = ( ( 5 - i ) * a0 + i * a1 ) / 5;
+                }
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+
+            uint64_t bits = 0;
+            uint32_t error = 0;
+
+            for( uint8_t i = 0; i < 16; ++i ) {
+                uint32_t index = 0, index_error = UINT32_MAX;
+
+                for( uint8_t p = 0; p < 8; ++p ) {
+                    uint32_t e = ( alpha[i] - palette[p] ) * ( alpha[i] - palette[p] );
+
+                    if( e < index_error ) {
+                        index_error = e;
+                        index = p;
+                    }
+                }
+
+                error += index_error;
+                bits |= (uint64_t)index << ( i * 3 );
+            }
+
+            if( error < best_error ) {
+                best_error = error;
+                best_bits = bits;
+                best = mode;
+            }
+        }
+
+        dest[0] = endpoints[best][0];
+        dest[1] = endpoints[best][1];
+
+        for( uint8_t i = 0; i < 6; ++i ) {
+            dest[2 + i] = ( best_bits >> ( i * 8 ) ) & 0xFF;
+        }
+    }
+
+    /*
+     * Encode the color half of a block.
+     * Endpoints are the inset corners of the bounding box of visible pixels, indices pick the nearest palette color.
+     * The first endpoint is always greater so the block uses the 4 color mode.
+     */
+    static void encode_color_block( const uint8_t *rgba, uint8_t *dest ) {
+        int32_t min[3] = {255, 255, 255}, max[3] = {0, 0, 0};
+        bool visible = false;
+
+        for( uint8_t i = 0; i < 16; ++i ) {
+            if( rgba[i * 4 + 3] == 0 )
+                continue;
+
+            visible = true;
+
+            for( uint8_t c = 0; c < 3; ++c ) {
+                min[c] = rgba[i * 4 + c] < min[c] ? rgba[i * 4 + c] : min[c];
+                max[c] = rgba[i * 4 + c] > max[c] ? rgba[i * 4 + c] : max[c];
+            }
+        }
+
+        memset( dest, 0, 8 );
+
+        if( !visible )
+            return;
+
+        // Inset the box to reduce the error from rounding the endpoints
+        uint8_t e0[3], e1[3];
+
+        for( uint8_t c = 0; c < 3; ++c ) {
+            int32_t inset = ( max[c] - min[c] ) / 16;
+            e0[c] = max[c] - inset;
+            e1[c] = min[c] + inset;
+        }
+
+        uint16_t c0 = to_565( e0 ), c1 = to_565( e1 );
+
+        if( c0 < c1 )
+            std::swap( c0, c1 );
+
+        dest[0] = c0 & 0xFF;
+        dest[1] = c0 >> 8;
+        dest[2] = c1 & 0xFF;
+        dest[3] = c1 >> 8;
+
+        // A single color block uses index 0 everywhere
+        if( c0 == c1 )
+            return;
+
+        int32_t palette[4][3];
+        from_565( c0, palette[0] );
+        from_565( c1, palette[1] );
+
+        for( uint8_t c = 0; c < 3; ++c ) {
+            palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+            palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+        }
+
+        uint32_t bits = 0;
+
+        for( uint8_t i = 0; i < 16; ++i ) {
+            uint32_t index = 0, index_error = UINT32_MAX;
+
+            for( uint8_t p = 0; p < 4; ++p ) {
+                int32_t dr = rgba[i * 4] - palette[p][0];
+                int32_t dg = rgba[i * 4 + 1] - palette[p][1];
+                int32_t db = rgba[i * 4 + 2] - palette[p][2];
+                uint32_t e = dr * dr + dg * dg + db * db;
+
+                if( e < index_error ) {
+                    index_error = e;
+                    index = p;
+                }
+            }
+
+            bits |= index << ( i * 2 );
+        }
+
+        dest[4] = bits & 0xFF;
+        dest[5] = ( bits >> 8 ) & 0xFF;
+        dest[6] = ( bits >> 16 ) & 0xFF;
+        dest[7] = bits >> 24;
+    }
+
+    // Compress an RGBA8 image, partial edge blocks repeat the last row and column
+    void compress_bc3( const uint8_t *rgba, uint32_t width, uint32_t height, std::vector<uint8_t> &dest ) {
+        uint32_t blocks_x = ( width + 3 ) / 4, blocks_y = ( height + 3 ) / 4;
+        dest.resize( blocks_x * blocks_y * 16 );
+
+        uint8_t block[64];
+        uint8_t alpha[16];
+
+        for( uint32_t by = 0; by < blocks_y; ++by ) {
+            for( uint32_t bx = 0; bx < blocks_x; ++bx ) {
+
+                for( uint8_t i = 0; i < 16; ++i ) {
+                    uint32_t x = bx * 4 + ( i & 3 ), y = by * 4 + ( i >> 2 );
+                    x = x < width ? x : width - 1;
+                    y = y < height ? y : height - 1;
+                    memcpy( block + i * 4, rgba + ( y * width + x ) * 4, 4 );
+                    alpha[i] = block[i * 4 + 3];
+                }
+
+                uint8_t *d = dest.data() + ( by * blocks_x + bx ) * 16;
+                encode_alpha_block( alpha, d );
+                encode_color_block( block, d + 8 );
+            }
+        }
+    }
+
+    // Compress every level of the mip chain, up to the max levels
+    void compress_mips( const uint8_t *rgba, uint32_t width, uint32_t height, CompressedImage &dest, uint32_t max_levels ) {
+        uint32_t count = mip_count( width, height );
+        dest.width = width;
+        dest.height = height;
+        dest.levels.resize( count < max_levels ? count : max_levels );
+
+        std::vector<uint8_t> current, next;
+        const uint8_t *src = rgba;
+
+        for( uint32_t level = 0; level < dest.levels.size(); ++level ) {
+            compress_bc3( src, width, height, dest.levels[level] );
+
+            if( level + 1 == dest.levels.size() )
+                break;
+
+            downsample( src, width, height, next );
+            current.swap( next );
+            src = current.data();
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+    }
+
+    static std::string cache_path( const std::string &filename, const std::string &suffix ) {
+        return (std::string)DIR_TEXTURE_CACHE + filename + suffix + ".bc3";
+    }
+
+    // Read a cached image, fails if the cache is missing, older than the source png, or from another version
+    bool read_cache( const std::string &filename, CompressedImage &dest, const std::string &suffix ) {
+        std::error_code ec;
+        std::string path = cache_path( filename, suffix );
+        std::string source = (std::string)DIR_TEXTURES + filename + ".png";
+
+        auto cache_time = std::filesystem::last_write_time( path, ec );
+        if( ec )
+            return false;
+
+        auto source_time = std::filesystem::last_write_time( source, ec );
+        if( !ec && source_time > cache_time )
+            return false;
+
+        std::ifstream file( path, std::ios::in | std::ios::binary );
+
+        if( !file.is_open() )
+            return false;
+
+        char magic[4];
+        uint32_t version = 0, level_count = 0;
+        file.read( magic, 4 );
+        file.read( (char *)&version, 4 );
+        file.read( (char *)&dest.width, 4 );
+        file.read( (char *)&dest.height, 4 );
+        file.read( (char *)&level_count, 4 );
+
+        if( !file || memcmp( magic, CACHE_MAGIC, 4 ) != 0 || version != CACHE_VERSION || level_count == 0 || level_count > mip_count( dest.width, dest.height ) )
+            return false;
+
+        dest.levels.resize( level_count );
+
+        for( uint32_t level = 0; level < level_count; ++level ) {
+            dest.levels[level].resize( bc3_size( dest.get_level_width( level ), dest.get_level_height( level ) ) );
+            file.read( (char *)dest.levels[level].data(), dest.levels[level].size() );
+        }
+
+        return (bool)file;
+    }
+
+    void write_cache( const std::string &filename, const CompressedImage &src, const std::string &suffix ) {
+        std::error_code ec;
+        std::string path = cache_path( filename, suffix );
+        std::filesystem::create_directories( std::filesystem::path( path ).parent_path(), ec );
+
+        std::ofstream file( path, std::ios::out | std::ios::binary | std::ios::trunc );
+
+        if( !file.is_open() ) {
+            printf( "Unable to write texture cache %s\n", path.c_str() );
+            fflush( stdout );
+            return;
+        }
+
+        uint32_t level_count = src.levels.size();
+        file.write( CACHE_MAGIC, 4 );
+        file.write( (const char *)&CACHE_VERSION, 4 );
+        file.write( (const char *)&src.width, 4 );
+        file.write( (const char *)&src.height, 4 );
+        file.write( (const char *)&level_count, 4 );
+
+        for( const std::vector<uint8_t> &level : src.levels ) {
+            file.write( (const char *)level.data(), level.size() );
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef TEXTURECOMPRESSION_H
+#define TEXTURECOMPRESSION_H
+
+#include <string>
+#include <vector>
+#include <inttypes.h>
+#include "definitions.h"
+
+/*
+ * CPU transcoding of RGBA8 images to BC3 (DXT5) with a full mip chain.
+ * Transcoded images are cached on disk and reused while the cache is newer than the source.
+ */
+namespace TextureCompression {
+
+    // Each level of an image, level 0 is the full size
+    struct CompressedImage {
+        uint32_t width = 0, height = 0;
+        std::vector<std::vector<uint8_t>> levels;
+
+        uint32_t get_level_width( uint32_t level ) const;
+        uint32_t get_level_height( uint32_t level ) const;
+        uint64_t get_size() const;
+    };
+
+    uint32_t mip_count( uint32_t width, uint32_t height );
+    uint32_t bc3_size( uint32_t width, uint32_t height );
+    void downsample( const uint8_t *rgba, uint32_t width, uint32_t height, std::vector<uint8_t> &dest );
+    void compress_bc3( const uint8_t *rgba, uint32_t width, uint32_t height, std::vector<uint8_t> &dest );
+    void compress_mips( const uint8_t *rgba, uint32_t width, uint32_t height, CompressedImage &dest, uint32_t max_levels = UINT32_MAX );
+
+    // The suffix keeps other transcodes of the same image apart, such as padded atlas tiles
+    bool read_cache( const std::string &filename, CompressedImage &dest, const std::string &suffix = "" );
+    void write_cache( const std::string &filename, const CompressedImage &src, const std::string &suffix = "" );
+};
+
+#endif // TEXTURECOMPRESSION_H
@@ -0,0 +1,123 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ThreadPool {
+
+    struct Pool {
+        std::vector<std::thread> workers;
+
+        // Guards the job and wakes the workers for it
+        std::mutex mutex;
+        std::condition_variable wake, done;
+
+        // The current job, only workers numbered below wanted take part
+        const std::function<void( uint32_t )> *fn = nullptr;
+        std::atomic<uint32_t> next = 0;
+        uint32_t count = 0, wanted = 0, busy = 0;
+        uint64_t generation = 0;
+        bool stopping = false;
+
+        // Only one job runs at a time
+        std::mutex job_mutex;
+
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                stopping = true;
+            }
+            wake.notify_all();
+
+            for( std::thread &t : workers )
+                t.join();
+        }
+    };
+
+    // Set on workers and on a thread while it runs a job, nested calls would wait on themselves
+    static thread_local bool in_job = false;
+
+    static Pool &pool() {
+        static Pool p;
+        return p;
+    }
+
+    static void run_job( Pool &p ) {
+        for( uint32_t i = p.next++; i < p.count; i = p.next++ )
+            ( *p.fn )( i );
+    }
+
+    static void work( Pool &p, uint32_t id ) {
+        in_job = true;
+        uint64_t seen = 0;
+
+        std::unique_lock<std::mutex> lock( p.mutex );
+        while( true ) {
+            p.wake.wait( lock, [&]() {return p.stopping || p.generation != seen;} );
+            if( p.stopping )
+                return;
+
+            seen = p.generation;
+            if( id >= p.wanted )
+                continue;
+
+            lock.unlock();
+            run_job( p );
+            lock.lock();
+
+            if( --p.busy == 0 )
+                p.done.notify_one();
+        }
+    }
+
+    uint32_t default_threads() {
+        uint32_t count = std::thread::hardware_concurrency();
+        return count ? count : 1;
+    }
+
+    void parallel_for( uint32_t count, uint32_t thread_count, const std::function<void( uint32_t )> &fn ) {
+        if( thread_count == 0 )
+            thread_count = default_threads();
+
+        thread_count = std::min( thread_count, count );
+
+        // Not worth waking workers for a single item
+        if( thread_count <= 1 || in_job ) {
+            for( uint32_t i = 0; i < count; ++i )
+                fn( i );
+            return;
+        }
+
+        Pool &p = pool();
+        std::lock_guard<std::mutex> job( p.job_mutex );
+
+        {
+            std::lock_guard<std::mutex> lock( p.mutex );
+
+            // Workers are only added, later jobs wanting fewer leave the rest waiting
+            while( p.workers.size() < thread_count - 1 ) {
+                uint32_t id = p.workers.size();
+                p.workers.emplace_back( work, std::ref( p ), id );
+            }
+
+            p.fn = &fn;
+            p.count = count;
+            p.next = 0;
+            p.wanted = p.busy = thread_count - 1;
+            ++p.generation;
+        }
+        p.wake.notify_all();
+
+        // The calling thread works as well
+        in_job = true;
+        run_job( p );
+        in_job = false;
+
+        std::unique_lock<std::mutex> lock( p.mutex );
+        p.done.wait( lock, [&]() {return p.busy == 0;} );
+        p.fn = nullptr;
+    }
+};
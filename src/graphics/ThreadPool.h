@@ -0,0 +1,21 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <functional>
+#include <inttypes.h>
+
+/*
+ * Worker threads shared by image decoding and the softbody solver.
+ * Workers are started the first time they are needed and wait between jobs, so a call costs a wake up rather than starting threads.
+ * Calls made from within a job run on the calling thread.
+ */
+namespace ThreadPool {
+
+    // Threads used when the count is 0, the number of hardware threads
+    uint32_t default_threads();
+
+    // Run fn for every index in [0, count), indices are handed out to the threads in order
+    void parallel_for( uint32_t count, uint32_t thread_count, const std::function<void( uint32_t )> &fn );
+};
+
+#endif // THREADPOOL_H
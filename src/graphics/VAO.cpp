@@ -50,63 +50,113 @@ void VAO::free() {
                 vboSizes[i] = 0;
             }
         }
+        if( iboid != 0 ) {
+            glDeleteBuffers( 1, &iboid );
+            iboid = 0;
+            iboSize = 0;
+        }
+        if( interleavedid != 0 ) {
+            glDeleteBuffers( 1, &interleavedid );
+            interleavedid = 0;
+            interleavedSize = 0;
+            interleavedMask = 0;
+        }
+        indexCount = 0;
+        indexType = GL_UNSIGNED_INT;
         glDeleteVertexArrays( 1, &vaoid );
         vaoid = 0;
     }
 }
 
 /*
- * Load an attribute buffer into the VAO.
- * If the attribute does not have a buffer, create one.
- * If the data being buffered is too large, reallocate memory, otherwise overwrite the memory.
- * A new buffer will not be created if offset is not 0.
+ * Ensure a buffer can hold the required number of bytes.
+ * If the buffer does not exist, it is created at the exact size.
+ * If the buffer is too small, it grows to at least double its size so repeated appends do not reallocate every time.
+ * When preserving, the previous contents are copied into the new storage, otherwise they are discarded.
+ * The buffer is left bound to the target.
  */
-void VAO::load_attrb_float( int attrbid, int vertexOffset, int divisor, int vecSize, int size, void *data ) {
-    // Invalid attribute id
-    if( attrbid >= Attribute::NUM_ATTRBS || attrbid < 0 ) {
-        fprintf( stderr, "Invalid attribute ID.\n" );
+void VAO::reserve_buffer( GLenum target, GLuint &buffer, uint32_t &capacity, uint32_t required, bool preserve ) {
+
+    // Create the buffer if it has not been created
+    if( buffer == 0 ) {
+        glGenBuffers( 1, &buffer );
+        capacity = 0;
+    }
+
+    glBindBuffer( target, buffer );
+
+    if( capacity >= required )
+        return;
+
+    // First allocation uses the exact size
+    if( capacity == 0 ) {
+        glBufferData( target, required, nullptr, GL_DYNAMIC_DRAW );
+        capacity = required;
         return;
     }
 
-    if( vecSize > 4 || vecSize < 1 ) {
-        fprintf( stderr, "Attribute vector size must be 1 to 4.\n" );
+    uint32_t new_capacity = capacity * 2 > required ? capacity * 2 : required;
+
+    // Orphan the old storage if nothing needs kept
+    if( !preserve ) {
+        glBufferData( target, new_capacity, nullptr, GL_DYNAMIC_DRAW );
+        capacity = new_capacity;
         return;
     }
 
+    // Copy the old storage into a larger buffer, then replace the old buffer
+    GLuint grown = 0;
+    glGenBuffers( 1, &grown );
+    glBindBuffer( GL_COPY_WRITE_BUFFER, grown );
+    glBufferData( GL_COPY_WRITE_BUFFER, new_capacity, nullptr, GL_DYNAMIC_DRAW );
+    glBindBuffer( GL_COPY_READ_BUFFER, buffer );
+    glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity );
+    glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+    glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+    glDeleteBuffers( 1, &buffer );
+
+    buffer = grown;
+    capacity = new_capacity;
+    glBindBuffer( target, buffer );
+}
+
+// Write a range of bytes into an attribute buffer, growing the buffer if needed
+void VAO::write_attrb( int attrbid, int offset, int datasize, void *data ) {
+
     // Attempt to create the VAO
     allocate();
     glBindVertexArray( vaoid );
 
+    // Data before the offset must be kept when writing a partial range
+    reserve_buffer( GL_ARRAY_BUFFER, vboids[attrbid], vboSizes[attrbid], offset + datasize, offset > 0 );
 
-    // Create the buffer if it has not been created
-    if( vboids[attrbid] == 0 ) {
-        glGenBuffers( 1, &vboids[attrbid] );
+    if( datasize > 0 )
+        glBufferSubData( GL_ARRAY_BUFFER, offset, datasize, data );
+}
+
+/*
+ * Load an attribute buffer into the VAO.
+ * If the attribute does not have a buffer, create one.
+ * The data is written in place at the vertex offset, the buffer only grows when the written range exceeds its size.
+ * Size is the number of floats being written.
+ */
+void VAO::load_attrb_float( int attrbid, int vertexOffset, int divisor, int vecSize, int size, void *data ) {
+    // Invalid attribute id
+    if( attrbid >= Attribute::NUM_ATTRBS || attrbid < 0 ) {
+        fprintf( stderr, "Invalid attribute ID.\n" );
+        return;
     }
 
-    glBindBuffer( GL_ARRAY_BUFFER, vboids[attrbid] );
+    if( vecSize > 4 || vecSize < 1 ) {
+        fprintf( stderr, "Attribute vector size must be 1 to 4.\n" );
+        return;
+    }
 
-    // Compute the size of the offset in bytes
+    // Compute the size of the offset and data in bytes
     int offset = vertexOffset * sizeof(GLfloat) * vecSize;
-
-    // Compute data size
     int datasize = size * sizeof(GLfloat);
 
-    // If there is an offset, always use a rewrite
-    if( offset > 0 ) {
-        glBufferSubData( GL_ARRAY_BUFFER, offset,  datasize<(vboSizes[attrbid] - offset)?datasize:(vboSizes[attrbid] - offset), data );
-    }
-    else {
-        // Reallocate the buffer if it is too small
-        if( vboSizes[attrbid] < datasize ) {
-            glBufferData( GL_ARRAY_BUFFER, datasize, data, GL_DYNAMIC_DRAW );
-            // Update the buffer size
-            vboSizes[attrbid] = datasize;
-        }
-        else {
-            glBufferSubData( GL_ARRAY_BUFFER, 0, datasize, data );
-        }
-
-    }
+    write_attrb( attrbid, offset, datasize, data );
 
     // Set the attribute pointer
     glVertexAttribPointer( attrbid, vecSize, GL_FLOAT, GL_FALSE, 0, 0 );
@@ -118,6 +168,10 @@ void VAO::load_attrb_float( int attrbid, int vertexOffset, int divisor, int vecS
     glEnableVertexAttribArray( attrbid );
 }
 
+/*
+ * Same as load_attrb_float, size is the number of bytes being written.
+ * Bytes can be read as normalized floats or as integers.
+ */
 void VAO::load_attrb_byte( int attrbid, int vertexOffset, int divisor, int vecSize, int size,  bool convert_float, void *data ) {
 
     // Invalid attribute id
@@ -131,40 +185,11 @@ void VAO::load_attrb_byte( int attrbid, int vertexOffset, int divisor, int vecSi
         return;
     }
 
-    // Attempt to create the VAO
-    allocate();
-    glBindVertexArray( vaoid );
-
-
-    // Create the buffer if it has not been created
-    if( vboids[attrbid] == 0 ) {
-        glGenBuffers( 1, &vboids[attrbid] );
-    }
-
-    glBindBuffer( GL_ARRAY_BUFFER, vboids[attrbid] );
-
-    // Compute the size of the offset in bytes
+    // Compute the size of the offset and data in bytes
     int offset = vertexOffset * sizeof(GLbyte) * vecSize;
-
-    // Compute data size
     int datasize = size * sizeof(GLbyte);
 
-    // If there is an offset, always use a rewrite
-    if( offset > 0 ) {
-        glBufferSubData( GL_ARRAY_BUFFER, offset, datasize<(vboSizes[attrbid] - offset)?datasize:(vboSizes[attrbid] - offset), data );
-    }
-    else {
-        // Reallocate the buffer if it is too small
-        if( vboSizes[attrbid] < datasize ) {
-            glBufferData( GL_ARRAY_BUFFER, datasize, data, GL_DYNAMIC_DRAW );
-            // Update the buffer size
-            vboSizes[attrbid] = datasize;
-        }
-        else {
-            glBufferSubData( GL_ARRAY_BUFFER, 0, datasize, data );
-        }
-
-    }
+    write_attrb( attrbid, offset, datasize, data );
 
     // Set the attribute pointer
     if(convert_float)
@@ -179,25 +204,81 @@ void VAO::load_attrb_byte( int attrbid, int vertexOffset, int divisor, int vecSi
     glEnableVertexAttribArray( attrbid );
 }
 
+/*
+ * Load vertices into a single buffer holding every attribute of a vertex.
+ * Formats has an entry per attribute, attributes with a vector size of 0 are not part of the layout.
+ * Vertices are written in place at the vertex offset, vertices before the offset are kept.
+ * Do not mix with the separate attribute loads on the same VAO, free it when switching layouts.
+ */
+void VAO::load_interleaved( uint32_t vertexOffset, uint32_t vertexCount, uint32_t stride, const AttributeFormat *formats, void *data ) {
+    allocate();
+    glBindVertexArray( vaoid );
 
-void VAO::load_index( uint32_t numIndices, GLuint *data ) {
-    if( vaoid != 0 ) {
-        glBindVertexArray( vaoid );
-        if( iboid == 0 ) {
-            glGenBuffers( 1, &iboid );
+    uint32_t offset = vertexOffset * stride;
+    uint32_t datasize = vertexCount * stride;
+
+    reserve_buffer( GL_ARRAY_BUFFER, interleavedid, interleavedSize, offset + datasize, offset > 0 );
+
+    if( datasize > 0 )
+        glBufferSubData( GL_ARRAY_BUFFER, offset, datasize, data );
+
+    // Point each attribute into the vertex, the buffer may have been replaced on growth so always reset
+    interleavedMask = 0;
+
+    for( uint8_t i = 0; i < Attribute::NUM_ATTRBS; ++i ) {
+        const AttributeFormat &f = formats[i];
+
+        if( f.vec_size == 0 ) {
+            glDisableVertexAttribArray( i );
+            continue;
         }
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, iboid );
-        glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( GLuint )*numIndices, data, GL_STATIC_DRAW );
-        indexCount = numIndices;
+
+        if( f.integer )
+            glVertexAttribIPointer( i, f.vec_size, f.type, stride, (void *)(uintptr_t)f.offset );
+        else
+            glVertexAttribPointer( i, f.vec_size, f.type, f.normalized ? GL_TRUE : GL_FALSE, stride, (void *)(uintptr_t)f.offset );
+
+        glEnableVertexAttribArray( i );
+        interleavedMask |= 1 << i;
     }
 }
 
+/*
+ * Load indices starting at the index offset, indices before the offset are kept.
+ * The index count is set to the end of the written range.
+ * Indices may be 32 or 16 bit, changing the index type must rewrite from an offset of 0.
+ */
+void VAO::load_index( uint32_t numIndices, GLuint *data, uint32_t indexOffset ) {
+    indexType = GL_UNSIGNED_INT;
+    write_index( numIndices, sizeof( GLuint ), indexOffset, data );
+}
+
+void VAO::load_index( uint32_t numIndices, GLushort *data, uint32_t indexOffset ) {
+    indexType = GL_UNSIGNED_SHORT;
+    write_index( numIndices, sizeof( GLushort ), indexOffset, data );
+}
+
+void VAO::write_index( uint32_t numIndices, uint32_t indexSize, uint32_t indexOffset, void *data ) {
+    allocate();
+    glBindVertexArray( vaoid );
+
+    uint32_t offset = indexSize * indexOffset;
+    uint32_t datasize = indexSize * numIndices;
+
+    reserve_buffer( GL_ELEMENT_ARRAY_BUFFER, iboid, iboSize, offset + datasize, offset > 0 );
+
+    if( datasize > 0 )
+        glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, offset, datasize, data );
+
+    indexCount = indexOffset + numIndices;
+}
+
 void VAO::bind() {
     if( vaoid != 0 ) {
         glBindVertexArray( vaoid );
 
         for( uint8_t i = 0; i < Attribute::NUM_ATTRBS; i++ ) {
-            if( vboids[i] != 0 ) {
+            if( vboids[i] != 0 || interleavedMask & ( 1 << i ) ) {
                 glEnableVertexAttribArray( i );
             }
             else {
@@ -211,6 +292,14 @@ uint32_t VAO::get_index_count() {
     return indexCount;
 }
 
+GLenum VAO::get_index_type() {
+    return indexType;
+}
+
+bool VAO::is_interleaved() {
+    return interleavedid != 0;
+}
+
 void VAO::unbind() {
     glBindVertexArray( 0 );
 }
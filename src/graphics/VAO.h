@@ -5,12 +5,25 @@
 #include "Shader.h"
 #include <string>
 
+/*
+ * Location and type of an attribute within an interleaved vertex.
+ * Integer attributes are read as integers in the shader, otherwise normalized sets if integer types map to 0-1 or -1-1.
+ */
+struct AttributeFormat {
+    GLenum type = 0;
+    uint8_t vec_size = 0;
+    uint8_t offset = 0;
+    bool normalized = false;
+    bool integer = false;
+};
+
 class VAO {
 public:
     
     GLuint vaoid = 0;
     GLuint vboids[Attribute::NUM_ATTRBS];
     GLuint iboid = 0;
+    GLuint interleavedid = 0;
     
     VAO();
     virtual ~VAO();
@@ -21,9 +34,13 @@ public:
     void free();
     void load_attrb_float(int attrbid, int vertexOffset, int divisor, int vecSize, int size, void* data);
     void load_attrb_byte(int attrbid, int vertexOffset, int divisor, int vecSize, int size, bool convert_float, void* data);
-    void load_index(uint32_t numIndices, GLuint* data);
+    void load_interleaved(uint32_t vertexOffset, uint32_t vertexCount, uint32_t stride, const AttributeFormat* formats, void* data);
+    void load_index(uint32_t numIndices, GLuint* data, uint32_t indexOffset = 0);
+    void load_index(uint32_t numIndices, GLushort* data, uint32_t indexOffset = 0);
     void bind();
     uint32_t get_index_count();
+    GLenum get_index_type();
+    bool is_interleaved();
     void load_ply(std::string filename);
 
 
@@ -31,7 +48,19 @@ private:
     VAO(VAO const&);
     VAO& operator=(VAO const&);
     uint32_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // Allocated sizes of each buffer in bytes, these only grow (geometrically) and are reused when possible
+    uint32_t iboSize = 0;
+    uint32_t interleavedSize = 0;
+
+    // Attributes sourced from the interleaved buffer
+    uint8_t interleavedMask = 0;
     uint32_t vboSizes[Attribute::NUM_ATTRBS];
+
+    void reserve_buffer(GLenum target, GLuint &buffer, uint32_t &capacity, uint32_t required, bool preserve);
+    void write_attrb(int attrbid, int offset, int datasize, void* data);
+    void write_index(uint32_t numIndices, uint32_t indexSize, uint32_t indexOffset, void* data);
 };
 
 #endif /* VAO_H */
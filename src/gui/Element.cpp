@@ -42,7 +42,9 @@ void Element::event_reselect( float x, float y ) {};
 // When the element is selected and a key combo is pressed
 void Element::event_keypress( int32_t key_value, uint8_t modifiers_value ) {};
 
-void Element::event_char( char c ) {};
+void Element::event_char( uint32_t c ) {};
+
+void Element::event_scroll( float amount ) {};
 
 bool Element::is_active() {
     return flags & ACTIVE;
@@ -88,32 +90,106 @@ bool Element::contains_point( float sx, float sy, float &lx, float &ly ) {
 void Element::set_position( float x, float y ) {
     this->x = x;
     this->y = y;
+
+    if( owner )
+        owner->invalidate_layout();
 };
 
 void Element::set_size( float w, float h ) {
     this->w = w;
     this->h = h;
+
+    if( owner )
+        owner->invalidate_layout();
 }
 
 void Element::set_text( const std::string &s ) {
     reveal_amount = 0;
+    reveal_pause = 0;
     if( text )
         text->set_text( s );
 }
 
 void Element::set_text( const char *s, uint32_t count ) {
     reveal_amount = 0;
+    reveal_pause = 0;
     if( text )
         text->set_text( s, count );
 }
 
+// Text already shown stays revealed
 void Element::append_text(const std::string &s){
     if( text ){
-        reveal_amount = text->length();
+        reveal_amount = text->get_glyphs( GUI::font ).size();
+        reveal_pause = 0;
         text->append( s );
     }
 };
 
+// Pause after a glyph, sentences pause longer than clauses, full width punctuation pauses without a following space
+static float punctuation_pause( const std::vector<TextGlyph> &glyphs, uint32_t i ) {
+    if( i + 1 >= glyphs.size() )
+        return 0;
+
+    bool spaced = glyphs[i + 1].codepoint == ' ';
+
+    switch( glyphs[i].codepoint ) {
+        case '.': case '!': case '?':
+            return spaced ? GUI::reveal_sentence_pause : 0;
+        case ',': case ';': case ':':
+            return spaced ? GUI::reveal_clause_pause : 0;
+        case 0x3002: case 0xFF01: case 0xFF1F: case 0x2026:
+            return GUI::reveal_sentence_pause;
+        case 0x3001: case 0xFF0C: case 0xFF1B: case 0xFF1A:
+            return GUI::reveal_clause_pause;
+    }
+
+    return 0;
+}
+
+/*
+ * Reveals glyphs at the reveal rate for the time given, independent of how often it is called.
+ * Color codes and line breaks are not glyphs, so they take no time.
+ */
+void Element::update_reveal( float time ) {
+    if( !text || !( flags & REVEAL_TEXT ) )
+        return;
+
+    const std::vector<TextGlyph> &glyphs = text->get_glyphs( GUI::font );
+    float rate = reveal_rate > 0 ? reveal_rate : GUI::reveal_rate;
+
+    while( time > 0 && reveal_amount < glyphs.size() ) {
+        if( reveal_pause > 0 ) {
+            float t = fmin( time, reveal_pause );
+            reveal_pause -= t;
+            time -= t;
+            continue;
+        }
+
+        uint32_t current = reveal_amount;
+        float to_next = ( current + 1 - reveal_amount ) / rate;
+
+        if( time < to_next ) {
+            reveal_amount += time * rate;
+            break;
+        }
+
+        time -= to_next;
+        reveal_amount = current + 1;
+        reveal_pause = punctuation_pause( glyphs, current );
+    }
+}
+
+void Element::reveal_all() {
+    if( text )
+        reveal_amount = text->get_glyphs( GUI::font ).size();
+    reveal_pause = 0;
+}
+
+bool Element::is_revealing() {
+    return text && flags & REVEAL_TEXT && !( flags & HIDDEN ) && reveal_amount < text->get_glyphs( GUI::font ).size();
+}
+
 const std::string& Element::get_text() {
     if( text )
         return text->get_text();
@@ -185,6 +261,11 @@ void Element::get_vn_var( VNVariable &dest){
             // Use the key capture string
             dest.set(((ElementKeyCapture*)this)->get_key());
             return;
+
+        case LIST:
+            // Set to the selected entry, -1 if none
+            dest.set(((ElementList*)this)->get_selected());
+            return;
     }
 }
 
@@ -229,6 +310,10 @@ void Element::get_vn_var( VNVariable &dest){
         case KEY_CAPTURE:
             ((ElementKeyCapture*)this)->set_key( src.value_int());
             return;
+
+        case LIST:
+            ((ElementList*)this)->select_entry( src.value_int());
+            return;
     }
 }
 
@@ -388,7 +473,7 @@ void ElementTextInput::event_keypress( int32_t key, uint8_t modifier ) {
 }
 
 // Text insertion when typing
-void ElementTextInput::event_char( char c ) {
+void ElementTextInput::event_char( uint32_t c ) {
     if( text->get_text().size() < max_length || text->get_selection_text() > 0 ) {
         text->overwrite( c );
         flags |= CHANGED;
@@ -448,7 +533,7 @@ void ElementNumInput::event_keypress( int32_t key, uint8_t modifier ) {
 }
 
 // Text insertion when typing
-void ElementNumInput::event_char( char c ) {
+void ElementNumInput::event_char( uint32_t c ) {
     if( ( c < '0' || c > '9' ) && !( c == '.' || c == '-' ) )
         return;
 
@@ -633,3 +718,203 @@ void ElementKeyCapture::event_keypress( int32_t key_value, uint8_t modifiers_val
             owner->deselect();
     }
 };
+
+// LIST --------------------------------------------------------------------------------------------------------
+
+uint32_t ElementList::visible_count() {
+    return std::max( ( int32_t )( h / row_height + .001f ), 1 );
+}
+
+// One row per entry in view, rows are laid out again when the count changes
+void ElementList::fit_rows() {
+    uint32_t count = visible_count();
+
+    if( rows.size() == count )
+        return;
+
+    rows.resize( count );
+    row_entry.assign( count, UINT32_MAX );
+}
+
+void ElementList::add_entry( const std::string &s ) {
+    entries.push_back( s );
+}
+
+void ElementList::clear_entries() {
+    entries.clear();
+    selected_entry = -1;
+    sync();
+}
+
+void ElementList::entries_dropped( uint32_t amount ) {
+    amount = std::min( amount, known_count );
+    first = first > amount ? first - amount : 0;
+    known_count -= amount;
+
+    if( selected_entry >= 0 )
+        selected_entry = selected_entry >= ( int32_t )amount ? selected_entry - amount : -1;
+
+    refresh();
+}
+
+void ElementList::refresh() {
+    row_entry.assign( rows.size(), UINT32_MAX );
+    ++revision;
+}
+
+void ElementList::sync() {
+    uint32_t count = entry_count();
+    fit_rows();
+
+    if( count == known_count )
+        return;
+
+    uint32_t visible = visible_count();
+
+    // Entries were removed, rows may hold entries that moved
+    if( count < known_count ) {
+        row_entry.assign( rows.size(), UINT32_MAX );
+        if( selected_entry >= ( int32_t )count )
+            selected_entry = -1;
+    }
+
+    // Follow added entries if the end was in view
+    if( follow_end && first + visible >= known_count )
+        first = count > visible ? count - visible : 0;
+
+    known_count = count;
+    scroll( 0 );
+    ++revision;
+}
+
+void ElementList::scroll( int32_t rows_amount ) {
+    uint32_t count = entry_count();
+    uint32_t visible = visible_count();
+    int32_t last = count > visible ? count - visible : 0;
+    int32_t target = std::clamp( ( int32_t )first + rows_amount, 0, last );
+
+    if( ( uint32_t )target != first ) {
+        first = target;
+        ++revision;
+    }
+}
+
+void ElementList::scroll_to( uint32_t entry ) {
+    uint32_t visible = visible_count();
+
+    if( entry < first )
+        scroll( ( int32_t )entry - ( int32_t )first );
+    else if( entry >= first + visible )
+        scroll( ( int32_t )( entry - first - visible ) + 1 );
+}
+
+void ElementList::select_entry( int32_t entry ) {
+    if( entry < 0 || entry >= ( int32_t )entry_count() || entry == selected_entry )
+        return;
+
+    selected_entry = entry;
+    scroll_to( entry );
+    flags |= CHANGED;
+    ++revision;
+}
+
+Text &ElementList::get_row( uint32_t entry ) {
+    fit_rows();
+    uint32_t row = entry % rows.size();
+
+    if( row_entry[row] != entry ) {
+        get_entry( entry, entry_text );
+        rows[row].set_text( entry_text );
+        row_entry[row] = entry;
+    }
+
+    return rows[row];
+}
+
+// Selects the entry of the row at a local height, rows start at the top
+void ElementList::select_row( float y ) {
+    int32_t row = ( 1 - y ) * h / row_height;
+
+    if( row < 0 || row >= ( int32_t )visible_count() )
+        return;
+
+    int32_t previous = selected_entry;
+    select_entry( first + row );
+
+    if( selected_entry != previous )
+        GUI::play_sound_select();
+}
+
+void ElementList::event_select( float x, float y ) {
+    flags |= ACTIVE;
+    select_row( y );
+}
+
+void ElementList::event_reselect( float x, float y ) {
+    select_row( y );
+}
+
+void ElementList::event_keypress( int32_t key, uint8_t modifier ) {
+    int32_t visible = visible_count();
+
+    switch( key ) {
+        case GLFW_KEY_UP:
+            select_entry( selected_entry < 0 ? first : selected_entry - 1 );
+            break;
+
+        case GLFW_KEY_DOWN:
+            select_entry( selected_entry < 0 ? first : selected_entry + 1 );
+            break;
+
+        case GLFW_KEY_PAGE_UP:
+            scroll( -visible );
+            break;
+
+        case GLFW_KEY_PAGE_DOWN:
+            scroll( visible );
+            break;
+
+        case GLFW_KEY_HOME:
+            scroll( -( int32_t )first );
+            break;
+
+        case GLFW_KEY_END:
+            scroll( entry_count() );
+            break;
+    }
+}
+
+void ElementList::event_scroll( float amount ) {
+    scroll( -round( amount * scroll_step ) );
+}
+
+// BACKLOG -----------------------------------------------------------------------------------------------------
+
+void ElementBacklog::get_entry( uint32_t index, std::string &dest ) {
+    const std::string &speaker = VNI::backlog.get_speaker( index );
+    std::string_view line = VNI::backlog.get_text( index );
+    dest.clear();
+
+    if( !speaker.empty() )
+        dest.append( speaker ).append( ": " );
+
+    dest.append( line );
+}
+
+void ElementBacklog::sync() {
+    // Lines dropped from the backlog shift every entry
+    uint64_t dropped = VNI::backlog.get_dropped();
+    if( dropped != known_dropped ) {
+        entries_dropped( std::min<uint64_t>( dropped - known_dropped, UINT32_MAX ) );
+        known_dropped = dropped;
+    }
+
+    // Lines continued or removed are laid out again
+    uint64_t edits = VNI::backlog.get_edits();
+    if( edits != known_edits ) {
+        refresh();
+        known_edits = edits;
+    }
+
+    ElementList::sync();
+}
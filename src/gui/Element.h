@@ -6,6 +6,7 @@
 #include <vector>
 #include <memory>
 #include "VNVariable.h"
+#include "VNBacklog.h"
 
 // Forward Declare
 class ElementSet;
@@ -19,7 +20,8 @@ enum ElementType : uint8_t {
     TEXT_INPUT, // Text that can be selected and edited
     NUM_INPUT,  // Number that can be selected and edited
     BAR,        // Select a float value based on x position
-    KEY_CAPTURE // Capture whichever key is pressed
+    KEY_CAPTURE,// Capture whichever key is pressed
+    LIST        // Scrolling list of text entries
 };
 
 struct Element {
@@ -37,11 +39,17 @@ struct Element {
         ElementSet *owner = nullptr;          // The owner of this element
         uint8_t flags = 0;                    // Flags shared by all element types
         ElementType type = NONE;              // The element type
-        float x = 0, y = 0, w = .2, h = .2;   // Position and dimensions of element
+        float x = 0, y = 0, w = .2, h = .2;   // Position and dimensions of element, set through set_position and set_size once owned
 
         std::string routine_file, routine_label;
         bool has_routine = false;
-        uint32_t reveal_amount = 0;
+
+        // Glyphs revealed, revealing advances by elapsed time and pauses after punctuation
+        float reveal_amount = 0;
+        float reveal_pause = 0;
+
+        // Glyphs revealed per second, 0 uses the GUI rate
+        float reveal_rate = 0;
 
 
         Element();
@@ -59,7 +67,10 @@ struct Element {
         // When the element is selected and a key combo is pressed
         virtual void event_keypress( int32_t key_value, uint8_t modifiers_value );
 
-        virtual void event_char( char c );
+        virtual void event_char( uint32_t c );
+
+        // When the wheel is turned over the element, positive towards the top
+        virtual void event_scroll( float amount );
         bool is_active();
         void set_hidden( bool b );
         void localize_coordinates( float &sx, float &sy );
@@ -72,6 +83,11 @@ struct Element {
         void set_text( const char *s, uint32_t count );
         const std::string& get_text();
         bool changed();
+
+        // Advances the reveal by the time in seconds, shows every glyph, and whether glyphs are still hidden
+        void update_reveal( float time );
+        void reveal_all();
+        bool is_revealing();
         void hide();
         void show();
         void get_vn_var(VNVariable &dest);
@@ -191,7 +207,7 @@ class ElementTextInput : public Element {
         void event_deselect() override;
         void event_reselect( float x, float y ) override;
         void event_keypress( int32_t key, uint8_t modifier ) override;
-        void event_char( char c ) override;
+        void event_char( uint32_t c ) override;
 };
 
 // Allows for typing a number
@@ -251,7 +267,7 @@ class ElementNumInput : public Element {
         void event_keypress( int32_t key, uint8_t modifier ) override;
 
         // Text insertion when typing
-        void event_char( char c ) override;
+        void event_char( uint32_t c ) override;
 
         void set_value( float v ) {
             value = v;
@@ -371,4 +387,95 @@ class ElementKeyCapture : public Element {
         }
 };
 
+/*
+ * A scrolling list of text entries, only the rows in view hold a Text.
+ * Entry i is drawn by row i % rows, so scrolling by a row lays out only the entry coming into view.
+ * Entries are read through entry_count and get_entry, lists over other storage override those.
+ */
+class ElementList : public Element {
+        std::vector<std::string> entries;
+        std::vector<Text> rows;
+        std::vector<uint32_t> row_entry;
+        std::string entry_text;
+        uint32_t first = 0, known_count = 0, revision = 0;
+        int32_t selected_entry = -1;
+
+        void fit_rows();
+        void select_row( float y );
+
+    protected:
+        // Entries removed from the front, the same entries stay in view
+        void entries_dropped( uint32_t amount );
+
+    public:
+        // Height of each row in the same units as the element height
+        float row_height = .06f;
+
+        // Rows scrolled by each step of the wheel
+        float scroll_step = 3;
+
+        // Keeps the last entry in view as entries are added, unless scrolled away from the end
+        bool follow_end = true;
+
+        ElementList() {
+            type = LIST;
+            text = std::make_unique<Text>(Text());
+            flags |= LEFT_ALIGN;
+        }
+
+        virtual uint32_t entry_count() {
+            return entries.size();
+        }
+
+        virtual void get_entry( uint32_t index, std::string &dest ) {
+            dest = entries[index];
+        }
+
+        void add_entry( const std::string &s );
+        void clear_entries();
+
+        // Lays out every row in view again, for entries that changed in place
+        void refresh();
+
+        // Follows entries added or removed since the last call, called each frame by the element set
+        virtual void sync();
+
+        void scroll( int32_t rows_amount );
+        void scroll_to( uint32_t entry );
+        void select_entry( int32_t entry );
+
+        // The text of an entry in view, laid out when it comes into view
+        Text &get_row( uint32_t entry );
+
+        uint32_t visible_count();
+        inline uint32_t get_first() {return first;}
+        inline int32_t get_selected() {return selected_entry;}
+
+        // Changes with every scroll, selection or change of entries
+        inline uint32_t get_revision() {return revision;}
+
+        void event_select( float x, float y ) override;
+        void event_reselect( float x, float y ) override;
+        void event_keypress( int32_t key, uint8_t modifier ) override;
+        void event_scroll( float amount ) override;
+};
+
+// The lines of the dialogue backlog as speaker: line, laid out as they come into view
+class ElementBacklog : public ElementList {
+        uint64_t known_dropped, known_edits;
+
+    public:
+        ElementBacklog() {
+            known_dropped = VNI::backlog.get_dropped();
+            known_edits = VNI::backlog.get_edits();
+        }
+
+        uint32_t entry_count() override {
+            return VNI::backlog.size();
+        }
+
+        void get_entry( uint32_t index, std::string &dest ) override;
+        void sync() override;
+};
+
 #endif // ELEMENT_H
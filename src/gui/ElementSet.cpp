@@ -1,5 +1,8 @@
 #include "ElementSet.h"
 #include "GUI.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 
 void ElementSet::deselect() {
     if( selection )
@@ -8,8 +11,76 @@ void ElementSet::deselect() {
     selection = nullptr;
 }
 
+/*
+ * Sorts the elements into the cells of a grid covering the screen, an element is in every cell its rectangle overlaps.
+ * Elements reaching past the screen are kept in the cells at its edges.
+ * The grid has about one cell per element, so each cell holds few elements however many the set has.
+ */
+void ElementSet::build_grid() {
+    layout_changed = false;
+    grid_ratio = GUI::ratio;
+    grid_size = std::clamp( ( uint32_t )ceil( sqrt( elements.size() ) ), 1u, 64u );
+
+    uint32_t cells = grid_size * grid_size;
+    grid_start.assign( cells + 1, 0 );
+
+    auto cell_range = [&]( Element *e, uint32_t &x1, uint32_t &y1, uint32_t &x2, uint32_t &y2 ) {
+        auto cell = [&]( float v ) {
+            return ( uint32_t )std::clamp( ( int32_t )floor( v * grid_size ), 0, ( int32_t )grid_size - 1 );
+        };
+        x1 = cell( e->x );
+        x2 = cell( e->x + e->w / GUI::ratio );
+        y1 = cell( e->y );
+        y2 = cell( e->y + e->h );
+    };
+
+    // Count the elements of each cell, then place them after the counts of the cells before
+    uint32_t x1, y1, x2, y2;
+    for( Element *e : elements ) {
+        cell_range( e, x1, y1, x2, y2 );
+        for( uint32_t y = y1; y <= y2; ++y )
+            for( uint32_t x = x1; x <= x2; ++x )
+                ++grid_start[y * grid_size + x + 1];
+    }
+
+    for( uint32_t i = 0; i < cells; ++i )
+        grid_start[i + 1] += grid_start[i];
+
+    grid_elements.resize( grid_start[cells] );
+    std::vector<uint32_t> fill( grid_start.begin(), grid_start.end() - 1 );
+
+    for( uint32_t i = 0; i < elements.size(); ++i ) {
+        cell_range( elements[i], x1, y1, x2, y2 );
+        for( uint32_t y = y1; y <= y2; ++y )
+            for( uint32_t x = x1; x <= x2; ++x )
+                grid_elements[fill[y * grid_size + x]++] = i;
+    }
+}
+
+// The elements that may contain a point, rebuilding the grid if the layout changed
+void ElementSet::find_cell( float x, float y, const uint32_t *&first, const uint32_t *&last ) {
+    if( layout_changed || grid_ratio != GUI::ratio )
+        build_grid();
+
+    int32_t cx = std::clamp( ( int32_t )floor( x * grid_size ), 0, ( int32_t )grid_size - 1 );
+    int32_t cy = std::clamp( ( int32_t )floor( y * grid_size ), 0, ( int32_t )grid_size - 1 );
+    uint32_t cell = cy * grid_size + cx;
+
+    first = grid_elements.data() + grid_start[cell];
+    last = grid_elements.data() + grid_start[cell + 1];
+}
+
+/*
+ * Only the elements in the cell of the point are tested.
+ * Highlights are changed for the elements entering or leaving the point since the last call.
+ */
 void ElementSet::highlight(float x, float y){
-    for( Element *element : elements ) {
+    const uint32_t *first, *last;
+    find_cell( x, y, first, last );
+    hovered_next.clear();
+
+    for( const uint32_t *i = first; i != last; ++i ) {
+        Element *element = elements[*i];
         if( element->flags & Element::DISABLED || element->flags & Element::HIDDEN )
             continue;
 
@@ -19,15 +90,43 @@ void ElementSet::highlight(float x, float y){
             if(!(element->flags & Element::HIGHLIGHT))
                 GUI::play_sound_hover();
             element->flags |= Element::HIGHLIGHT;
+            hovered_next.push_back( element );
         }
-        else{
+    }
+
+    for( Element *element : hovered ) {
+        if( std::find( hovered_next.begin(), hovered_next.end(), element ) == hovered_next.end() )
             element->flags &= ~Element::HIGHLIGHT;
+    }
+
+    hovered.swap( hovered_next );
+}
+
+// Passes the wheel to the element under the point
+void ElementSet::scroll( float x, float y, float amount ) {
+    const uint32_t *first, *last;
+    find_cell( x, y, first, last );
+
+    for( const uint32_t *i = first; i != last; ++i ) {
+        Element *element = elements[*i];
+        if( element->flags & Element::DISABLED || element->flags & Element::HIDDEN )
+            continue;
+
+        float lx, ly;
+
+        if( element->contains_point( x, y, lx, ly ) ) {
+            element->event_scroll( amount );
+            return;
         }
     }
 }
 
 void ElementSet::select( float x, float y ) {
-    for( Element *element : elements ) {
+    const uint32_t *first, *last;
+    find_cell( x, y, first, last );
+
+    for( const uint32_t *i = first; i != last; ++i ) {
+        Element *element = elements[*i];
         if( element->flags & Element::DISABLED || element->flags & Element::HIDDEN )
             continue;
 
@@ -65,6 +164,7 @@ void ElementSet::add( Element *element ) {
 
     element->set_owner( this );
     elements.push_back( element );
+    layout_changed = true;
 }
 
 void ElementSet::remove( Element *element ) {
@@ -72,6 +172,8 @@ void ElementSet::remove( Element *element ) {
         if( elements[i] == element ) {
             element->owner = nullptr;
             elements.erase( elements.begin() + i );
+            hovered.erase( std::remove( hovered.begin(), hovered.end(), element ), hovered.end() );
+            layout_changed = true;
             return;
         }
     }
@@ -83,67 +185,80 @@ void ElementSet::remove_all() {
     }
 
     elements.clear();
+    hovered.clear();
+    layout_changed = true;
 }
 
-// NOTE Shader and VAO should be pre-bound before this call
+/*
+ * Backgrounds and texts of every element are collected into the GUI batch and drawn in one call each.
+ * Colors that were uniforms are written to each vertex.
+ */
 void ElementSet::draw() {
+    vec4 everything = {-INFINITY, -INFINITY, INFINITY, INFINITY};
+    draw( everything );
+}
+
+void ElementSet::draw( const vec4 region ) {
+    auto outside = [&]( Element *e ) {
+        float x = e->x * GUI::ratio;
+        return x > region[2] || x + e->w < region[0] || e->y > region[3] || e->y + e->h < region[1];
+    };
+
     mat4 ortho;
     glm_ortho( 0, GUI::ratio, 0, 1, 0, 1, ortho );
 
-    // Draw Backgrounds
-    GUI::quad_vao.bind();
-    Shader::bind( GUI::background_shader );
-    Shader::uniformMat4f( UNIFORM_CAMERA, ortho );
+    GUIBatch &batch = GUI::batch;
+    batch.clear();
+    GUI::font.begin_frame();
 
+    // Backgrounds
     for( Element *e : elements ) {
-        if( e->flags & Element::HIDDEN )
+        if( e->flags & Element::HIDDEN || outside( e ) )
             continue;
 
-        // Background
-        Shader::uniformVec4f( UNIFORM_TRANSFORM, vec4{e->x * GUI::ratio, e->y, e->w, e->h} );
-        Shader::uniformFloat( UNIFORM_FACTOR, fmax( GUI::bevel, 1.0f / fmin( e->w, e->h ) ) );
-        if(e->is_active()){
-            Shader::uniformVec3f( UNIFORM_COLOR,GUI::colors.background_active );
-            Shader::uniformVec3f( UNIFORM_COLOR2,GUI::colors.outline_active );
-        }
-        else{
-            Shader::uniformVec3f( UNIFORM_COLOR,GUI::colors.background_inactive );
-            Shader::uniformVec3f( UNIFORM_COLOR2,GUI::colors.outline_inactive );
-        }
-        if(e->flags & Element::HIGHLIGHT)
-            Shader::uniformVec3f( UNIFORM_COLOR2,GUI::colors.decorator_active );
+        uint32_t background = GUIBatch::pack_color( e->is_active() ? GUI::colors.background_active : GUI::colors.background_inactive, .8f );
+        uint32_t outline = GUIBatch::pack_color( e->is_active() ? GUI::colors.outline_active : GUI::colors.outline_inactive, .8f );
+        if( e->flags & Element::HIGHLIGHT )
+            outline = GUIBatch::pack_color( GUI::colors.decorator_active, .8f );
 
-        glDrawArrays( GL_QUADS, 0, 4 );
+        float x = e->x * GUI::ratio;
+        float bevel = fmax( GUI::bevel, 1.0f / fmin( e->w, e->h ) );
+        batch.add_quad( GUIBatch::LAYER_BACKGROUND, x, e->y, x + e->w, e->y + e->h, 0, 0, 1, 1,
+                        background, outline, vec4{e->w, e->h, bevel, 0} );
 
         // Addition decorator for bars
         if( e->type == BAR ) {
-            float v = static_cast<ElementBar *>( e )->get_normalized_value();
-            Shader::uniformVec4f( UNIFORM_TRANSFORM,
-                vec4{e->x * GUI::ratio, e->y, e->w * v, e->h}
-            );
-            Shader::uniformVec3f( UNIFORM_COLOR, e->is_active() ? GUI::colors.decorator_active : GUI::colors.decorator_inactive );
-            glDrawArrays( GL_QUADS, 0, 4 );
+            float w = e->w * static_cast<ElementBar *>( e )->get_normalized_value();
+            uint32_t decorator = GUIBatch::pack_color( e->is_active() ? GUI::colors.decorator_active : GUI::colors.decorator_inactive, .8f );
+            batch.add_quad( GUIBatch::LAYER_BACKGROUND, x, e->y, x + w, e->y + e->h, 0, 0, 1, 1,
+                            decorator, outline, vec4{w, e->h, bevel, 0} );
         }
-    }
 
-    // Draw Texts
-    Shader::bind( GUI::text_shader );
-    Shader::uniformMat4f( UNIFORM_CAMERA, ortho );
-    GUI::font.fontTexture.bind( 0 );
-    float scale = .2;
+        // Decorator behind the selected row of lists
+        if( e->type == LIST ) {
+            ElementList *list = static_cast<ElementList *>( e );
+            int32_t row = list->get_selected() - ( int32_t )list->get_first();
 
-    Shader::uniformVec3f( UNIFORM_COLOR2, GUI::colors.decorator_active );
-
-    for( Element *e : elements ) {
-        if( e->flags & Element::HIDDEN || !e->text )
-            continue;
+            if( list->get_selected() >= 0 && row >= 0 && row < ( int32_t )list->visible_count() ) {
+                float y2 = e->y + e->h - row * list->row_height, y1 = y2 - list->row_height;
+                uint32_t decorator = GUIBatch::pack_color( e->is_active() ? GUI::colors.decorator_active : GUI::colors.decorator_inactive, .8f );
+                batch.add_quad( GUIBatch::LAYER_BACKGROUND, x, y1, x + e->w, y2, 0, 0, 1, 1,
+                                decorator, decorator, vec4{e->w, list->row_height, bevel, 0} );
+            }
+        }
+    }
 
-        e->text->bind( GUI::font );
+    // Texts
+    uint32_t selected = GUIBatch::pack_color( GUI::colors.decorator_active );
+    float scale = .2;
 
-        e->text->set_ideal_ratio(e->w/e->h);
+    // Text fit into a box of x, y, w, h in GUI units
+    auto add_text = [&]( Element *e, Text &text, float x, float y, float w, float h, const float *text_color ) {
+        text.set_ideal_ratio(w/h);
+        const std::vector<TextGlyph> &glyphs = text.get_glyphs( GUI::font );
 
         //only fill to 9 height
-        scale = fmin( e->w / e->text->get_width(), e->h / e->text->get_height() * .95 );
+        scale = fmin( w / text.get_width(), h / text.get_height() * .95 );
 
         // Adjust scale into uniform sizes, this keeps the UI consistent
         scale = scale > .2 ? floor( scale * 10 ) / 10 : scale;
@@ -154,34 +269,156 @@ void ElementSet::draw() {
         // Limit to max text size
         scale = fmin(scale, GUI::max_text_size);
 
-        // Text transform is 2d screen position and scale
-        Shader::uniformVec3f( UNIFORM_TRANSFORM, vec3{
-            // If left align, use half the fraction of the box not filled (1-.9)/2, if center align, use half the difference
-            e->x * GUI::ratio + ( e->flags & Element::LEFT_ALIGN ? .025f * e->w : 0.5f * ( e->w - e->text->get_width()*scale ) ),
-            e->y + 0.5f * ( e->h + scale * e->text->get_height() ),
-            scale}
-        );
-        if(e->is_active()){
-            Shader::uniformVec3f( UNIFORM_COLOR, GUI::colors.text_active );
+        // If left align, use half the fraction of the box not filled (1-.9)/2, if center align, use half the difference
+        float ox = x + ( e->flags & Element::LEFT_ALIGN ? .025f * w : 0.5f * ( w - text.get_width()*scale ) );
+        float oy = y + 0.5f * ( h + scale * text.get_height() );
+
+        // Index of the last glyph fully revealed, revealing is advanced by update
+        float revealed = UINT32_MAX - 1;
+        if(e->flags & Element::REVEAL_TEXT && e->reveal_amount < glyphs.size())
+            revealed = floor( e->reveal_amount ) - 1;
+
+        auto add_glyph = [&]( const TextGlyph &g ) {
+            vec4 uv;
+            if( !GUI::font.get_uv( GUI::font.get_glyph( g.codepoint ), uv ) )
+                return;
+
+            // Mix the text color with the glyph's color by the glyph's alpha
+            uint8_t c[4];
+            memcpy( c, &g.color, 4 );
+            vec3 color = {c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f};
+            glm_vec3_lerp( (float *)text_color, color, c[3] / 255.0f, color );
+
+            uint32_t packed = g.selected ? selected : GUIBatch::pack_color( color );
+            batch.add_quad( GUIBatch::LAYER_TEXT, ox + g.x1 * scale, oy + g.y1 * scale, ox + g.x2 * scale, oy + g.y2 * scale,
+                            uv[0], uv[1], uv[2], uv[3], packed, packed, vec4{(float)g.index, revealed, 0, 0} );
+        };
+
+        for( const TextGlyph &g : glyphs )
+            add_glyph( g );
+
+        TextGlyph cursor;
+        if( text.get_cursor( cursor ) )
+            add_glyph( cursor );
+    };
+
+    for( Element *e : elements ) {
+        if( e->flags & Element::HIDDEN || !e->text || outside( e ) )
+            continue;
+
+        const float *text_color = e->is_active() ? GUI::colors.text_active : GUI::colors.text_inactive;
+
+        // Lists only draw the rows in view
+        if( e->type == LIST ) {
+            ElementList *list = static_cast<ElementList *>( e );
+            uint32_t end = std::min( list->get_first() + list->visible_count(), list->entry_count() );
+
+            for( uint32_t i = list->get_first(); i < end; ++i ) {
+                float y = e->y + e->h - ( i - list->get_first() + 1 ) * list->row_height;
+                add_text( e, list->get_row( i ), e->x * GUI::ratio, y, e->w, list->row_height,
+                          ( int32_t )i == list->get_selected() ? GUI::colors.text_active : GUI::colors.text_inactive );
+            }
+
+            continue;
         }
-        else{
-            Shader::uniformVec3f( UNIFORM_COLOR, GUI::colors.text_inactive );
+
+        add_text( e, *e->text, e->x * GUI::ratio, e->y, e->w, e->h, text_color );
+    }
+
+    batch.draw( ortho );
+}
+
+ElementSet::DrawnState ElementSet::drawn_state( Element *e ) {
+    DrawnState s = {e, e->flags, e->x, e->y, e->w, e->h, 0, 0, 0};
+
+    if( e->text ) {
+        s.text_revision = e->text->get_revision();
+        if( e->flags & Element::REVEAL_TEXT )
+            s.revealed = e->reveal_amount;
+    }
+
+    if( e->type == BAR )
+        s.value = static_cast<ElementBar *>( e )->get_normalized_value();
+
+    if( e->type == LIST )
+        s.text_revision = static_cast<ElementList *>( e )->get_revision();
+
+    return s;
+}
+
+bool ElementSet::find_dirty_region( vec4 region, bool all ) {
+    // Added, removed or reordered elements redraw everything
+    if( drawn.size() != elements.size() )
+        all = true;
+
+    region[0] = region[1] = INFINITY;
+    region[2] = region[3] = -INFINITY;
+
+    auto cover = [&]( const DrawnState &s ) {
+        float x = s.x * GUI::ratio;
+        region[0] = fmin( region[0], x );
+        region[1] = fmin( region[1], s.y );
+        region[2] = fmax( region[2], x + s.w );
+        region[3] = fmax( region[3], s.y + s.h );
+    };
+
+    drawn.resize( elements.size() );
+
+    for( uint32_t i = 0; i < elements.size(); ++i ) {
+        DrawnState s = drawn_state( elements[i] );
+
+        if( all || s.element != drawn[i].element ) {
+            all = true;
         }
-        if(e->flags & Element::REVEAL_TEXT && e->reveal_amount < e->text->get_text().size()){
-            e->reveal_amount++;
-            Shader::uniformUint( UNIFORM_FACTOR, e->reveal_amount);
+        else if( !( s == drawn[i] ) ) {
+            cover( drawn[i] );
+            cover( s );
         }
-        else{
-            Shader::uniformUint( UNIFORM_FACTOR, UINT32_MAX-1);
+
+        drawn[i] = s;
+    }
+
+    if( all ) {
+        region[0] = region[1] = -INFINITY;
+        region[2] = region[3] = INFINITY;
+        return true;
+    }
+
+    return region[0] <= region[2];
+}
+
+void ElementSet::update( float time ) {
+    for( Element *e : elements ) {
+        e->update_reveal( time );
+
+        if( e->type == LIST )
+            static_cast<ElementList *>( e )->sync();
+    }
+}
+
+bool ElementSet::skip_reveal() {
+    bool skipped = false;
+
+    for( Element *e : elements ) {
+        if( e->is_revealing() ) {
+            e->reveal_all();
+            skipped = true;
         }
+    }
 
-        glDrawArrays( GL_QUADS, 0, e->text->get_vertex_count() );
+    return skipped;
+}
+
+bool ElementSet::is_revealing() {
+    for( Element *e : elements ) {
+        if( e->is_revealing() )
+            return true;
     }
 
-    Shader::unbind();
+    return false;
 }
 
-void ElementSet::char_input( char c ) {
+void ElementSet::char_input( uint32_t c ) {
     if( !selection )
         return;
 
@@ -199,6 +436,7 @@ void ElementSet::key_input( uint32_t key_value, uint8_t modifiers_value ) {
 
 // Spaces elements apart horizontally
 void ElementSet::compact( unsigned int start, float left, float right, float top, float spacing, float line_spacing ) {
+    layout_changed = true;
     float w = left, h = top, max_height = 0;
     unsigned int line_start = start, line_end = start;
 
@@ -227,6 +465,7 @@ void ElementSet::compact( unsigned int start, float left, float right, float top
 }
 
 void ElementSet::compact_center( unsigned int start, float center, float max_width, float top, float spacing, float line_spacing ) {
+    layout_changed = true;
     float w = center, h = top, line_width = 0, line_height = 0;
     unsigned int line_start = start, line_end = start;
 
@@ -17,7 +17,9 @@ struct ElementColor {
     text_active = {1,1,1},
     text_inactive = {.75,.75,.75},
     decorator_active = {.54,.54,.54},
-    decorator_inactive = {.21, .21, .21};
+    decorator_inactive = {.21, .21, .21},
+    text_outline = {0,0,0},
+    text_shadow = {0,0,0};
 
     ElementColor(){
         theme_dark();
@@ -34,6 +36,8 @@ struct ElementColor {
         vec3_compose( text_inactive, 0, 0, 0 );
         vec3_compose( decorator_active, .5, .65, .8 );
         vec3_compose( decorator_inactive, .6, .75, .9 );
+        vec3_compose( text_outline, 1, 1, 1 );
+        vec3_compose( text_shadow, .4, .4, .4 );
     }
 
     void theme_dark(){
@@ -45,6 +49,8 @@ struct ElementColor {
         vec3_compose( text_inactive, 1,1,1 );
         vec3_compose( decorator_active, 0, .3, .7  );
         vec3_compose( decorator_inactive, 0, .2, .6 );
+        vec3_compose( text_outline, 0, 0, 0 );
+        vec3_compose( text_shadow, 0, 0, 0 );
     }
 
 };
@@ -59,16 +65,63 @@ class ElementSet {
         Element *selection = nullptr;
         bool bool_had_input = false;
 
+        // What each element looked like when last drawn, elements are redrawn when it changes
+        struct DrawnState {
+            Element *element;
+            uint8_t flags;
+            float x, y, w, h;
+            uint32_t text_revision;
+            int32_t revealed;
+            float value;
+
+            bool operator==( const DrawnState &b ) const = default;
+        };
+        std::vector<DrawnState> drawn;
+
+        DrawnState drawn_state( Element *e );
+
+        // Indices of the elements overlapping each cell of a uniform grid over the screen, in the order of the set
+        std::vector<uint32_t> grid_start, grid_elements;
+        uint32_t grid_size = 0;
+        float grid_ratio = 0;
+        bool layout_changed = true;
+
+        // Elements highlighted by the last call to highlight
+        std::vector<Element *> hovered, hovered_next;
+
+        void build_grid();
+        void find_cell( float x, float y, const uint32_t *&first, const uint32_t *&last );
+
     public:
 
         void deselect();
         void select( float x, float y );
         void highlight( float x, float y );
+        void scroll( float x, float y, float amount );
         void add( Element *element );
         void remove( Element *element );
         void remove_all();
         void draw();
-        void char_input( char c );
+
+        // Rebuilds the hit testing grid before the next input, needed after moving or resizing elements directly
+        inline void invalidate_layout(){ layout_changed = true; }
+
+        // Draws the elements that overlap a region of x1, y1, x2, y2 in GUI coordinates
+        void draw( const vec4 region );
+
+        /*
+         * Finds the region covering every element that changed since the last call, before and after the change.
+         * All marks the whole set as changed. False when nothing changed.
+         */
+        bool find_dirty_region( vec4 region, bool all = false );
+
+        // Advances revealing text by the time in seconds
+        void update( float time );
+
+        // Reveals all text that is being revealed, false if there was none
+        bool skip_reveal();
+        bool is_revealing();
+        void char_input( uint32_t c );
         void key_input( uint32_t key_value, uint8_t modifiers_value );
         void compact( uint32_t start, float left, float right, float top, float spacing, float line_spacing );
         void compact_center( uint32_t start, float center, float max_width, float top, float spacing, float line_spacing );
@@ -2,6 +2,10 @@
 #include <iostream>
 #include <string>
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include "library/stb_image.h"
 #include "FontInfo.h"
 
 using std::string;
@@ -13,14 +17,13 @@ FontInfo::FontInfo() {
     resolution = 256;
     lineHeight = 0;
     glyphCount = 0;
-    glyphs = std::map<char, GlyphInfo>();
 }
 
 FontInfo::FontInfo( FontInfo const &a ) {
     resolution = a.resolution;
     lineHeight = a.lineHeight;
     glyphCount = a.glyphCount;
-    glyphs = a.glyphs;
+    glyph_blocks = a.glyph_blocks;
 }
 
 FontInfo::~FontInfo() {
@@ -28,76 +31,207 @@ FontInfo::~FontInfo() {
 
 void FontInfo::free_texture(){
     fontTexture.free();
+    atlas.free();
 }
 
+// Reads the key=value pairs of a line, values may be quoted
+static std::unordered_map<string, string> read_values( const string &line ) {
+    std::unordered_map<string, string> values;
+    size_t i = line.find( ' ' );
+
+    while( i < line.size() ) {
+        size_t equals = line.find( '=', i );
+        if( equals == string::npos )
+            break;
+
+        size_t key_start = line.find_last_of( ' ', equals ) + 1;
+        size_t end;
+        string value;
+
+        if( equals + 1 < line.size() && line[equals + 1] == '"' ) {
+            end = line.find( '"', equals + 2 );
+            end = end == string::npos ? line.size() : end;
+            value = line.substr( equals + 2, end - equals - 2 );
+            ++end;
+        }
+        else {
+            end = line.find( ' ', equals );
+            end = end == string::npos ? line.size() : end;
+            value = line.substr( equals + 1, end - equals - 1 );
+        }
+
+        values[line.substr( key_start, equals - key_start )] = value;
+        i = end;
+    }
+
+    return values;
+}
+
+/*
+ * Reads the common, page and char lines of a BMFont text file.
+ * Metrics may be written as decimals, they are truncated to whole pixels.
+ * Page files are found in the textures directory, a font without page lines uses the png of the same name.
+ */
 void FontInfo::load( string filename ) {
     ifstream input;
     input.open( (std::string)DIR_FONTS + filename + ".fnt" );
-    fontTexture.load_png( filename, GL_LINEAR , GL_CLAMP, GL_RED);
     if( !input.is_open() ) {
         printf( "Failed to open font %s", filename.c_str() );
         return;
     }
 
-    // Ignore info line
-    input.ignore( 256, '\n' );
+    glyph_blocks.clear();
+    pages.clear();
+    page_width = 0;
+    glyphCount = 0;
+
+    std::vector<string> page_files;
+    int max_width = 0, max_height = 0;
+    string line;
+
+    while( std::getline( input, line ) ) {
+        if( !line.empty() && line.back() == '\r' )
+            line.pop_back();
+
+        string tag = line.substr( 0, line.find( ' ' ) );
+        std::unordered_map<string, string> values = read_values( line );
+
+        auto number = [&]( const char *key, float fallback ) {
+            auto found = values.find( key );
+            return found == values.end() ? fallback : strtof( found->second.c_str(), nullptr );
+        };
+
+        if( tag == "common" ) {
+            lineHeight = number( "lineHeight", lineHeight );
+            resolution = number( "scaleW", number( "resolution", resolution ) );
+        }
+        else if( tag == "page" ) {
+            uint32_t id = number( "id", 0 );
+            if( id >= page_files.size() )
+                page_files.resize( id + 1 );
+            page_files[id] = values["file"];
+        }
+        else if( tag == "char" ) {
+            int id = number( "id", -1 );
+            if( id < 0 || id > 0x10FFFF )
+                continue;
+
+            GlyphInfo glyph;
+            glyph.x = number( "x", 0 );
+            glyph.y = number( "y", 0 );
+            glyph.width = number( "width", 0 );
+            glyph.height = number( "height", 0 );
+            glyph.xoffset = number( "xoffset", 0 );
+            glyph.yoffset = number( "yoffset", 0 );
+            glyph.xadvance = number( "xadvance", 0 );
+            glyph.page = number( "page", 0 );
+            glyph.codepoint = id;
+            glyph.defined = true;
+
+            uint32_t block = id >> 8;
+            if( block >= glyph_blocks.size() )
+                glyph_blocks.resize( block + 1 );
+            if( glyph_blocks[block].empty() )
+                glyph_blocks[block].resize( 256 );
+
+            glyph_blocks[block][id & 255] = glyph;
+            max_width = std::max( max_width, glyph.width );
+            max_height = std::max( max_height, glyph.height );
+            ++glyphCount;
+        }
+    }
+
+    input.close();
+
+    if( page_files.empty() )
+        page_files.push_back( filename + ".png" );
 
-    // Read common data
-    // ignore "common"
-    input.ignore( 256, ' ' );
+    margin = sdf_spread;
+    dynamic_atlas = dynamic || margin > 0 || page_files.size() > 1;
 
-    // lineHeight
-    input.ignore( 256, '=' );
-    input >> lineHeight;
+    if( !dynamic_atlas ) {
+        string name = page_files[0];
+        if( name.size() > 4 && name.compare( name.size() - 4, 4, ".png" ) == 0 )
+            name.resize( name.size() - 4 );
 
-    // resolution
-    input.ignore( 256, '=' );
-    input >> resolution;
+        fontTexture.load_png( name, GL_LINEAR, GL_CLAMP, GL_RED );
+    }
+    else {
+        // Pages stay in memory, only the glyphs that are drawn are copied to the atlas
+        pages.resize( page_files.size() );
+
+        for( uint32_t i = 0; i < page_files.size(); ++i ) {
+            string filepath = (std::string)DIR_TEXTURES + page_files[i];
+            int w, h, c;
+            unsigned char *data = stbi_load( filepath.c_str(), &w, &h, &c, 1 );
+
+            if( !data ) {
+                printf( "Failed to load font page: %s\n", filepath.c_str() );
+                continue;
+            }
+
+            if( page_width != 0 && page_width != (uint32_t)w ) {
+                printf( "Font page width does not match previous pages: %s\n", filepath.c_str() );
+                stbi_image_free( data );
+                continue;
+            }
+
+            page_width = w;
+            pages[i].assign( data, data + w * h );
+            stbi_image_free( data );
+        }
+
+        atlas.allocate( atlas_size, max_width, max_height, margin );
+    }
 
-    // glyph count
-    input.ignore( 256, '=' );
-    input >> glyphCount;
+    printf( "Loaded font %s: %d glyphs, %u pages, %.2f MB%s%s\n", filename.c_str(), glyphCount, (uint32_t)page_files.size(),
+            get_memory_size() / ( 1024.0 * 1024.0 ), dynamic_atlas ? " dynamic" : "", margin ? " sdf" : "" );
+}
 
-    // start reading data
-    int id;
+const GlyphInfo &FontInfo::get_glyph( uint32_t codepoint ) const {
+    static const GlyphInfo missing = {};
 
-    for( int i = 0; i < glyphCount; i++ ) {
-        GlyphInfo glyph;
+    uint32_t block = codepoint >> 8;
+    if( block < glyph_blocks.size() && !glyph_blocks[block].empty() && glyph_blocks[block][codepoint & 255].defined )
+        return glyph_blocks[block][codepoint & 255];
 
-        // id
-        input.ignore( 256, '=' );
-        input >> id;
+    if( codepoint != '?' )
+        return get_glyph( '?' );
 
-        // x
-        input.ignore( 256, '=' );
-        input >> glyph.x;
+    return missing;
+}
 
-        // y
-        input.ignore( 256, '=' );
-        input >> glyph.y;
+bool FontInfo::get_uv( const GlyphInfo &glyph, vec4 uv ) {
+    if( !dynamic_atlas ) {
+        uv[0] = glyph.x / resolution;
+        uv[1] = ( glyph.y + glyph.height ) / resolution;
+        uv[2] = ( glyph.x + glyph.width ) / resolution;
+        uv[3] = glyph.y / resolution;
+        return true;
+    }
 
-        // width
-        input.ignore( 256, '=' );
-        input >> glyph.width;
+    const uint8_t *source = glyph.page < pages.size() && !pages[glyph.page].empty() ? pages[glyph.page].data() : nullptr;
+    return atlas.acquire( glyph.codepoint, source, page_width, glyph.x, glyph.y, glyph.width, glyph.height, uv );
+}
 
-        // height
-        input.ignore( 256, '=' );
-        input >> glyph.height;
+Texture *FontInfo::get_texture() {
+    return dynamic_atlas ? atlas.get_texture() : &fontTexture;
+}
 
-        // xoffset
-        input.ignore( 256, '=' );
-        input >> glyph.xoffset;
+void FontInfo::begin_frame() {
+    atlas.begin_frame();
+}
 
-        // yoffset
-        input.ignore( 256, '=' );
-        input >> glyph.yoffset;
+uint64_t FontInfo::get_memory_size() const {
+    uint64_t bytes = 0;
 
-        // xadvance
-        input.ignore( 256, '=' );
-        input >> glyph.xadvance;
+    for( const std::vector<GlyphInfo> &block : glyph_blocks )
+        bytes += block.size() * sizeof( GlyphInfo );
 
-        glyphs.emplace( ( char )id, glyph );
-    }
+    for( const std::vector<uint8_t> &page : pages )
+        bytes += page.size();
 
-    input.close();
+    // Single channel textures
+    bytes += dynamic_atlas ? atlas.get_memory_size() : (uint64_t)resolution * resolution;
+    return bytes;
 }
@@ -2,8 +2,9 @@
 #define FONTINFO_H
 
 #include <string>
-#include <map>
+#include <vector>
 #include "../graphics/Texture.h"
+#include "GlyphAtlas.h"
 #include "definitions.h"
 
 
@@ -16,24 +17,71 @@ struct GlyphInfo{
     int xoffset;
     int yoffset;
     int xadvance;
+    uint32_t codepoint = 0;
+    uint32_t page = 0;
+    bool defined = false;
 };
 
+/*
+ * A BMFont text format font.
+ * Fonts with one page are drawn from the page texture, fonts with more pages, or loaded with dynamic or sdf_spread set,
+ * keep their pages in memory and copy the glyphs that are drawn into a glyph atlas.
+ * Distance field glyphs are generated from the page when first drawn, the text shader draws their edges, outline and shadow.
+ */
 class FontInfo {
 public:
-    
+
     Texture fontTexture;
     float resolution = 256;
     int lineHeight = 0;
     int glyphCount;
-    std::map<char,GlyphInfo> glyphs;
-    
+
+    // Set before loading to draw through the glyph atlas even with one page
+    bool dynamic = false;
+    uint32_t atlas_size = 1024;
+
+    // Set before loading to draw glyphs from distance fields reaching this many texels past their edges, uses the glyph atlas
+    uint32_t sdf_spread = 0;
+
     FontInfo();
     FontInfo(FontInfo const &a);
     ~FontInfo();
-    
+
     void load(std::string filename);
+
+    // The glyph of a codepoint, or of '?' when the font does not have it
+    const GlyphInfo &get_glyph(uint32_t codepoint) const;
+
+    // Texture coordinates of a glyph as u1, v1, u2, v2, false when it can not be drawn this frame
+    bool get_uv(const GlyphInfo &glyph, vec4 uv);
+
+    // The texture glyphs are drawn from
+    Texture *get_texture();
+
+    // Starts a frame of the glyph atlas, glyphs drawn after this are kept until the next frame
+    void begin_frame();
+    inline const GlyphAtlas &get_atlas() const{ return atlas; }
+    inline bool is_dynamic() const{ return dynamic_atlas; }
+
+    // Texels glyph quads extend past the glyph, the distance field spread or 0 for bitmap glyphs
+    inline uint32_t get_margin() const{ return margin; }
+
+    // Bytes used by the glyph table, the pages kept in memory and the texture
+    uint64_t get_memory_size() const;
     void free_texture();
 
+private:
+
+    // Glyphs in blocks of 256 codepoints, blocks without glyphs are left empty
+    std::vector<std::vector<GlyphInfo>> glyph_blocks;
+
+    // Single channel pages of a dynamic font
+    std::vector<std::vector<uint8_t>> pages;
+    uint32_t page_width = 0;
+    uint32_t margin = 0;
+    bool dynamic_atlas = false;
+    GlyphAtlas atlas;
+
 };
 
 #endif /* FONTINFO_H */
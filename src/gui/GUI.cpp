@@ -1,37 +1,76 @@
 #include "GUI.h"
 #include "../graphics/Shader.h"
+#include "../graphics/FBO.h"
 
 #include <iostream>
+#include <cstring>
+#include <cmath>
 
 namespace GUI {
     FontInfo font;
     Shader text_shader, background_shader;
-    VAO quad_vao;
+    GUIBatch batch;
     float ratio = 2.0f, bevel = 30.0f, volume = .8, max_text_size = .3;
+    float text_outline = 0, text_shadow_opacity = 0, text_shadow_softness = 1;
+    vec2 text_shadow_offset = {1.5f, 1.5f};
+    float reveal_rate = 40, reveal_sentence_pause = .3, reveal_clause_pause = .12;
+    bool cached = true;
+    uint64_t frames_drawn = 0, frames_idle = 0;
     ElementSet *selection = nullptr;
     SoundBuffer sound_select, sound_hover;
     SoundSource sound_source;
     ElementColor colors;
+
+    // The selected set drawn with premultiplied alpha, and what it was drawn with
+    FBO cache_fbo;
+    Texture cache_texture;
+    Shader composite_shader;
+    VAO composite_vao;
+    ElementSet *cache_set = nullptr;
+    ElementColor cache_colors;
+    float cache_settings[8];
+    bool cache_valid = false;
 }
 
 void GUI::init_assets() {
+    // Glyphs are drawn from distance fields so text stays sharp at any size
+    font.sdf_spread = 4;
     font.load( "liberation-mono" );
     text_shader.load( "text2D" );
     background_shader.load( "gui_simple" );
-    float pos[8] = {0, 0, 1, 0, 1, 1, 0, 1};
-    float uv[8] = {0, 0, 1, 0, 1, 1, 0, 1};
-    quad_vao.load_attrb_float( Attribute::ATTRB_POS, 0, 0, 2, 8, pos );
-    quad_vao.load_attrb_float( Attribute::ATTRB_UV, 0, 0, 2, 8, uv );
+    batch.set_layer( GUIBatch::LAYER_BACKGROUND, &background_shader, nullptr );
+    batch.set_layer( GUIBatch::LAYER_TEXT, &text_shader, font.get_texture(), set_text_uniforms );
+
+    // The cache covers the screen as one strip in clip space, so no camera is needed
+    float corners[8] = {-1, -1, 1, -1, -1, 1, 1, 1};
+    composite_shader.load( "gui_composite" );
+    composite_vao.load_attrb_float( ATTRB_POS, 0, 0, 2, 8, corners );
+
     sound_select.load( "element_click" );
     sound_hover.load( "element_hover" );
     sound_source.allocate();
 }
 
+// Outline and shadow of the text shader, the spread is 0 for bitmap fonts
+void GUI::set_text_uniforms() {
+    Shader::uniformFloat( UNIFORM_FACTOR, font.get_margin() );
+    Shader::uniformVec4f( UNIFORM_COLOR, vec4{colors.text_outline[0], colors.text_outline[1], colors.text_outline[2], 1} );
+    Shader::uniformVec4f( UNIFORM_COLOR2, vec4{colors.text_shadow[0], colors.text_shadow[1], colors.text_shadow[2], text_shadow_opacity} );
+    Shader::uniformVec4f( UNIFORM_TEXT_EFFECTS, vec4{text_outline, text_shadow_offset[0], text_shadow_offset[1], text_shadow_softness} );
+}
+
 void GUI::close_assets() {
     text_shader.free();
     background_shader.free();
-    quad_vao.free();
+    batch.free();
     font.free_texture();
+    cache_texture.free();
+    cache_fbo.free();
+    composite_shader.free();
+    composite_vao.free();
+
+    if( frames_drawn )
+        printf( "GUI: %.1f%% of %llu frames without GUI work\n", 100.0 * frames_idle / frames_drawn, ( unsigned long long )frames_drawn );
     sound_select.free();
     sound_hover.free();
     sound_source.free();
@@ -45,13 +84,113 @@ void GUI::deselect_set() {
     selection = nullptr;
 }
 
+void GUI::invalidate() {
+    cache_valid = false;
+}
+
+// Draws the cache over the bound framebuffer, its colors are premultiplied
+static void composite_cache() {
+    Shader::bind( GUI::composite_shader );
+    glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+    GUI::cache_texture.bind( 0 );
+
+    GUI::composite_vao.bind();
+    glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+
+    Shader::unbind();
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+}
+
+/*
+ * The set is drawn into a texture the size of the viewport, which is then drawn over the frame.
+ * Only the region of elements that changed since the last frame is cleared and drawn again,
+ * frames where nothing changed only draw the texture.
+ */
 void GUI::draw() {
-    if( selection ) {
+    ++frames_drawn;
+
+    if( !selection ) {
+        ++frames_idle;
+        return;
+    }
+
+    if( !cached ) {
         selection->draw();
+        return;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv( GL_VIEWPORT, viewport );
+
+    // The cache follows the size of the viewport
+    if( !cache_fbo.is_allocated() || cache_fbo.get_width() != ( uint32_t )viewport[2] || cache_fbo.get_height() != ( uint32_t )viewport[3] ) {
+        cache_texture.free();
+        cache_fbo.free();
+        cache_fbo.allocate( viewport[2], viewport[3] );
+        cache_texture.from_FBO( cache_fbo, 0, GL_NEAREST );
+        cache_valid = false;
+    }
+
+    // Another set, theme or setting changes every element
+    float settings[8] = {ratio, bevel, max_text_size, text_outline, text_shadow_opacity, text_shadow_softness, text_shadow_offset[0], text_shadow_offset[1]};
+    if( cache_set != selection || memcmp( &cache_colors, &colors, sizeof( ElementColor ) ) != 0 || memcmp( cache_settings, settings, sizeof( settings ) ) != 0 ) {
+        cache_set = selection;
+        cache_colors = colors;
+        memcpy( cache_settings, settings, sizeof( settings ) );
+        cache_valid = false;
     }
+
+    bool redraw_all = !cache_valid;
+    vec4 region;
+
+    if( !selection->find_dirty_region( region, redraw_all ) ) {
+        ++frames_idle;
+        composite_cache();
+        return;
+    }
+
+    cache_fbo.bind();
+
+    // Only the changed region is cleared, padded by a pixel for the edges of the elements
+    if( !redraw_all ) {
+        float sx = viewport[2] / ratio, sy = viewport[3];
+        GLint x1 = floor( region[0] * sx ) - 1, y1 = floor( region[1] * sy ) - 1;
+        GLint x2 = ceil( region[2] * sx ) + 1, y2 = ceil( region[3] * sy ) + 1;
+        glEnable( GL_SCISSOR_TEST );
+        glScissor( x1, y1, x2 - x1, y2 - y1 );
+    }
+
+    glClearColor( 0, 0, 0, 0 );
+    glClear( GL_COLOR_BUFFER_BIT );
+
+    // Colors blend as usual while alpha accumulates, leaving premultiplied colors in the texture
+    glBlendFuncSeparate( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+    selection->draw( region );
+    glDisable( GL_SCISSOR_TEST );
+
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    glViewport( viewport[0], viewport[1], viewport[2], viewport[3] );
+
+    // Glyphs left out because the atlas was full are drawn on the next frame
+    cache_valid = font.get_atlas().frame_overflows == 0;
+
+    composite_cache();
 }
 
-void GUI::char_input( char c ) {
+void GUI::update( float time ) {
+    if( selection )
+        selection->update( time );
+}
+
+bool GUI::skip_reveal() {
+    return selection && selection->skip_reveal();
+}
+
+bool GUI::is_revealing() {
+    return selection && selection->is_revealing();
+}
+
+void GUI::char_input( uint32_t c ) {
     if( selection )
         selection->char_input( c );
 }
@@ -66,6 +205,11 @@ void GUI::select( float x, float y ) {
         selection->select( x, y );
 }
 
+void GUI::scroll( float x, float y, float amount ) {
+    if( selection )
+        selection->scroll( x, y, amount );
+}
+
 void GUI::key_input( uint32_t key_value, uint8_t modifiers_value ) {
     if( selection )
         selection->key_input( key_value, modifiers_value );
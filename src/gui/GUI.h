@@ -9,6 +9,7 @@
 #include <cglm/vec3.h>
 #include "Element.h"
 #include "ElementSet.h"
+#include "GUIBatch.h"
 
 
 // Create a single namespace for the GUI interface
@@ -16,21 +17,44 @@
 namespace GUI {
     extern FontInfo font;
     extern Shader text_shader, background_shader;
-    extern VAO quad_vao;
+    extern GUIBatch batch;
     extern float ratio, bevel, volume, max_text_size;
+
+    // Effects of distance field text, sizes are in texels of the font, the shadow is hidden at 0 opacity
+    extern float text_outline, text_shadow_opacity, text_shadow_softness;
+    extern vec2 text_shadow_offset;
+
+    // Glyphs revealed per second unless an element sets its own, and the pauses after punctuation in seconds
+    extern float reveal_rate, reveal_sentence_pause, reveal_clause_pause;
+
+    // Whether draw goes through the cache, and the frames drawn and frames that only composited the cache
+    extern bool cached;
+    extern uint64_t frames_drawn, frames_idle;
+
     extern ElementSet *selection;
     extern SoundSource sound_source;
     extern SoundBuffer sound_select;
     extern ElementColor colors;
 
     void init_assets();
+    void set_text_uniforms();
     void close_assets();
     void select_set( ElementSet *es );
     void deselect_set();
+
+    // Draws the selected set through a cached texture, only elements that changed are drawn again
     void draw();
-    void char_input( char c );
+
+    // Draws everything again on the next draw, for changes the set can not see such as a new font
+    void invalidate();
+
+    void update( float time );
+    bool skip_reveal();
+    bool is_revealing();
+    void char_input( uint32_t c );
     void highlight(float x, float y);
     void select( float x, float y );
+    void scroll( float x, float y, float amount );
     void key_input( uint32_t key_value, uint8_t modifiers_value );
     void play_sound_select();
     void play_sound_deselect();
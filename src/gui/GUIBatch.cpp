@@ -0,0 +1,129 @@
+#include "GUIBatch.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// Vertex attributes of the batch, see GUIVertex
+static const AttributeFormat *vertex_formats() {
+    static AttributeFormat formats[Attribute::NUM_ATTRBS];
+    static bool initialized = false;
+
+    if( !initialized ) {
+        formats[Attribute::ATTRB_POS] = {GL_FLOAT, 2, offsetof( GUIVertex, x ), false, false};
+        formats[Attribute::ATTRB_UV] = {GL_FLOAT, 2, offsetof( GUIVertex, u ), false, false};
+        formats[Attribute::ATTRB_COL] = {GL_UNSIGNED_BYTE, 4, offsetof( GUIVertex, color ), true, false};
+        formats[Attribute::ATTRB_WEIGHTS] = {GL_UNSIGNED_BYTE, 4, offsetof( GUIVertex, color2 ), true, false};
+        formats[Attribute::ATTRB_NORM] = {GL_FLOAT, 4, offsetof( GUIVertex, params ), false, false};
+        initialized = true;
+    }
+
+    return formats;
+}
+
+void GUIBatch::set_layer( Layer layer, Shader *shader, Texture *texture, void ( *set_uniforms )() ) {
+    layers[layer].shader = shader;
+    layers[layer].texture = texture;
+    layers[layer].set_uniforms = set_uniforms;
+}
+
+void GUIBatch::clear() {
+    build_start = std::chrono::steady_clock::now();
+
+    for( LayerData &l : layers )
+        l.vertices.clear();
+}
+
+void GUIBatch::add_quad( Layer layer, float x1, float y1, float x2, float y2, float u1, float v1, float u2, float v2,
+                         uint32_t color, uint32_t color2, const vec4 &params ) {
+    std::vector<GUIVertex> &v = layers[layer].vertices;
+    GUIVertex corner = {x1, y1, u1, v1, color, color2, {params[0], params[1], params[2], params[3]}};
+
+    // Bottom left, bottom right, top right, top left
+    v.push_back( corner );
+    corner.x = x2, corner.u = u2;
+    v.push_back( corner );
+    corner.y = y2, corner.v = v2;
+    v.push_back( corner );
+    corner.x = x1, corner.u = u1;
+    v.push_back( corner );
+}
+
+/*
+ * Every layer is uploaded together, then drawn as triangles from its range of the index buffer.
+ */
+void GUIBatch::draw( const mat4 &camera ) {
+    draw_calls = 0;
+    quad_count = 0;
+
+    staging.clear();
+    for( LayerData &l : layers )
+        staging.insert( staging.end(), l.vertices.begin(), l.vertices.end() );
+
+    quad_count = staging.size() / 4;
+
+    if( quad_count == 0 ) {
+        cpu_ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - build_start ).count();
+        return;
+    }
+
+    vao.load_interleaved( 0, staging.size(), sizeof( GUIVertex ), vertex_formats(), staging.data() );
+
+    // Two triangles per quad, written for the largest count so far
+    if( quad_count > index_capacity ) {
+        index_capacity = std::max( quad_count, index_capacity * 2 );
+        std::vector<GLuint> indices( index_capacity * 6 );
+
+        for( uint32_t q = 0; q < index_capacity; ++q ) {
+            GLuint v = q * 4;
+            GLuint quad[6] = {v, v + 1, v + 2, v, v + 2, v + 3};
+            std::copy( quad, quad + 6, &indices[q * 6] );
+        }
+
+        vao.load_index( indices.size(), indices.data() );
+    }
+
+    vao.bind();
+    uint32_t first = 0;
+
+    for( LayerData &l : layers ) {
+        uint32_t count = l.vertices.size() / 4;
+
+        if( count && l.shader ) {
+            Shader::bind( *l.shader );
+            Shader::uniformMat4f( UNIFORM_CAMERA, camera );
+
+            if( l.set_uniforms )
+                l.set_uniforms();
+
+            if( l.texture )
+                l.texture->bind( 0 );
+
+            glDrawElements( GL_TRIANGLES, count * 6, GL_UNSIGNED_INT, ( void * )( uintptr_t )( first * 6 * sizeof( GLuint ) ) );
+            ++draw_calls;
+        }
+
+        first += count;
+    }
+
+    Shader::unbind();
+    cpu_ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - build_start ).count();
+}
+
+void GUIBatch::free() {
+    vao.free();
+    index_capacity = 0;
+}
+
+uint32_t GUIBatch::pack_color( const vec3 rgb, float a ) {
+    uint8_t c[4];
+
+    for( uint32_t i = 0; i < 3; ++i )
+        c[i] = ( uint8_t )( glm_clamp( rgb[i], 0, 1 ) * 255 + 0.5f );
+
+    c[3] = ( uint8_t )( glm_clamp( a, 0, 1 ) * 255 + 0.5f );
+
+    // Bytes in memory order, the same as the colors of text
+    uint32_t packed;
+    memcpy( &packed, c, 4 );
+    return packed;
+}
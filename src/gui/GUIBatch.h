@@ -0,0 +1,79 @@
+#ifndef GUIBATCH_H
+#define GUIBATCH_H
+
+#include <vector>
+#include <chrono>
+#include <inttypes.h>
+#include <cglm/cglm.h>
+#include "../graphics/VAO.h"
+#include "../graphics/Texture.h"
+
+/*
+ * A vertex of the batched GUI, element backgrounds and glyphs share the format.
+ * Colors are RGBA8, params hold the width, height and bevel of a background,
+ * or the reveal index of a glyph and the number of glyphs revealed.
+ * The shaders read params from the normal attribute and color2 from the weights attribute.
+ */
+struct GUIVertex {
+    float x, y;
+    float u, v;
+    uint32_t color;
+    uint32_t color2;
+    float params[4];
+};
+
+/*
+ * Collects the quads of the GUI into layers each frame, then uploads them to one streaming buffer
+ * and draws each layer with a single call. Layers are drawn in order, each with its own shader and texture.
+ */
+class GUIBatch {
+    public:
+
+        enum Layer : uint8_t {
+            LAYER_BACKGROUND,
+            LAYER_TEXT,
+            NUM_LAYERS
+        };
+
+    private:
+
+        struct LayerData {
+            std::vector<GUIVertex> vertices;
+            Shader *shader = nullptr;
+            Texture *texture = nullptr;
+            void ( *set_uniforms )() = nullptr;
+        };
+
+        LayerData layers[NUM_LAYERS];
+        VAO vao;
+
+        // Quads the index buffer holds, indices only depend on the quad count so they are only written on growth
+        uint32_t index_capacity = 0;
+        std::vector<GUIVertex> staging;
+        std::chrono::steady_clock::time_point build_start;
+
+    public:
+
+        // Draw calls and quads of the last draw, and the CPU time spent building and submitting it
+        uint32_t draw_calls = 0;
+        uint32_t quad_count = 0;
+        double cpu_ms = 0;
+
+        // Set uniforms is called after the layer's shader is bound, for uniforms other than the camera
+        void set_layer( Layer layer, Shader *shader, Texture *texture, void ( *set_uniforms )() = nullptr );
+
+        // Starts a new frame, the CPU time is measured from here to the end of draw
+        void clear();
+
+        // Adds a quad from its bottom left and top right corners, params are the same at each vertex
+        void add_quad( Layer layer, float x1, float y1, float x2, float y2, float u1, float v1, float u2, float v2,
+                       uint32_t color, uint32_t color2, const vec4 &params );
+
+        void draw( const mat4 &camera );
+        void free();
+
+        // Packs a color into RGBA8
+        static uint32_t pack_color( const vec3 rgb, float a = 1 );
+};
+
+#endif // GUIBATCH_H
@@ -0,0 +1,225 @@
+#include "GlyphAtlas.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+// Squared distance of texels that are not seeds, large enough to never be nearest
+static const float FAR = 1e20f;
+
+void GlyphAtlas::allocate( uint32_t size, uint32_t max_glyph_width, uint32_t max_glyph_height, uint32_t margin ) {
+    free();
+
+    this->size = size;
+    this->margin = margin;
+    cell_width = std::min( max_glyph_width + 2 * ( margin + 1 ), size );
+    cell_height = std::min( max_glyph_height + 2 * ( margin + 1 ), size );
+    columns = size / cell_width;
+    slots.resize( columns * ( size / cell_height ) );
+    staging.resize( cell_width * cell_height );
+
+    if( margin ) {
+        uint32_t longest = std::max( cell_width, cell_height );
+        inside.resize( staging.size() );
+        outside.resize( staging.size() );
+        line.resize( longest );
+        line_result.resize( longest );
+        parabola_center.resize( longest );
+        parabola_start.resize( longest + 1 );
+    }
+
+    // Every cell starts free at the back of the list
+    for( uint32_t i = 0; i < slots.size(); ++i )
+        push_front( i );
+
+    texture.allocate_empty( size, size, GL_RED, GL_LINEAR );
+}
+
+void GlyphAtlas::free() {
+    texture.free();
+    slots.clear();
+    resident.clear();
+    head = tail = UINT32_MAX;
+    total_uploads = evictions = 0;
+}
+
+void GlyphAtlas::begin_frame() {
+    ++frame;
+    frame_uploads = 0;
+    frame_upload_bytes = 0;
+    frame_overflows = 0;
+}
+
+void GlyphAtlas::unlink( uint32_t slot ) {
+    Slot &s = slots[slot];
+
+    if( s.prev != UINT32_MAX )
+        slots[s.prev].next = s.next;
+    else
+        head = s.next;
+
+    if( s.next != UINT32_MAX )
+        slots[s.next].prev = s.prev;
+    else
+        tail = s.prev;
+
+    s.prev = s.next = UINT32_MAX;
+}
+
+void GlyphAtlas::push_front( uint32_t slot ) {
+    Slot &s = slots[slot];
+    s.prev = UINT32_MAX;
+    s.next = head;
+
+    if( head != UINT32_MAX )
+        slots[head].prev = slot;
+    else
+        tail = slot;
+
+    head = slot;
+}
+
+bool GlyphAtlas::acquire( uint32_t codepoint, const uint8_t *source, uint32_t source_width, uint32_t x, uint32_t y, uint32_t width, uint32_t height, vec4 uv ) {
+    if( slots.empty() )
+        return false;
+
+    uint32_t pad = margin + 1;
+    width = std::min( width, cell_width - 2 * pad );
+    height = std::min( height, cell_height - 2 * pad );
+
+    uint32_t slot;
+    auto found = resident.find( codepoint );
+
+    if( found != resident.end() ) {
+        slot = found->second;
+    }
+    else {
+        // The least recently drawn cell is replaced, unless it was drawn this frame
+        slot = tail;
+        Slot &s = slots[slot];
+
+        if( s.last_used == frame ) {
+            ++frame_overflows;
+            return false;
+        }
+
+        if( s.codepoint != UINT32_MAX ) {
+            resident.erase( s.codepoint );
+            ++evictions;
+        }
+
+        s.codepoint = codepoint;
+        resident[codepoint] = slot;
+
+        // Copy the glyph into the middle of a cleared cell
+        std::fill( staging.begin(), staging.end(), 0 );
+        for( uint32_t row = 0; row < height && source; ++row )
+            memcpy( &staging[( row + pad ) * cell_width + pad], source + ( y + row ) * source_width + x, width );
+
+        if( margin )
+            distance_field();
+
+        texture.upload_region( slot % columns * cell_width, slot / columns * cell_height, cell_width, cell_height, GL_RED, staging.data() );
+        ++frame_uploads;
+        ++total_uploads;
+        frame_upload_bytes += staging.size();
+    }
+
+    slots[slot].last_used = frame;
+    unlink( slot );
+    push_front( slot );
+
+    // The margin is drawn as well, the padding outside it keeps filtering from reaching the next cell
+    float px = slot % columns * cell_width + 1;
+    float py = slot / columns * cell_height + 1;
+    uv[0] = px / size;
+    uv[1] = ( py + height + 2 * margin ) / size;
+    uv[2] = ( px + width + 2 * margin ) / size;
+    uv[3] = py / size;
+    return true;
+}
+
+/*
+ * Squared distance from each texel of the cell to the nearest seed, seeds are texels of 0 in the grid.
+ * The exact transform of Felzenszwalb and Huttenlocher, run on the columns and then the rows.
+ * Each line is the lower envelope of parabolas rooted at its texels.
+ */
+void GlyphAtlas::distance_transform( std::vector<float> &grid ) {
+    auto transform_line = [&]( uint32_t n ) {
+        float *f = line.data(), *z = parabola_start.data();
+        int *v = parabola_center.data();
+        int k = 0;
+        v[0] = 0;
+        z[0] = -FAR;
+        z[1] = FAR;
+
+        // Intersection of the parabolas rooted at q and at p
+        auto intersection = [&]( int q, int p ) {
+            return ( ( f[q] + q * q ) - ( f[p] + p * p ) ) / ( 2 * q - 2 * p );
+        };
+
+        for( int q = 1; q < ( int )n; ++q ) {
+            // Parabolas that would start after the one at q are hidden by it
+            float s = intersection( q, v[k] );
+            while( s <= z[k] ) {
+                --k;
+                s = intersection( q, v[k] );
+            }
+
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = FAR;
+        }
+
+        k = 0;
+        for( int q = 0; q < ( int )n; ++q ) {
+            while( z[k + 1] < q )
+                ++k;
+            line_result[q] = ( q - v[k] ) * ( q - v[k] ) + f[v[k]];
+        }
+    };
+
+    for( uint32_t x = 0; x < cell_width; ++x ) {
+        for( uint32_t y = 0; y < cell_height; ++y )
+            line[y] = grid[y * cell_width + x];
+        transform_line( cell_height );
+        for( uint32_t y = 0; y < cell_height; ++y )
+            grid[y * cell_width + x] = line_result[y];
+    }
+
+    for( uint32_t y = 0; y < cell_height; ++y ) {
+        std::copy( &grid[y * cell_width], &grid[y * cell_width] + cell_width, line.begin() );
+        transform_line( cell_width );
+        std::copy( line_result.begin(), line_result.begin() + cell_width, &grid[y * cell_width] );
+    }
+}
+
+/*
+ * Replaces the coverage in staging with the signed distance to the glyph edge.
+ * Texels at least half covered are inside, partly covered texels take their distance from the coverage.
+ * Distances are stored as .5 at the edge, rising inside, reaching 0 at margin texels outside.
+ */
+void GlyphAtlas::distance_field() {
+    for( uint32_t i = 0; i < staging.size(); ++i ) {
+        bool in = staging[i] >= 128;
+        inside[i] = in ? 0 : FAR;
+        outside[i] = in ? FAR : 0;
+    }
+
+    distance_transform( inside );
+    distance_transform( outside );
+
+    for( uint32_t i = 0; i < staging.size(); ++i ) {
+        float c = staging[i] / 255.0f;
+        float d;
+
+        if( c > 0 && c < 1 )
+            d = .5f - c;
+        else if( c >= .5f )
+            d = .5f - sqrtf( outside[i] );
+        else
+            d = sqrtf( inside[i] ) - .5f;
+
+        staging[i] = ( uint8_t )( std::clamp( .5f - d / ( 2 * margin ), 0.0f, 1.0f ) * 255 + .5f );
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <vector>
+#include <unordered_map>
+#include <inttypes.h>
+#include <cglm/cglm.h>
+#include "../graphics/Texture.h"
+
+/*
+ * A fixed size single channel texture divided into equal cells, glyphs are copied into cells the first time they are drawn.
+ * When every cell is taken the least recently drawn glyph is replaced, glyphs drawn this frame are never replaced.
+ * Fonts with many pages or large character sets only keep the glyphs on screen in GPU memory.
+ * With a margin, cells hold the signed distance field of the glyph instead of its coverage, reaching margin texels past the glyph.
+ */
+class GlyphAtlas {
+
+        // Cells form a list from most to least recently used
+        struct Slot {
+            uint32_t codepoint = UINT32_MAX;
+            uint64_t last_used = 0;
+            uint32_t prev = UINT32_MAX;
+            uint32_t next = UINT32_MAX;
+        };
+
+        Texture texture;
+        std::vector<Slot> slots;
+        std::unordered_map<uint32_t, uint32_t> resident;
+        uint32_t head = UINT32_MAX, tail = UINT32_MAX;
+        uint32_t size = 0, cell_width = 0, cell_height = 0, columns = 0, margin = 0;
+        uint64_t frame = 1;
+
+        // A cell with its padding, written in one upload so the replaced glyph does not bleed into the new one
+        std::vector<uint8_t> staging;
+
+        // Squared distances and the buffers of the distance transform
+        std::vector<float> inside, outside, line, line_result, parabola_start;
+        std::vector<int> parabola_center;
+
+        void distance_transform( std::vector<float> &grid );
+        void distance_field();
+
+        void unlink( uint32_t slot );
+        void push_front( uint32_t slot );
+
+    public:
+
+        // Glyphs and bytes copied to the texture this frame, and since allocation
+        uint32_t frame_uploads = 0;
+        uint64_t frame_upload_bytes = 0;
+        uint64_t total_uploads = 0;
+        uint64_t evictions = 0;
+
+        // Glyphs that could not be drawn this frame because every cell was already drawn this frame
+        uint32_t frame_overflows = 0;
+
+        // Creates the texture, cells fit the largest glyph with the margin and a pixel of padding on each side
+        void allocate( uint32_t size, uint32_t max_glyph_width, uint32_t max_glyph_height, uint32_t margin = 0 );
+        void free();
+
+        // Starts a new frame, glyphs drawn before it may be replaced
+        void begin_frame();
+
+        /*
+         * Finds the cell of a glyph, copying it from source when it is not resident.
+         * Source is the single channel page holding the glyph, width is the width of the page in pixels.
+         * Writes u1, v1, u2, v2 of the glyph and its margin as the text quads expect, false if no cell is free this frame.
+         */
+        bool acquire( uint32_t codepoint, const uint8_t *source, uint32_t source_width, uint32_t x, uint32_t y, uint32_t width, uint32_t height, vec4 uv );
+
+        inline Texture *get_texture(){ return &texture; }
+        inline uint32_t get_slot_count() const{ return slots.size(); }
+        inline uint32_t get_resident_count() const{ return resident.size(); }
+        inline uint64_t get_memory_size() const{ return (uint64_t)size * size; }
+};
+
+#endif // GLYPHATLAS_H
@@ -6,6 +6,33 @@ namespace Menu {
     MenuBase *active = nullptr;
     std::unordered_map<std::string, MenuBase> menu_map;
 
+    // Ids of element names, made on first use so ids can be given while other globals are constructed
+    static std::unordered_map<std::string, uint32_t> &element_ids(){
+        static std::unordered_map<std::string, uint32_t> ids;
+        return ids;
+    }
+
+    uint32_t element_id( const std::string &name ){
+        std::unordered_map<std::string, uint32_t> &ids = element_ids();
+        auto found = ids.find( name );
+        if( found != ids.end() )
+            return found->second;
+
+        uint32_t id = ids.size() + 1;
+        ids[name] = id;
+        return id;
+    }
+
+    uint32_t element_id( VNVariable &arg ){
+        return arg.element_id ? arg.element_id : element_id( arg.value_string() );
+    }
+
+    uint32_t find_element_id( const std::string &name ){
+        std::unordered_map<std::string, uint32_t> &ids = element_ids();
+        auto found = ids.find( name );
+        return found != ids.end() ? found->second : 0;
+    }
+
     void create( std::string menu_name){
         menu_map[menu_name] = MenuBase();
     }
@@ -72,8 +99,8 @@ void  MenuBase::update(){
 }
 
 // Extract the value of an element
-void MenuBase::get_value(std::string element_name, VNVariable& dest){
-    Element *&elem = element_map[element_name];
+void MenuBase::get_value(uint32_t id, VNVariable& dest){
+    Element *elem = get_element(id);
 
     // Leave the variable untouched if not found
     if(!elem)
@@ -82,25 +109,24 @@ void MenuBase::get_value(std::string element_name, VNVariable& dest){
     elem->get_vn_var(dest);
 }
 
+void MenuBase::remove_element(uint32_t id){
+    Element *elem = get_element(id);
+    if(!elem)
+        return;
 
-
-void MenuBase::remove_element(std::string name){
-    // The destructor should handle ownership
-    if(element_map["name"])
-        delete element_map["name"];
-    element_map["name"] = nullptr;
-    element_map.erase(name);
+    // Remove ownership before deletion
+    element_set.remove(elem);
+    delete elem;
+    elements[id] = nullptr;
 }
 
 void MenuBase::clear(){
     // Remove ownership before deletion
     element_set.remove_all();
 
-    // Remove pointers left in the map
-    for(auto &keypair : element_map){
-        if(keypair.second){
-            delete keypair.second;
-        }
+    for(Element *&elem : elements){
+        delete elem;
+        elem = nullptr;
     }
-    element_map.clear();
+    elements.clear();
 }
@@ -8,9 +8,26 @@
 #include "VNVariable.h"
 #include <memory>
 
+namespace Menu{
+    /*
+     * Element names are given ids the first time they are used, the same name has the same id in every menu.
+     * Literal names in scripts are resolved when compiled, so finding an element is an index instead of a hash.
+     * Ids start at 1, 0 is never an element.
+     */
+    uint32_t element_id( const std::string &name );
+
+    // The id of a compiled element argument, or of its name when it is read from a variable
+    uint32_t element_id( VNVariable &arg );
+
+    // The id of a name, 0 if the name was never used
+    uint32_t find_element_id( const std::string &name );
+};
+
 struct MenuBase{
     ElementSet element_set;
-    std::unordered_map<std::string, Element*> element_map;
+
+    // Elements by id, null for ids the menu does not have
+    std::vector<Element*> elements;
 
     MenuBase(){};
     virtual ~MenuBase(){};
@@ -19,30 +36,34 @@ struct MenuBase{
     void update();
 
     template<typename T>
-    void add_element(std::string name, T e){
+    void add_element(uint32_t id, T e){
         // Must be a type of Element
-        if( !std::is_base_of<Element, T>::value )
+        if( !std::is_base_of<Element, T>::value || id == 0 )
             return;
 
-        // Get the unique pointer reference
-        Element *&elem = element_map[name];
+        if( id >= elements.size() )
+            elements.resize( id + 1, nullptr );
 
+        // Replace an element with the same id
+        remove_element( id );
 
-        // If the unique ptr is not empty, delete it
-        if( elem ) {
-            // It is ok to call the destructor here since the element set is assured to exist
-            delete elem;
-        }
-
-        elem = new T(e);
+        elements[id] = new T(e);
 
         // Set ownership
-        element_set.add( elem );
+        element_set.add( elements[id] );
+    }
+
+    inline Element *get_element(uint32_t id){
+        return id < elements.size() ? elements[id] : nullptr;
+    }
+
+    inline Element *get_element(VNVariable &arg){
+        return get_element( arg.element_id ? arg.element_id : Menu::find_element_id( arg.value_string() ) );
     }
 
-    void remove_element(std::string name);
+    void remove_element(uint32_t id);
     void clear();
-    void get_value(std::string element_name, VNVariable& dest);
+    void get_value(uint32_t id, VNVariable& dest);
 };
 
 namespace Menu{
@@ -5,12 +5,10 @@
 #include <iostream>
 #include <cstring>
 #include <algorithm>
-#include <regex>
 
 using std::vector;
 
 Text::Text(){
-    vao = std::shared_ptr<VAO>(new VAO());
     needsGenerated = true;
 }
 
@@ -20,6 +18,7 @@ Text::~Text() {
 void Text::set_text(const std::string &text){
     this->text = text;
     needsGenerated = true;
+    ++revision;
     deselect();
 }
 
@@ -27,52 +26,148 @@ void Text::set_text(const char *text, uint32_t length){
     length = length == 0 ? strlen(text) : length;
     this->text.assign(text,length<strlen(text)?length:strlen(text));
     needsGenerated = true;
+    ++revision;
     deselect();
 }
 
+// Appending is laid out from where the last layout stopped
 void Text::append(char c){
     text.push_back(c);
     deselect();
-    needsGenerated = true;
 }
 
 void Text::append(const std::string &s){
     text.append(s);
     deselect();
-    needsGenerated = true;
 }
 
-void Text::overwrite(char c){
+void Text::overwrite(uint32_t codepoint){
     if(selStop - selStart >= 1)
         erase();
-    insert(c);
+    insert(codepoint);
+}
+
+// Writes a codepoint as UTF-8
+static string encode_utf8(uint32_t codepoint){
+    string bytes;
+    if(codepoint < 0x80)
+        bytes.push_back(codepoint);
+    else if(codepoint < 0x800){
+        bytes.push_back(0xC0 | codepoint >> 6);
+        bytes.push_back(0x80 | (codepoint & 0x3F));
+    }
+    else if(codepoint < 0x10000){
+        bytes.push_back(0xE0 | codepoint >> 12);
+        bytes.push_back(0x80 | (codepoint >> 6 & 0x3F));
+        bytes.push_back(0x80 | (codepoint & 0x3F));
+    }
+    else if(codepoint < 0x110000){
+        bytes.push_back(0xF0 | codepoint >> 18);
+        bytes.push_back(0x80 | (codepoint >> 12 & 0x3F));
+        bytes.push_back(0x80 | (codepoint >> 6 & 0x3F));
+        bytes.push_back(0x80 | (codepoint & 0x3F));
+    }
+    return bytes;
+}
+
+static inline bool is_continuation(char c){
+    return (c & 0xC0) == 0x80;
 }
 
-void Text::insert(char c){
-    text.insert(text.begin()+selStart,c);
-    selStart++;
+/*
+ * Reads the codepoint at i, length is set to the bytes it takes.
+ * Bytes that do not start a valid sequence read as U+FFFD one at a time.
+ * Length is 0 when the sequence is cut off by the end of the text.
+ */
+static uint32_t decode_utf8(const string &text, uint32_t i, uint32_t &length){
+    uint8_t c = text[i];
+    uint32_t codepoint, minimum;
+
+    if(c < 0x80){
+        length = 1;
+        return c;
+    }
+    else if((c & 0xE0) == 0xC0)
+        length = 2, codepoint = c & 0x1F, minimum = 0x80;
+    else if((c & 0xF0) == 0xE0)
+        length = 3, codepoint = c & 0x0F, minimum = 0x800;
+    else if((c & 0xF8) == 0xF0)
+        length = 4, codepoint = c & 0x07, minimum = 0x10000;
+    else{
+        length = 1;
+        return 0xFFFD;
+    }
+
+    for(uint32_t k = 1; k < length; ++k){
+        if(i + k >= text.size()){
+            length = 0;
+            return 0;
+        }
+        if(!is_continuation(text[i + k])){
+            length = 1;
+            return 0xFFFD;
+        }
+        codepoint = codepoint << 6 | (text[i + k] & 0x3F);
+    }
+
+    // Overlong encodings and surrogates are invalid
+    if(codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint < 0xE000)){
+        length = 1;
+        return 0xFFFD;
+    }
+
+    return codepoint;
+}
+
+// Moves a position by a number of codepoints, stopping at either end of the text
+static int32_t step_codepoints(const string &text, int32_t position, int32_t amount){
+    position = std::clamp(position, 0, (int32_t)text.size());
+
+    for(; amount > 0 && position < (int32_t)text.size(); --amount){
+        ++position;
+        while(position < (int32_t)text.size() && is_continuation(text[position]))
+            ++position;
+    }
+
+    for(; amount < 0 && position > 0; ++amount){
+        --position;
+        while(position > 0 && is_continuation(text[position]))
+            --position;
+    }
+
+    return position;
+}
+
+void Text::insert(uint32_t codepoint){
+    string bytes = encode_utf8(codepoint);
+    text.insert(selStart, bytes);
+    selStart += bytes.size();
     selStop=selStart;
     needsGenerated = true;
+    ++revision;
 }
 
 void Text::pop(){
     if(!text.empty())
-    text.pop_back();
+        text.erase(step_codepoints(text, text.size(), -1));
 
     deselect();
     needsGenerated = true;
+    ++revision;
 }
 
 void Text::erase(){
     if(selStart == selStop && selStart > 0){
-        text.erase(selStart-1,1);
-        selStart--;
+        int32_t previous = step_codepoints(text, selStart, -1);
+        text.erase(previous, selStart - previous);
+        selStart = previous;
         selStop = selStart;
     }
     else
         text.erase(selStart,selStop - selStart);
     selStop = selStart;
     needsGenerated = true;
+    ++revision;
 }
 
 void Text::set_cursor(int32_t position){
@@ -80,46 +175,38 @@ void Text::set_cursor(int32_t position){
         return;
     selStart = position;
     selStop = position;
-    needsGenerated = true;
+    needsSelection = true;
+    ++revision;
 }
 
 void Text::move_cursor(int32_t amount){
-    if(selStart + amount < 0)
-        selStart = 0;
-    else if( selStart + amount > text.size())
-        selStart = text.size();
-    else
-        selStart += amount;
+    selStart = step_codepoints(text, selStart, amount);
     selStop = selStart;
-    needsGenerated = true;
+    needsSelection = true;
+    ++revision;
 }
 
 void Text::select_more(int32_t amount){
-    if(amount < 0){
-        if(selStart + amount > 0)
-            selStart +=amount;
-        else
-            selStart = 0;
-    }
-    else{
-        if(selStop + amount < text.size())
-            selStop += amount;
-        else
-            selStop = text.size();
-    }
-    needsGenerated = true;
+    if(amount < 0)
+        selStart = step_codepoints(text, selStart, amount);
+    else
+        selStop = step_codepoints(text, selStop, amount);
+    needsSelection = true;
+    ++revision;
 }
 
 void Text::select_all(){
     selStart = 0;
     selStop = text.size();
-    needsGenerated = true;
+    needsSelection = true;
+    ++revision;
 }
 
 void Text::deselect(){
     selStart = text.size();
     selStop = text.size();
-    needsGenerated = true;
+    needsSelection = true;
+    ++revision;
 }
 
 
@@ -127,206 +214,195 @@ std::string const& Text::get_text(){
     return text;
 }
 
-std::regex color_regex = std::regex(R"((#[0-9a-fA-F]{6})(.*$))");
+static inline int hex_digit(char c){
+    if(c >= '0' && c <= '9')
+        return c - '0';
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
 
-void Text::generate(FontInfo &font){
-    if(!needsGenerated)
-        return;
+// Reads the color of a #RRGGBB code at i, colors are stored 4 8-bit channels in memory order, alpha is the mix amount
+static bool read_color_code(const string &text, uint32_t i, uint32_t &color){
+    if(i + 7 > text.size())
+        return false;
+
+    uint8_t buffer[4];
+    for(uint32_t c = 0; c < 3; ++c){
+        int high = hex_digit(text[i + 1 + c * 2]);
+        int low = hex_digit(text[i + 2 + c * 2]);
+        if(high < 0 || low < 0)
+            return false;
+        buffer[c] = high * 16 + low;
+    }
+    buffer[3] = 0x7f;
 
-    vector<float> pos;
-    vector<float> uv;
-    vector<uint32_t> color;
-    vector<uint32_t> id;
-    
-    width = 0;
-    height = 0;
-    
-    int
-    xoffset = 0,
-    yoffset = 0;
-    char c;
-    bool isSelected;
-    
-    float x1,y1,x2,y2, u1,v1,u2,v2;
-    // The opacity is set as 50%, but the shader may change that
-    uint32_t text_color = 0x0000007F;
-    
-    GlyphInfo g;
-    vertexCount = 0;
-    height = ( font.lineHeight ) / font.resolution;
+    memcpy(&color, buffer, 4);
+    return true;
+}
+
+// Quad of a glyph with its pen at x, y
+static TextGlyph place_glyph(const FontInfo &font, const GlyphInfo &glyph, int x, int y, uint32_t color, uint32_t index){
+    TextGlyph q;
+    float m = font.get_margin();
+    q.x1 = ( glyph.xoffset + x - m ) / font.resolution;
+    q.y1 = (-glyph.yoffset - glyph.height - y - m ) / font.resolution;
+    q.x2 = ( glyph.xoffset + x + glyph.width + m ) / font.resolution;
+    q.y2 = (-glyph.yoffset - y + m ) / font.resolution;
+
+    q.codepoint = glyph.codepoint;
+    q.color = color;
+    q.index = index;
+    q.selected = false;
+    return q;
+}
+
+void Text::generate(FontInfo &font){
 
     // x = approx. number of splits
     // (w/x)/(h*x) = ratio
     // w/(x*x*h) = ratio
     // w/ratio = x^2 * h
     // x = +sqrt(w/ratio/h)
-    {
-        float w = text.size()*spacing;
-        float h = font.lineHeight;
-        line_wrap = w/floor(sqrt(w/ideal_ratio/h));
+    float w = text.size()*spacing;
+    float h = font.lineHeight;
+    uint32_t lines = floor(sqrt(w/ideal_ratio/h));
+
+    // Appends continue the last layout unless the wrap width would change the lines already placed
+    bool append_only = !needsGenerated && layout.position <= text.size() && lines == wrap_lines;
+
+    if(append_only && layout.position == text.size()){
+        if(needsSelection)
+            update_selection(font);
+        return;
+    }
+
+    if(!append_only){
+        layout = LayoutState();
+        layout.height = font.lineHeight / font.resolution;
+        open_code = false;
+        wrap_lines = lines;
+        // The width only depends on the number of lines so appends keep wrapping the same way,
+        // w/lines is within [lines, lines + 2) times ratio*h for this count
+        line_wrap = lines ? ideal_ratio * h * (lines + 1) : 0;
     }
-    
-    for(uint32_t i = 0; i < text.length(); i++){
-        c = text.at(i);
+    else if(open_code){
+        layout = code_start;
+        open_code = false;
+    }
+
+    glyphs.resize(layout.index);
+    pens.resize(layout.index);
+    if(markedStart > layout.position)
+        markedStart = markedStop = 0;
+
+    LayoutState &l = layout;
+
+    for(; l.position < text.length(); l.position++){
+        uint32_t i = l.position;
+        char c = text[i];
 
         // Color code
         if( c == '#' ) {
             // Unset the text color using ##
             if(i<text.length()-1 && text[i+1] == '#'){
-                text_color = 0;
-                i += 1;
+                l.color = 0;
+                l.position += 1;
                 continue;
             }
-            if( std::regex_match( text.substr( i, text.size()-i ), color_regex ) ) {
-                // Colors are stored 4 8-bit channels RGB
-
-                // Little Endian stuff ???
-                uint8_t buffer[4];
-                buffer[0] = ( uint8_t )std::strtoul( text.substr( i + 1, 2 ).c_str(), NULL, 16 );
-                buffer[1] = ( uint8_t )std::strtoul( text.substr( i + 3, 2 ).c_str(), NULL, 16 );
-                buffer[2] = ( uint8_t )std::strtoul( text.substr( i + 5, 2 ).c_str(), NULL, 16 );
-                buffer[3] = 0x7f;
-                text_color = *( ( uint32_t * )buffer );
-                i += 6;
+            if( read_color_code(text, i, l.color) ) {
+                l.position += 6;
                 continue;
             }
+
+            // Too close to the end to tell whether this is a code
+            if(!open_code && i + 7 > text.size()){
+                code_start = l;
+                open_code = true;
+            }
         }
 
         if( c == '\n' ){
-            xoffset = 0;
-            yoffset += font.lineHeight;
+            l.xoffset = 0;
+            l.yoffset += font.lineHeight;
             continue;
         }
         if( line_wrap > 0 && (c == ' ' || c == '\t')){
-            if(xoffset > line_wrap){
-                xoffset = 0;
-                yoffset += font.lineHeight;
+            if(l.xoffset > line_wrap){
+                l.xoffset = 0;
+                l.yoffset += font.lineHeight;
                 continue;
             }
         }
-        try{
-            g = font.glyphs.at(c);
-        }
-        catch(std::out_of_range &error){
-            g = font.glyphs.at('?');
-        }
-        
-        isSelected = i >= selStart && i < selStop;
-
-        x1 = ( g.xoffset + xoffset ) / font.resolution;
-        y1 = (-g.yoffset - g.height -yoffset ) / font.resolution;
-        x2 = ( g.xoffset + xoffset + g.width ) / font.resolution;
-        y2 = (-g.yoffset - yoffset ) / font.resolution;
-        
-        u1 = g.x /  font.resolution;
-        v1 = ( g.y + g.height ) /  font.resolution;
-        u2 = ( g.x + g.width ) /  font.resolution;
-        v2 = ( g.y ) /  font.resolution;
-        
-        //tl
-        pos.push_back( x1 );
-        pos.push_back( y2 );
-        uv.push_back( u1 );
-        uv.push_back( v2 );
-        uv.push_back( 0 );
-        color.push_back(text_color);
-
-        //bl
-        pos.push_back( x1 );
-        pos.push_back( y1 );
-        uv.push_back( u1 );
-        uv.push_back( v1 );
-        uv.push_back( isSelected );
-        color.push_back(text_color);
-
-        //br
-        pos.push_back( x2 );
-        pos.push_back( y1 );
-        uv.push_back( u2 );
-        uv.push_back( v1 );
-        uv.push_back( isSelected );
-        color.push_back(text_color);
-
-        //tr
-        pos.push_back( x2 );
-        pos.push_back( y2 );
-        uv.push_back( u2 );
-        uv.push_back( v2 );
-        uv.push_back( 0 );
-        color.push_back(text_color);
-
-
-        // Draws a cursor (sorta excessive?)
-        if( i == selStart) {
-            g = font.glyphs.at('|');
-            x1 = ( xoffset ) / font.resolution;
-            y1 = ( -g.yoffset - g.height - yoffset ) / font.resolution;
-            x2 = ( xoffset + g.width ) / font.resolution;
-            y2 = ( -g.yoffset - yoffset ) / font.resolution;
-
-            u1 = g.x /  font.resolution;
-            v1 = ( g.y + g.height ) /  font.resolution;
-            u2 = ( g.x + g.width ) /  font.resolution;
-            v2 = ( g.y ) /  font.resolution;
-
-            //tl
-            pos.push_back( x1 );
-            pos.push_back( y2 );
-            uv.push_back( u1 );
-            uv.push_back( v2 );
-            uv.push_back( 0 );
-            color.push_back(0x00000000);
-
-            //bl
-            pos.push_back( x1 );
-            pos.push_back( y1 );
-            uv.push_back( u1 );
-            uv.push_back( v1 );
-            uv.push_back( 0 );
-            color.push_back(0x00000000);
-
-            //br
-            pos.push_back( x2 );
-            pos.push_back( y1 );
-            uv.push_back( u2 );
-            uv.push_back( v1 );
-            uv.push_back( 0 );
-            color.push_back(0x00000000);
-
-            //tr
-            pos.push_back( x2 );
-            pos.push_back( y2 );
-            uv.push_back( u2 );
-            uv.push_back( v2 );
-            uv.push_back( 0 );
-            color.push_back(0x00000000);
-            vertexCount += 4;
-        }
 
-        vertexCount += 4;
+        uint32_t length;
+        uint32_t codepoint = decode_utf8(text, i, length);
 
-        xoffset += spacing;
+        // A sequence cut off by the end of the text is laid out once the rest is appended
+        if(length == 0)
+            break;
+        l.position += length - 1;
+
+        glyphs.push_back(place_glyph(font, font.get_glyph(codepoint), l.xoffset, l.yoffset, l.color, l.index));
+        pens.push_back({i, l.xoffset, l.yoffset});
+
+        ++l.index;
+        l.xoffset += spacing;
 
         // Update the maximum width
-        if(width < xoffset/font.resolution)
-            width = xoffset/font.resolution;
-        height = ( yoffset + font.lineHeight ) / font.resolution;
+        if(l.width < l.xoffset/font.resolution)
+            l.width = l.xoffset/font.resolution;
+        l.height = ( l.yoffset + font.lineHeight ) / font.resolution;
     }
 
-    
-    vao->load_attrb_float(Attribute::ATTRB_POS, 0, 0, 2, pos.size(), pos.data());
-    vao->load_attrb_float(Attribute::ATTRB_UV, 0, 0, 3, uv.size(), uv.data());
-    vao->load_attrb_byte(Attribute::ATTRB_COL, 0, 0, 4, color.size()*4, true, color.data());
+    width = l.width;
+    height = l.height;
     needsGenerated = false;
+    update_selection(font);
+}
+
+// Marks the selected glyphs and places the cursor at the glyph of the selection start, without laying out the text
+// Pens are in order of position, so only the glyphs of the old and new selection are visited
+void Text::update_selection(FontInfo &font){
+    auto first_at = [&](uint32_t position){
+        return std::lower_bound(pens.begin(), pens.end(), position, [](const Pen &p, uint32_t v){ return p.position < v; }) - pens.begin();
+    };
+    auto mark = [&](uint32_t start, uint32_t stop, bool selected){
+        for(uint32_t k = first_at(start); k < pens.size() && pens[k].position < stop; ++k)
+            glyphs[k].selected = selected;
+    };
+
+    mark(markedStart, markedStop, false);
+    mark(selStart, selStop, true);
+    markedStart = selStart;
+    markedStop = selStop;
+
+    // Draws a cursor (sorta excessive?)
+    uint32_t k = first_at(selStart);
+    has_cursor = k < pens.size() && pens[k].position == (uint32_t)selStart;
+
+    if(has_cursor){
+        GlyphInfo g = font.get_glyph('|');
+        g.xoffset = 0;
+        cursor = place_glyph(font, g, pens[k].x, pens[k].y, 0x00000000, glyphs[k].index);
+    }
+
+    needsSelection = false;
 }
 
 bool Text::empty(){
-    return vao->vaoid==0;
+    return glyphs.empty();
 }
 
-void Text::bind(FontInfo &font){
+const std::vector<TextGlyph> &Text::get_glyphs(FontInfo &font){
     generate(font);
-    vao->bind();
+    return glyphs;
 }
 
-
+bool Text::get_cursor(TextGlyph &dest){
+    if(has_cursor)
+        dest = cursor;
+    return has_cursor;
+}
@@ -4,23 +4,78 @@
 #include <cglm/cglm.h>
 #include "FontInfo.h"
 #include <memory>
+#include <vector>
 #include "../graphics/VAO.h"
 
 
+/*
+ * A glyph quad of laid out text, positions are relative to the text origin before scaling.
+ * Color is RGBA8, alpha is how much of it replaces the color the text is drawn with.
+ */
+struct TextGlyph {
+    float x1, y1, x2, y2;
+
+    // Texture coordinates are looked up from the font when drawn, glyphs of a dynamic font move in its atlas
+    uint32_t codepoint;
+    uint32_t color;
+
+    // Order the glyph is revealed in, the cursor shares the index of the glyph it is placed at
+    uint32_t index;
+    bool selected;
+};
+
+/*
+ * UTF-8 text laid out into glyph quads.
+ * Appended text is laid out from where the last layout stopped, other edits lay out the whole text again.
+ * Moving the cursor or selection only updates the selected glyphs and the cursor.
+ */
 class Text {
     private:
         string text;
         int32_t selStart = 0;
         int32_t selStop = 0;
         void generate(FontInfo &font);
+        void update_selection(FontInfo &font);
 
-        // Use a shared pointer to allow copy/deletion of text
-        // copies of text will share the same VAO, the VAO will be deleted once no copies exist
-        std::shared_ptr<VAO> vao;
-        uint32_t vertexCount = 0;
+        // Glyphs are kept on the CPU and batched with the rest of the GUI when drawn
+        std::vector<TextGlyph> glyphs;
         float width, height;
         float line_wrap = 0, ideal_ratio = 1;
 
+        // Lines the wrap width was chosen for, appends keep the wrap width until the text would need more lines
+        uint32_t wrap_lines = 0;
+
+        // Where the last layout stopped, the index is also the number of glyphs placed
+        struct LayoutState {
+            uint32_t position = 0;
+            uint32_t index = 0;
+            int xoffset = 0;
+            int yoffset = 0;
+            uint32_t color = 0x0000007F;
+            float width = 0;
+            float height = 0;
+        } layout;
+
+        // A '#' near the end may become a color code once more text is appended, layout then resumes from before it
+        LayoutState code_start;
+        bool open_code = false;
+
+        // Position in the text and pen offset of each glyph, used to place the cursor
+        struct Pen {
+            uint32_t position;
+            int x, y;
+        };
+        std::vector<Pen> pens;
+
+        TextGlyph cursor;
+        bool has_cursor = false;
+        bool needsSelection = true;
+        uint32_t revision = 0;
+
+        // Range of positions the glyphs are marked selected for
+        uint32_t markedStart = 0;
+        uint32_t markedStop = 0;
+
     public:
 
         Text();
@@ -37,24 +92,32 @@ class Text {
         std::string const& get_text();
         void append(char c);
         void append(const std::string &s);
-        void overwrite(char c);
-        void insert(char c);
+        void overwrite(uint32_t codepoint);
+        void insert(uint32_t codepoint);
         void pop();
         void erase();
+        // Positions are byte offsets into the text, amounts are counted in codepoints
         void set_cursor(int32_t position);
         void move_cursor(int32_t amount);
         void select_more(int32_t amount);
         void select_all();
         void deselect();
         bool empty();
-        void bind(FontInfo &font);
-        inline void unbind(){vao->unbind();};
-        inline uint32_t get_vertex_count(){return vertexCount;};
+
+        // The laid out glyphs, generated again if the text changed
+        const std::vector<TextGlyph> &get_glyphs(FontInfo &font);
+
+        // The cursor quad of the last get_glyphs, false when there is no cursor
+        bool get_cursor(TextGlyph &dest);
+        inline uint32_t get_glyph_count(){return glyphs.size();};
         inline float get_width(){return width;};
         inline float get_height(){return height;};
         inline uint32_t get_selection_text(){return selStop-selStart;};
         inline uint32_t length(){return text.length();}
-        inline void set_ideal_ratio(float r){if(ideal_ratio != r){ideal_ratio = r; needsGenerated = true;}};
+        inline void set_ideal_ratio(float r){if(ideal_ratio != r){ideal_ratio = r; needsGenerated = true; ++revision;}};
+
+        // Changes whenever the text, cursor or selection changes
+        inline uint32_t get_revision(){return revision;}
 
 
 };
@@ -0,0 +1,88 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "definitions.h"
+#include "Armature.h"
+
+/*
+ * Reports the memory saved by compressing the animations of armatures, and the largest pose error it causes.
+ * Each animation is sampled at a fine step, local errors are per channel, joint errors are the
+ * distance between joint positions after the whole hierarchy is posed.
+ * Usage: animation_report [armature names], defaults to the shipped armatures
+ */
+
+static const float SAMPLE_STEP = 1.0f / 120;
+
+// Angle in radians of the rotation between a and b
+static float rot_error( versor a, versor b ) {
+    versor inv, r;
+    glm_quat_conjugate( a, inv );
+    glm_quat_mul( inv, b, r );
+    return 2 * atan2f( sqrtf( r[0] * r[0] + r[1] * r[1] + r[2] * r[2] ), fabsf( r[3] ) );
+}
+
+int main( int argc, char **argv ) {
+    std::vector<std::string> names;
+
+    for( int i = 1; i < argc; ++i )
+        names.push_back( argv[i] );
+
+    if( names.empty() )
+        names = { "Ahura", "Mongoz" };
+
+    for( const std::string &name : names ) {
+        ArmatureInfo raw, packed;
+
+        if( !raw.load( name, false ) || !packed.load( name, true ) )
+            continue;
+
+        Armature raw_pose, packed_pose;
+        raw_pose.assign_info( &raw );
+        packed_pose.assign_info( &packed );
+
+        float max_pos = 0, max_rot = 0, max_joint = 0;
+        uint32_t raw_keys = 0, packed_keys = 0;
+
+        for( uint8_t id = 1; id < raw.get_animation_count(); ++id ) {
+            const Animation &a = raw.get_animation( id );
+            const Animation &b = packed.get_animation( id );
+
+            for( uint32_t c = 0; c < a.channels.size(); ++c ) {
+                raw_keys += a.channels[c].pos_times.size() + a.channels[c].rot_times.size();
+                packed_keys += b.channels[c].pos_times.size() + b.channels[c].rot_times.size();
+            }
+
+            for( float t = 0; t <= a.duration; t += SAMPLE_STEP ) {
+                for( uint32_t c = 0; c < a.channels.size(); ++c ) {
+                    vec3 pa = GLM_VEC3_ZERO_INIT, pb = GLM_VEC3_ZERO_INIT;
+                    versor ra = GLM_QUAT_IDENTITY_INIT, rb = GLM_QUAT_IDENTITY_INIT;
+                    a.channels[c].value_pos( t, pa );
+                    b.channels[c].value_pos( t, pb );
+                    a.channels[c].value_rot( t, ra );
+                    b.channels[c].value_rot( t, rb );
+
+                    max_pos = fmaxf( max_pos, glm_vec3_distance( pa, pb ) );
+                    max_rot = fmaxf( max_rot, rot_error( ra, rb ) );
+                }
+
+                a.pose_set( raw_pose, t );
+                b.pose_set( packed_pose, t );
+                raw_pose.update( 0 );
+                packed_pose.update( 0 );
+
+                for( uint32_t j = 0; j < raw_pose.joints.size(); ++j )
+                    max_joint = fmaxf( max_joint, glm_vec3_distance( raw_pose.joints[j].tr[3], packed_pose.joints[j].tr[3] ) );
+            }
+        }
+
+        uint64_t raw_size = raw.get_animation_memory(), packed_size = packed.get_animation_memory();
+        printf( "%s: %u animations, %u -> %u keys, %.1f KB -> %.1f KB (%.0f%% saved)\n",
+                name.c_str(), raw.get_animation_count() - 1, raw_keys, packed_keys,
+                raw_size / 1024.0, packed_size / 1024.0, raw_size ? 100.0 * ( raw_size - packed_size ) / raw_size : 0.0 );
+        printf( "    max error: position %.6f, rotation %.4f degrees, joint %.6f\n", max_pos, glm_deg( max_rot ), max_joint );
+    }
+
+    fflush( stdout );
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "definitions.h"
+#include "Armature.h"
+#include "SoftbodySystem.h"
+
+/*
+ * Times sampling every channel of a long animation on a 150 joint armature each frame.
+ * Playback with cursors is compared against searching the keys from the start on every sample.
+ * A crowd of characters layering three animations measures whole poses per second.
+ * Creating armatures from a loaded armature info measures the cost of a new instance.
+ * Updating the joint transforms is compared against building each joint matrix separately at 30, 80 and 150 joints.
+ * A softbody chain dragged and released is run at several frame rates, the tip should be in the same place at each.
+ * A crowd with softbody hair is stepped a chain at a time within each armature, then together in one and in several threads.
+ * Usage: armature_bench [seconds] [keys per second] [armature name]
+ */
+
+static const uint32_t FRAMES_PER_SECOND = 60;
+
+// The search used before cursors, scanning every key from the start
+static void sample_linear( Animation &anim, Armature &a, float t ) {
+    for( AnimChannel &c : anim.channels ) {
+        uint32_t k = c.pos_times.size();
+        for( uint32_t i = 0; i < c.pos_times.size(); ++i ) {
+            if( c.pos_times[i] > t ) {
+                k = i;
+                break;
+            }
+        }
+        if( k > 0 && k < c.pos_times.size() )
+            glm_vec3_lerp( c.pos_key( k - 1 ), c.pos_key( k ), ( t - c.pos_times[k - 1] ) / ( c.pos_times[k] - c.pos_times[k - 1] ), a.joints[c.joint].pos );
+
+        k = c.rot_times.size();
+        for( uint32_t i = 0; i < c.rot_times.size(); ++i ) {
+            if( c.rot_times[i] > t ) {
+                k = i;
+                break;
+            }
+        }
+        if( k > 0 && k < c.rot_times.size() )
+            glm_quat_nlerp( c.rot_key( k - 1 ), c.rot_key( k ), ( t - c.rot_times[k - 1] ) / ( c.rot_times[k] - c.rot_times[k - 1] ), a.joints[c.joint].rot );
+    }
+}
+
+// The update used before batching, each joint is built, multiplied and placed in the palette separately
+static void update_per_joint( Armature &a ) {
+    const ArmatureInfo *info = a.get_info();
+
+    for( uint32_t i = 1; i < a.joints.size(); ++i ) {
+        Joint &j = a.joints[i];
+        glm_translate_make( j.tr, j.pos );
+        glm_quat_rotate( j.tr, j.rot, j.tr );
+        glm_mul( a.joints[info->get_joint( i ).parent].tr, j.tr, j.tr );
+    }
+
+    for( uint32_t i = 0; i < a.joints.size(); ++i )
+        glm_mat4_mul( a.joints[i].tr, (vec4 *)info->get_joint( i ).tr_inverse_rest, a.transform_buffer[i] );
+}
+
+// Position of the last joint of a softbody chain while it swings, after its root is dragged for a second and released
+static void softbody_tip( uint32_t fps, float timestep, vec3 tip ) {
+    ArmatureInfo info;
+    vec3 pos = {0, 0.1f, 0};
+    versor rot, bend;
+    glm_quat_identity( rot );
+    glm_quat( bend, 0.3f, 0, 0, 1 );
+
+    info.add_joint( "root", 0, pos, rot );
+    info.add_joint( "base", 0, pos, rot );
+    for( uint32_t i = 2; i < 8; ++i )
+        info.add_joint( "link" + std::to_string( i ), i - 1, pos, bend );
+
+    Armature a;
+    a.assign_info( &info );
+    a.constraint_clock.timestep = timestep;
+
+    SoftbodySettings settings;
+    for( uint32_t i = 2; i < 8; ++i )
+        a.constraint_softbody( i, settings );
+
+    uint32_t frames = fps * 3 / 2;
+    for( uint32_t f = 0; f <= frames; ++f ) {
+        float t = std::min( (float)f / fps, 1.0f );
+        glm_mat4_identity( a.get_root().tr );
+        a.get_root().tr[3][0] = t;
+        a.update( f == 0 ? 0 : 1.0f / fps );
+    }
+
+    glm_vec3_copy( a.joints.back().tr[3], tip );
+}
+
+int main( int argc, char **argv ) {
+    float seconds = argc > 1 ? atof( argv[1] ) : 60;
+    uint32_t keys_per_second = argc > 2 ? atoi( argv[2] ) : 30;
+    uint32_t key_count = seconds * keys_per_second + 1;
+    uint32_t frame_count = seconds * FRAMES_PER_SECOND;
+
+    // Every joint is animated with evenly spaced keys
+    Armature armature;
+    armature.joints.resize( ARMATURE_MAX_JOINTS );
+
+    vec3 axis = {0, 0, 1};
+    Animation anim;
+    anim.duration = seconds;
+    anim.channels.resize( ARMATURE_MAX_JOINTS );
+
+    for( uint32_t j = 0; j < ARMATURE_MAX_JOINTS; ++j ) {
+        AnimChannel &c = anim.channels[j];
+        c.joint = j;
+        c.pos_times.resize( key_count );
+        c.pos_values.resize( key_count * 3, 0 );
+        c.rot_times.resize( key_count );
+        c.rot_values.resize( key_count * 4 );
+
+        for( uint32_t k = 0; k < key_count; ++k ) {
+            float t = (float)k / keys_per_second;
+            c.pos_times[k] = t;
+            c.pos_key( k )[0] = t;
+            c.rot_times[k] = t;
+            glm_quatv( c.rot_key( k ), t, axis );
+        }
+    }
+
+    printf( "%u joints, %.0f s clip, %u keys per channel, %u frames\n", ARMATURE_MAX_JOINTS, seconds, key_count, frame_count );
+
+    std::vector<AnimCursor> cursors( anim.channels.size() );
+    auto time_frames = [&]( const char *label, auto sample ) {
+        auto start_time = std::chrono::steady_clock::now();
+        for( uint32_t f = 0; f < frame_count; ++f )
+            sample( (float)f / FRAMES_PER_SECOND );
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        printf( "%-14s %8.1f ms, %6.2f us per frame\n", label, elapsed.count() * 1000, elapsed.count() * 1e6 / frame_count );
+    };
+
+    time_frames( "cursor", [&]( float t ) { anim.pose_set( armature, t, cursors.data() ); } );
+    time_frames( "binary search", [&]( float t ) { anim.pose_set( armature, t ); } );
+    time_frames( "linear scan", [&]( float t ) { sample_linear( anim, armature, t ); } );
+
+    // Seeking to random times, every sample falls back to a binary search
+    srand( 1 );
+    time_frames( "cursor seeking", [&]( float ) { anim.pose_set( armature, seconds * rand() / RAND_MAX, cursors.data() ); } );
+
+    // A crowd of characters each layering a set, a mix and an additive animation
+    uint32_t crowd = 100;
+    std::vector<Armature> characters( crowd );
+    std::vector<std::vector<AnimCursor>> crowd_cursors( crowd * 3, std::vector<AnimCursor>( anim.channels.size() ) );
+
+    for( Armature &c : characters )
+        c.joints.resize( ARMATURE_MAX_JOINTS );
+
+    uint32_t crowd_frames = std::min( frame_count, 600u );
+    auto start_time = std::chrono::steady_clock::now();
+
+    for( uint32_t f = 0; f < crowd_frames; ++f ) {
+        float t = (float)f / FRAMES_PER_SECOND;
+
+        for( uint32_t i = 0; i < crowd; ++i ) {
+            anim.pose_set( characters[i], t, crowd_cursors[i * 3].data() );
+            anim.pose_mix( characters[i], t * 0.5f, 0.5f, crowd_cursors[i * 3 + 1].data() );
+            anim.pose_add( characters[i], t * 0.25f, 0.3f, crowd_cursors[i * 3 + 2].data() );
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    printf( "crowd of %u, set + mix + add: %.0f poses per second\n", crowd, crowd * crowd_frames / elapsed.count() );
+
+    // Branching armatures posed away from their rest pose
+    for( uint32_t joint_count : { 30, 80, 150 } ) {
+        ArmatureInfo info;
+
+        for( uint32_t i = 0; i < joint_count; ++i ) {
+            vec3 pos = {0, 0.1f, 0};
+            versor rot;
+            glm_quatv( rot, 0.1f * i, axis );
+            info.add_joint( "joint" + std::to_string( i ), i / 2, pos, rot );
+        }
+
+        Armature a;
+        a.assign_info( &info );
+
+        for( uint32_t i = 0; i < joint_count; ++i )
+            glm_quatv( a.joints[i].rot, 0.3f * i, axis );
+
+        uint32_t updates = 20000;
+        double seconds_batched, seconds_per_joint;
+
+        start_time = std::chrono::steady_clock::now();
+        for( uint32_t u = 0; u < updates; ++u ) {
+            a.mark_changed();
+            a.update( 0 );
+        }
+        elapsed = std::chrono::steady_clock::now() - start_time;
+        seconds_batched = elapsed.count();
+
+        start_time = std::chrono::steady_clock::now();
+        for( uint32_t u = 0; u < updates; ++u )
+            update_per_joint( a );
+        elapsed = std::chrono::steady_clock::now() - start_time;
+        seconds_per_joint = elapsed.count();
+
+        // An idle armature keeps its transform buffer
+        start_time = std::chrono::steady_clock::now();
+        for( uint32_t u = 0; u < updates; ++u )
+            a.update( 0 );
+        elapsed = std::chrono::steady_clock::now() - start_time;
+
+        printf( "update %3u joints: batched %6.2f us, per joint %6.2f us, idle %6.3f us\n", joint_count,
+                seconds_batched * 1e6 / updates, seconds_per_joint * 1e6 / updates, elapsed.count() * 1e6 / updates );
+    }
+
+    // Stepping once per frame moves the chain differently at each frame rate, fixed substeps do not
+    for( int fixed = 1; fixed >= 0; --fixed ) {
+        vec3 reference, tip;
+        float max_difference = 0;
+        softbody_tip( 30, fixed ? ARMATURE_CONSTRAINT_TIMESTEP : 1.0f / 30, reference );
+
+        for( uint32_t fps : { 60, 144 } ) {
+            softbody_tip( fps, fixed ? ARMATURE_CONSTRAINT_TIMESTEP : 1.0f / fps, tip );
+            max_difference = std::max( max_difference, glm_vec3_distance( reference, tip ) );
+        }
+
+        printf( "softbody tip at 30, 60 and 144 fps, %s: largest difference %.6f\n", fixed ? "fixed substeps" : "one step per frame", max_difference );
+    }
+
+    // Characters with 4 hair chains of 6 joints each, swaying at different speeds
+    ArmatureInfo hair_info;
+    versor identity, bend;
+    glm_quat_identity( identity );
+    glm_quat( bend, 0.2f, 0, 0, 1 );
+    vec3 offset = {0, 0.1f, 0};
+
+    hair_info.add_joint( "root", 0, offset, identity );
+    hair_info.add_joint( "head", 0, offset, identity );
+    for( uint32_t c = 0; c < 4; ++c ) {
+        for( uint32_t i = 0; i < 6; ++i )
+            hair_info.add_joint( "hair" + std::to_string( c * 6 + i ), i == 0 ? 1 : hair_info.get_aramture().joints.size() - 1, offset, bend );
+    }
+
+    uint32_t hair_count = 128;
+    uint32_t hair_frames = 300;
+    std::vector<Armature> heads( hair_count );
+    SoftbodySettings settings;
+
+    for( Armature &h : heads ) {
+        h.assign_info( &hair_info );
+        for( uint32_t j = 2; j < h.joints.size(); ++j )
+            h.constraint_softbody( j, settings );
+    }
+
+    SoftbodySystem system;
+    uint32_t chain_count = hair_count * 4;
+
+    auto time_hair = [&]( const char *label, bool batched, uint32_t threads ) {
+        system.thread_count = threads;
+        auto start = std::chrono::steady_clock::now();
+
+        for( uint32_t f = 0; f < hair_frames; ++f ) {
+            system.clear();
+
+            for( uint32_t i = 0; i < hair_count; ++i ) {
+                Armature &h = heads[i];
+                h.batch_softbodies = batched;
+                glm_mat4_identity( h.get_root().tr );
+                h.get_root().tr[3][0] = sinf( f * ( 0.05f + i * 0.001f ) );
+                h.update( 1.0f / FRAMES_PER_SECOND );
+                if( batched )
+                    system.add( h );
+            }
+
+            if( batched ) {
+                system.solve();
+                for( Armature &h : heads )
+                    h.update_softbodies();
+            }
+        }
+
+        std::chrono::duration<double> e = std::chrono::steady_clock::now() - start;
+        printf( "%u chains, %-26s %8.0f chain updates per ms\n", chain_count, label, chain_count * hair_frames / ( e.count() * 1000 ) );
+    };
+
+    time_hair( "each armature alone:", false, 1 );
+    time_hair( "batched, 1 thread:", true, 1 );
+    time_hair( "batched, every core:", true, 0 );
+
+    // Instances share the joint names, hierarchy and animations of the info, only the pose is copied
+    ArmatureInfo info;
+    if( info.load( argc > 3 ? argv[3] : "Mongoz" ) ) {
+        uint32_t instance_count = 10000;
+        std::vector<Armature> instances( instance_count );
+
+        start_time = std::chrono::steady_clock::now();
+        for( Armature &a : instances )
+            a.assign_info( &info );
+        elapsed = std::chrono::steady_clock::now() - start_time;
+
+        printf( "%u joint armature: %.2f us per instance\n", (uint32_t)info.get_aramture().joints.size(), elapsed.count() * 1e6 / instance_count );
+    }
+
+    fflush( stdout );
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "definitions.h"
+#include "ImageDecode.h"
+#include "ThreadPool.h"
+
+/*
+ * Times decoding N 2048x2048 layers into a single upload buffer at 1, 4 and 8 threads.
+ * Each layer decodes the same png from the textures directory, cropped or padded to the layer size.
+ * Usage: texture_bench [layers] [image name] [premultiply]
+ */
+
+static const uint32_t LAYER_SIZE = 2048;
+static const uint32_t RUNS = 3;
+
+int main( int argc, char **argv ) {
+    uint32_t layer_count = argc > 1 ? atoi( argv[1] ) : 16;
+    std::string name = argc > 2 ? argv[2] : "ahura";
+    bool premultiplied = argc > 3 && atoi( argv[3] );
+    std::string filepath = (std::string)DIR_TEXTURES + name + ".png";
+
+    ImageDecode::ImageInfo info = ImageDecode::read_info( filepath );
+
+    if( !info.valid || layer_count == 0 ) {
+        printf( "Unable to read %s\n", filepath.c_str() );
+        return EXIT_FAILURE;
+    }
+
+    printf( "%u layers of %ux%u from %s (%ux%u, %u channels), hardware threads %u\n",
+            layer_count, LAYER_SIZE, LAYER_SIZE, name.c_str(), info.width, info.height, info.channels, ThreadPool::default_threads() );
+
+    uint64_t layer_bytes = (uint64_t)LAYER_SIZE * LAYER_SIZE * 4;
+    std::vector<uint8_t> pixels( layer_bytes * layer_count );
+    uint32_t copy_width = std::min( info.width, LAYER_SIZE ), copy_height = std::min( info.height, LAYER_SIZE );
+
+    for( uint32_t thread_count : { 1u, 4u, 8u } ) {
+        double best = 1e30;
+
+        for( uint32_t run = 0; run < RUNS; ++run ) {
+            auto start_time = std::chrono::steady_clock::now();
+
+            ThreadPool::parallel_for( layer_count, thread_count, [&]( uint32_t i ) {
+                std::vector<uint8_t> image( (uint64_t)info.width * info.height * 4 );
+
+                if( !ImageDecode::decode_png( filepath, info.width, info.height, image.data(), premultiplied, false ) )
+                    return;
+
+                uint8_t *layer = pixels.data() + layer_bytes * i;
+                for( uint32_t y = 0; y < copy_height; ++y )
+                    memcpy( layer + (uint64_t)y * LAYER_SIZE * 4, image.data() + (uint64_t)y * info.width * 4, copy_width * 4 );
+            } );
+
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+            best = std::min( best, elapsed.count() );
+        }
+
+        printf( "%u threads: %.1f ms, %.1f ms per layer\n", thread_count, best * 1000, best * 1000 / layer_count );
+    }
+
+    fflush( stdout );
+    return 0;
+}